@@ -4,16 +4,23 @@ DEFINE_string(mount_templat, "", "mount templat");
 DEFINE_string(mount_cgroups, "", "mount templat");
 
 DEFINE_string(cgroup_root_path, "/cgroups", "cgroup root path");
+DEFINE_bool(cgroup_v2, false, "use the cgroup v2 hierarchy mounted at <cgroup_root_path>/unified instead of v1 subsystems");
+DEFINE_string(cgroup_io_devices, "", "devices io.max of cgroup v2 applies to, eg: 8:0,8:16");
 DEFINE_string(galaxy_root_path, "", "galaxy work path");
 
 DEFINE_string(nexus_root_path, "", "root path on nexus");
 DEFINE_string(master_path, "", "master path");
+DEFINE_string(appmaster_path, "", "appmaster path, fetches of appworkers are not relayed when empty");
 DEFINE_string(nexus_servers, "", "servers of nexus cluster");
 
 DEFINE_string(agent_ip, "", "agent ip");
 DEFINE_string(agent_port, "1646", "agent listen port");
 DEFINE_string(agent_hostname, "hostname", "agent hostname");
 DEFINE_int32(keepalive_interval, 5000, "keep alive with RM");
+DEFINE_int32(fetch_relay_interval, 500, "interval of relaying fetches of the pods to appmaster in one rpc, in ms");
+DEFINE_int32(fetch_relay_timeout, 5, "timeout of the relayed fetches, in second");
+DEFINE_string(agent_snapshot_file, "agent.snapshot", "state handed to the new binary on hot upgrade");
+DEFINE_int32(agent_upgrade_wait, 30000, "max wait for the containers being created or released before a hot upgrade, in ms");
 
 DEFINE_string(volum_resource, "", "volum resource, \
             format: filesystem:size_in_byte:mediu(DISK:SSD):mount_point, seperated by comma");
@@ -21,6 +28,8 @@ DEFINE_string(extra_volum_resource, "", "extra volum resource, \
             format: filesystem:size_in_byte:mediu(DISK:SSD):mount_point, seperated by comma");
 DEFINE_int64(cpu_resource, 0L, "max millicores galaxy can use");
 DEFINE_int64(memory_resource, 0L, "max memory(unit:byte) galaxy can use");
+DEFINE_string(cpuset_exclusive_cores, "", "cores can be dedicated to exclusive cpu cgroups, eg: 8-15,24-31; \
+            empty means cpuset is not managed");
 
 DEFINE_string(cmd_line, "", "just for debu");
 DEFINE_int64(gc_delay_time, 43200, "");
@@ -31,4 +40,14 @@ DEFINE_string(v2_prefix, "/home/baidulinux/V2", "v2 prefix");
 
 DEFINE_int32(assign_level, 2, "assign level: {0, 1, 2, 3}");
 DEFINE_int32(check_assign_interval, 5000, "check assign interval");
+DEFINE_double(evict_memory_pressure, 0.0, "evict best effort containers when host memory some avg10 exceeds it, 0 disables");
+DEFINE_double(evict_cpu_pressure, 0.0, "evict best effort containers when host cpu some avg10 exceeds it, 0 disables");
+DEFINE_int32(pressure_collect_cycle, 5, "collect cycle of host pressure in second");
+DEFINE_int32(metrics_sample_interval, 5, "interval of sampling container metrics into the history in second, 0 disables the history");
+DEFINE_int32(metrics_ring_size, 720, "samples kept for each container");
+DEFINE_int32(metrics_max_series, 256, "containers whose history is kept, the least recently sampled one goes first");
+DEFINE_int32(container_op_threads, 8, "threads creating and releasing containers, one container takes one at a time");
+DEFINE_int32(warm_pool_max, 0, "max prebuilt cgroup and root skeletons for new containers, 0 disables the pool");
+DEFINE_int32(warm_pool_refill_interval, 1000, "refill interval of the warm pool in ms");
+DEFINE_int32(warm_pool_demand_window, 60, "refill intervals whose peak creates size the warm pool");
 
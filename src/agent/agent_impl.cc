@@ -9,12 +9,17 @@
 #include "cgroup/subsystem_factory.h"
 #include "collector/collector_engine.h"
 #include "util/path_tree.h"
+#include "log_utils.h"
 
 #include <string>
 #include <sstream>
 #include <stdlib.h>
 #include <time.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 //#include <sys/utsname.h>
 #include <gflags/gflags.h>
 #include <boost/bind.hpp>
@@ -24,6 +29,8 @@ DECLARE_string(agent_ip);
 DECLARE_string(agent_port);
 DECLARE_int32(keepalive_interval);
 DECLARE_string(galaxy_root_path);
+DECLARE_string(agent_snapshot_file);
+DECLARE_int32(agent_upgrade_wait);
 
 namespace baidu {
 namespace galaxy {
@@ -37,6 +44,7 @@ AgentImpl::AgentImpl() :
     running_(false),
     rm_(new baidu::galaxy::resource::ResourceManager),
     cm_(new baidu::galaxy::container::ContainerManager(rm_)),
+    op_queue_(new baidu::galaxy::container::OperationQueue(cm_)),
     health_checker_(new baidu::galaxy::health::HealthChecker()),
     start_time_(baidu::common::timer::get_micros())
 {
@@ -71,7 +79,7 @@ void AgentImpl::HandleMasterChange(const std::string& new_master_endpoint)
     }
 }
 
-void AgentImpl::Setup()
+void AgentImpl::Setup(bool is_upgrade)
 {
 
     baidu::galaxy::path::SetRootPath(FLAGS_galaxy_root_path);
@@ -83,7 +91,13 @@ void AgentImpl::Setup()
 
     baidu::galaxy::cgroup::SubsystemFactory::GetInstance()->Setup();
     baidu::galaxy::container::ContainerStatus::Setup();
-    cm_->Setup();
+
+    boost::scoped_ptr<baidu::galaxy::proto::AgentSnapshot> snapshot;
+    if (is_upgrade) {
+        snapshot.reset(LoadSnapshot());
+    }
+    cm_->Setup(snapshot.get());
+    op_queue_->Setup();
 
     health_checker_->LoadVolum(rm_);
     health_checker_->LoadCgroup(baidu::galaxy::cgroup::SubsystemFactory::GetInstance());
@@ -102,6 +116,67 @@ void AgentImpl::Setup()
     LOG(INFO) << "start keep alive thread, interval is " << FLAGS_keepalive_interval << "ms";
 }
 
+bool AgentImpl::Dump()
+{
+    LOG(WARNING) << "agent dump for upgrading start";
+    if (!cm_->Pause(FLAGS_agent_upgrade_wait)) {
+        LOG(WARNING) << "containers are still being created or released after "
+                     << FLAGS_agent_upgrade_wait << "ms, give up upgrading";
+        return false;
+    }
+
+    baidu::galaxy::proto::AgentSnapshot snapshot;
+    snapshot.set_dump_time(baidu::common::timer::get_micros());
+    snapshot.set_start_time(start_time_);
+    cm_->Dump(&snapshot);
+
+    // the new binary never sees half a snapshot
+    std::string tmp_file = FLAGS_agent_snapshot_file + ".tmp";
+    int fd = open(tmp_file.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    bool ret = fd >= 0 && snapshot.SerializeToFileDescriptor(fd) && 0 == fsync(fd);
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    if (!ret || 0 != rename(tmp_file.c_str(), FLAGS_agent_snapshot_file.c_str())) {
+        LOG(WARNING) << "agent snapshot file write failed: " << strerror(errno);
+        cm_->Resume();
+        return false;
+    }
+
+    LOG(WARNING) << "agent dumped " << snapshot.containers_size() << " containers for upgrading ok";
+    return true;
+}
+
+void AgentImpl::Resume()
+{
+    cm_->Resume();
+}
+
+baidu::galaxy::proto::AgentSnapshot* AgentImpl::LoadSnapshot()
+{
+    baidu::galaxy::proto::AgentSnapshot* snapshot = new baidu::galaxy::proto::AgentSnapshot();
+    int fd = open(FLAGS_agent_snapshot_file.c_str(), O_RDONLY);
+    bool ok = fd >= 0 && snapshot->ParseFromFileDescriptor(fd);
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    if (!ok) {
+        LOG(WARNING) << "agent snapshot file " << FLAGS_agent_snapshot_file
+                     << " load failed, reload containers from meta";
+        delete snapshot;
+        return NULL;
+    }
+
+    // a later restart must not take containers over from a stale one
+    unlink(FLAGS_agent_snapshot_file.c_str());
+    start_time_ = snapshot->start_time();
+    LOG(WARNING) << "agent load snapshot of " << snapshot->containers_size() << " containers, dumped "
+                 << (baidu::common::timer::get_micros() - snapshot->dump_time()) / 1000 << "ms ago";
+    return snapshot;
+}
+
 void AgentImpl::KeepAlive(int internal_ms)
 {
     baidu::galaxy::proto::KeepAliveRequest request;
@@ -126,20 +201,19 @@ void AgentImpl::CreateContainer(::google::protobuf::RpcController* controller,
         ::baidu::galaxy::proto::CreateContainerResponse* response,
         ::google::protobuf::Closure* done)
 {
-    LOG(INFO) << "recv create container request: " << request->DebugString();
-    int64_t x = baidu::common::timer::get_micros();
-    std::cerr << x << "create " << request->id() << std::endl;
+    LOG(INFO) << "recv create container request: " << baidu::galaxy::ProtoDump(*request);
 
     baidu::galaxy::container::ContainerId id(request->container_group_id(), request->id());
     baidu::galaxy::proto::ErrorCode* ec = response->mutable_code();
 
-    baidu::galaxy::util::ErrorCode err = cm_->CreateContainer(id, request->container());
-    if (0 != err.Code()) {
+    int64_t op_id = op_queue_->Submit(id, baidu::galaxy::container::kOperationCreate, request->container());
+    if (op_id < 0) {
         ec->set_status(baidu::galaxy::proto::kError);
-        ec->set_reason(err.ShortMessage());
+        ec->set_reason("agent is not running");
     } else {
         ec->set_status(baidu::galaxy::proto::kOk);
         ec->set_reason("sucess");
+        response->set_operation_id(op_id);
     }
 
     done->Run();
@@ -151,18 +225,18 @@ void AgentImpl::RemoveContainer(::google::protobuf::RpcController* controller,
         ::google::protobuf::Closure* done)
 {
 
-    LOG(INFO) << "recv remove container request: " << request->DebugString();
-    std::cerr << "recv remove container request: " << request->DebugString() << std::endl;
+    LOG(INFO) << "recv remove container request: " << baidu::galaxy::ProtoDump(*request);
     baidu::galaxy::container::ContainerId id(request->container_group_id(), request->id());
     baidu::galaxy::proto::ErrorCode* ec = response->mutable_code();
-    baidu::galaxy::util::ErrorCode ret = cm_->ReleaseContainer(id);
+    int64_t op_id = op_queue_->Submit(id, baidu::galaxy::container::kOperationRelease);
 
-    if (0 != ret.Code()) {
+    if (op_id < 0) {
         ec->set_status(baidu::galaxy::proto::kError);
-        ec->set_reason(ret.ShortMessage());
+        ec->set_reason("agent is not running");
     } else {
         ec->set_status(baidu::galaxy::proto::kOk);
         ec->set_reason("sucess");
+        response->set_operation_id(op_id);
     }
     done->Run();
 }
@@ -180,8 +254,6 @@ void AgentImpl::Query(::google::protobuf::RpcController* controller,
         ::google::protobuf::Closure* done)
 {
 
-    std::cerr << "query " << std::endl;
-
     baidu::galaxy::proto::AgentInfo* ai = response->mutable_agent_info();
     ai->set_unhealthy(!health_checker_->Healthy());
     ai->set_start_time(start_time_);
@@ -193,6 +265,7 @@ void AgentImpl::Query(::google::protobuf::RpcController* controller,
     }
     std::vector<boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> > cis;
     cm_->ListContainers(cis, full_report);
+    op_queue_->Overlay(cis, full_report);
 
     for (size_t i = 0; i < cis.size(); i++) {
         ai->add_container_info()->CopyFrom(*(cis[i]));
@@ -252,13 +325,33 @@ void AgentImpl::Query(::google::protobuf::RpcController* controller,
         }
     }
 
+    std::vector<boost::shared_ptr<baidu::galaxy::proto::NumaNodeResource> > nrs;
+    rm_->GetNumaResource(nrs);
+    for (size_t i = 0; i < nrs.size(); i++) {
+        ai->add_numa_nodes()->CopyFrom(*nrs[i]);
+    }
+
+    boost::shared_ptr<baidu::galaxy::proto::Pressure> pressure = cm_->HostPressure();
+    if (pressure->has_cpu_some()) {
+        ai->mutable_pressure()->CopyFrom(*pressure);
+    }
+
     baidu::galaxy::proto::ErrorCode* ec = response->mutable_code();
     ec->set_status(baidu::galaxy::proto::kOk);
-    std::cerr << response->DebugString() << std::endl;
-    VLOG(10) << "query:" << response->DebugString();
+    VLOG(10) << "query:" << baidu::galaxy::ProtoDump(*response);
     //std::cout << "query:" << response->DebugString() << std::endl;
     done->Run();
 }
 
+void AgentImpl::QueryMetrics(::google::protobuf::RpcController* controller,
+        const ::baidu::galaxy::proto::QueryMetricsRequest* request,
+        ::baidu::galaxy::proto::QueryMetricsResponse* response,
+        ::google::protobuf::Closure* done)
+{
+    cm_->QueryMetrics(*request, response);
+    response->mutable_code()->set_status(baidu::galaxy::proto::kOk);
+    done->Run();
+}
+
 }
 }
@@ -16,6 +16,7 @@
 #include "resource/resource_manager.h"
 #include "container/container.h"
 #include "container/container_manager.h"
+#include "container/operation_queue.h"
 #include "health/healthy_checker.h"
 
 namespace baidu {
@@ -31,7 +32,12 @@ public:
     AgentImpl();
     virtual ~AgentImpl();
 
-    void Setup();
+    // is_upgrade: takes over the containers from the snapshot left by Dump
+    void Setup(bool is_upgrade);
+    // hot upgrade: holds creating and releasing containers and writes the
+    // state to FLAGS_agent_snapshot_file, Resume if the new binary is not run
+    bool Dump();
+    void Resume();
 
     void CreateContainer(::google::protobuf::RpcController* controller,
             const ::baidu::galaxy::proto::CreateContainerRequest* request,
@@ -53,8 +59,14 @@ public:
             ::baidu::galaxy::proto::QueryResponse* response,
             ::google::protobuf::Closure* done);
 
+    void QueryMetrics(::google::protobuf::RpcController* controller,
+            const ::baidu::galaxy::proto::QueryMetricsRequest* request,
+            ::baidu::galaxy::proto::QueryMetricsResponse* response,
+            ::google::protobuf::Closure* done);
+
 private:
     void KeepAlive(int internal_ms);
+    baidu::galaxy::proto::AgentSnapshot* LoadSnapshot();
     void HandleMasterChange(const std::string& new_master_endpoint);
 
 private:
@@ -69,6 +81,7 @@ private:
 
     boost::shared_ptr<baidu::galaxy::resource::ResourceManager> rm_;
     boost::shared_ptr<baidu::galaxy::container::ContainerManager> cm_;
+    boost::shared_ptr<baidu::galaxy::container::OperationQueue> op_queue_;
     boost::shared_ptr<baidu::galaxy::health::HealthChecker> health_checker_;
     int64_t start_time_;
     std::string version_;
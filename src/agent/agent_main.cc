@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "agent_impl.h"
+#include "fetch_relay.h"
 #include "setting_utils.h"
 
 #include <sofa/pbrpc/pbrpc.h>
@@ -17,18 +18,76 @@
 #include <assert.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
 DECLARE_string(agent_port);
 
+extern char** environ;
+
 static volatile bool s_quit = false;
+static volatile bool s_upgrade = false;
 static void SignalIntHandler(int /*sig*/)
 {
     s_quit = true;
 }
 
+static void SignalHupHandler(int /*sig*/)
+{
+    s_upgrade = true;
+}
+
+// leveldb, log files and the like are opened again by the new binary
+static void SetCloseOnExec()
+{
+    DIR* dir = ::opendir("/proc/self/fd");
+    if (NULL == dir) {
+        return;
+    }
+
+    struct dirent* entry = NULL;
+    while (NULL != (entry = ::readdir(dir))) {
+        int fd = atoi(entry->d_name);
+        if (fd > STDERR_FILENO && fd != ::dirfd(dir)) {
+            ::fcntl(fd, F_SETFD, ::fcntl(fd, F_GETFD) | FD_CLOEXEC);
+        }
+    }
+    ::closedir(dir);
+}
+
+// runs the binary at the same path in place of this one, the containers are
+// taken over from the snapshot, returns only when it fails
+static void Upgrade(const std::vector<std::string>& args)
+{
+    std::vector<char*> argv;
+    for (size_t i = 0; i < args.size(); i++) {
+        argv.push_back(const_cast<char*>(args[i].c_str()));
+    }
+    argv.push_back(NULL);
+
+    // children cloned meanwhile must not see UPGRADE, so it is not setenv
+    std::string upgrade = "UPGRADE=1";
+    std::vector<char*> envp;
+    for (char** env = environ; NULL != *env; env++) {
+        if (0 != strncmp(*env, "UPGRADE=", 8)) {
+            envp.push_back(*env);
+        }
+    }
+    envp.push_back(const_cast<char*>(upgrade.c_str()));
+    envp.push_back(NULL);
+
+    google::FlushLogFiles(google::INFO);
+    SetCloseOnExec();
+    ::execve(argv[0], &argv[0], &envp[0]);
+}
+
 void SigChldHandler(int /*sig*/)
 {
     int status = 0;
@@ -44,10 +103,20 @@ int main(int argc, char* argv[])
 {
     // set umask
     //umask(22);
+    // flags are removed from argv by parsing, the new binary takes them again
+    std::vector<std::string> args(argv, argv + argc);
     google::ParseCommandLineFlags(&argc, &argv, true);
     google::InitGoogleLogging(argv[0]);
     baidu::galaxy::SetupLog("agent");
 
+    // new start or upgrade
+    bool is_upgrade = false;
+    char* c_upgrade = getenv("UPGRADE");
+    if (c_upgrade != NULL) {
+        is_upgrade = std::string(c_upgrade) == "1";
+        unsetenv("UPGRADE");
+    }
+
 
     baidu::galaxy::AgentImpl* agent = new baidu::galaxy::AgentImpl();
     sofa::pbrpc::RpcServerOptions options;
@@ -58,8 +127,15 @@ int main(int argc, char* argv[])
         exit(-1);
     }
 
+    baidu::galaxy::FetchRelay* fetch_relay = new baidu::galaxy::FetchRelay();
+    if (!rpc_server.RegisterService(static_cast<baidu::galaxy::proto::AppMaster*>(fetch_relay))) {
+        LOG(WARNING) << "failed to register fetch relay service";
+        exit(-1);
+    }
+
     std::string endpoint = "0.0.0.0:" + FLAGS_agent_port;
-    agent->Setup();
+    agent->Setup(is_upgrade);
+    fetch_relay->Setup();
 
     if (!rpc_server.Start(endpoint)) {
         LOG(WARNING) << "failed to start server on " << endpoint;
@@ -70,9 +146,32 @@ int main(int argc, char* argv[])
     signal(SIGINT, SignalIntHandler);
     signal(SIGTERM, SignalIntHandler);
     signal(SIGCHLD, SigChldHandler);
+    signal(SIGHUP, SignalHupHandler);
     LOG(INFO) << "agent started.";
 
     while (!s_quit) {
+        if (s_upgrade) {
+            s_upgrade = false;
+            LOG(WARNING) << "agent catch sig HUP, begin to upgrade";
+
+            if (0 != ::access(args[0].c_str(), X_OK)) {
+                LOG(WARNING) << "agent binary " << args[0] << " not exist";
+            } else if (agent->Dump()) {
+                // sofa-pbrpc cannot serve on an inherited socket, the new
+                // binary binds the port again once it takes the containers over
+                rpc_server.Stop();
+                Upgrade(args);
+                // if execve fail, give up upgrade
+                LOG(WARNING) << "agent exec " << args[0] << " failed: " << strerror(errno);
+                agent->Resume();
+
+                if (!rpc_server.Start(endpoint)) {
+                    LOG(WARNING) << "failed to restart server on " << endpoint;
+                    exit(-2);
+                }
+            }
+        }
+
         sleep(1);
     }
     _exit(0);
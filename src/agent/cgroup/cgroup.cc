@@ -6,12 +6,14 @@
 #include "subsystem_factory.h"
 #include "subsystem.h"
 #include "freezer_subsystem.h"
+#include "unified_subsystem.h"
 #include "protocol/galaxy.pb.h"
 #include "protocol/agent.pb.h"
 #include "subsystem.h"
 #include "collector/collector_engine.h"
 #include "cgroup_collector.h"
 #include <glog/logging.h>
+#include <boost/filesystem/operations.hpp>
 
 #include <unistd.h>
 
@@ -36,6 +38,14 @@ void Cgroup::SetDescrition(boost::shared_ptr<baidu::galaxy::proto::Cgroup> cgrou
 }
 
 baidu::galaxy::util::ErrorCode Cgroup::Construct() {
+    return Construct_(NULL);
+}
+
+baidu::galaxy::util::ErrorCode Cgroup::Restore(const baidu::galaxy::proto::CgroupMetrix& last) {
+    return Construct_(&last);
+}
+
+baidu::galaxy::util::ErrorCode Cgroup::Construct_(const baidu::galaxy::proto::CgroupMetrix* last) {
     assert(subsystem_.empty());
     std::vector<std::string> subsystems;
     factory_->GetSubsystems(subsystems);
@@ -56,6 +66,10 @@ baidu::galaxy::util::ErrorCode Cgroup::Construct() {
         if (subsystems[i] == "freezer") {
             freezer_ = boost::dynamic_pointer_cast<FreezerSubsystem>(ss);
             assert(NULL != freezer_.get());
+        } else if (subsystems[i] == "unified") {
+            unified_ = boost::dynamic_pointer_cast<UnifiedSubsystem>(ss);
+            assert(NULL != unified_.get());
+            subsystem_.push_back(ss);
         } else {
             if (subsystems[i] == "cpuacct") {
                 cpu_acct_ = ss;
@@ -66,6 +80,20 @@ baidu::galaxy::util::ErrorCode Cgroup::Construct() {
             subsystem_.push_back(ss);
         }
 
+        // the previous agent built it, only make sure it is still there
+        if (NULL != last) {
+            boost::system::error_code fs_ec;
+
+            if (!boost::filesystem::exists(ss->Path(), fs_ec)) {
+                LOG(WARNING) << "subsystem " << ss->Name() << " for cgroup " << ss->Path()
+                             << " is gone, cannot restore it";
+                ok = false;
+                break;
+            }
+
+            continue;
+        }
+
         baidu::galaxy::util::ErrorCode err = ss->Construct();
 
         if (0 != err.Code()) {
@@ -82,6 +110,14 @@ baidu::galaxy::util::ErrorCode Cgroup::Construct() {
                   << ") successfully for container " << container_id_;
     }
 
+    if (!ok && NULL != last) {
+        // processes of the container live in it, leave it to a reload
+        subsystem_.clear();
+        unified_.reset();
+        freezer_.reset();
+        return ERRORCODE(-1, "");
+    }
+
     if (!ok) {
         // destroy
         for (size_t i = 0; i < subsystem_.size(); i++) {
@@ -89,6 +125,7 @@ baidu::galaxy::util::ErrorCode Cgroup::Construct() {
         }
 
         subsystem_.clear();
+        unified_.reset();
 
         if (NULL != freezer_.get()) {
             freezer_->Destroy();
@@ -99,8 +136,28 @@ baidu::galaxy::util::ErrorCode Cgroup::Construct() {
     }
 
     collector_.reset(new CgroupCollector());
-    collector_->SetCpuacctPath(cpu_acct_->Path() + "/cpuacct.stat");
-    collector_->SetMemoryPath(memory_->Path() + "/memory.usage_in_bytes");
+    if (NULL != unified_.get()) {
+        collector_->SetCpuStatPath(unified_->Path() + "/cpu.stat");
+        collector_->SetMemoryPath(unified_->Path() + "/memory.current");
+        collector_->SetIoStatPath(unified_->Path() + "/io.stat");
+        collector_->SetPressureDir(unified_->Path());
+    } else {
+        collector_->SetCpuacctPath(cpu_acct_->Path() + "/cpuacct.stat");
+        collector_->SetMemoryPath(memory_->Path() + "/memory.usage_in_bytes");
+
+        for (size_t i = 0; i < subsystem_.size(); i++) {
+            if ("blkio" == subsystem_[i]->Name()) {
+                collector_->SetIoStatPath(subsystem_[i]->Path() + "/blkio.throttle.io_service_bytes");
+            }
+        }
+
+        // kernels supporting psi on cgroup v1 expose the files in cpuacct
+        collector_->SetPressureDir(cpu_acct_->Path());
+    }
+    if (NULL != last) {
+        collector_->Restore(*last);
+    }
+
     collector_->SetCycle(5);
     collector_->SetName(container_id_ + "_cgroup");
     collector_->Enable(true);
@@ -122,6 +179,21 @@ baidu::galaxy::util::ErrorCode Cgroup::Destroy() {
         return ERRORCODE_OK;
     }
 
+    // v2 kills and removes in the single directory
+    if (NULL != unified_.get()) {
+        baidu::galaxy::util::ErrorCode ec = unified_->Destroy();
+
+        if (0 != ec.Code()) {
+            return ERRORCODE(-1, "failed in destroying %s: %s",
+                    unified_->Name().c_str(),
+                    ec.Message().c_str());
+        }
+
+        subsystem_.clear();
+        unified_.reset();
+        return ERRORCODE_OK;
+    }
+
     if (freezer_.get() != NULL) {
         baidu::galaxy::util::ErrorCode err = freezer_->Freeze();
 
@@ -194,7 +266,7 @@ void Cgroup::ExportEnv(std::map<std::string, std::string>& env) {
         env[ss.str()] = subsystem_[i]->Path();
     }
 
-    {
+    if (NULL != freezer_.get()) {
         std::stringstream ss;
         ss << "baidu_galaxy_container_" << cgroup_->id() << "_" << freezer_->Name() << "_path";
         env[ss.str()] = freezer_->Path();
@@ -221,6 +293,14 @@ void Cgroup::ExportEnv(std::map<std::string, std::string>& env) {
     env[ss.str()] = port_names;
 }
 
+void Cgroup::Detach() {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    if (collector_.get() != NULL) {
+        collector_->Enable(false);
+    }
+}
+
 std::string Cgroup::Id() {
     return cgroup_->id();
 }
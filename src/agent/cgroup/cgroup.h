@@ -22,6 +22,7 @@ class CgroupMetrix;
 
 namespace cgroup {
 class FreezerSubsystem;
+class UnifiedSubsystem;
 class Subsystem;
 class SubsystemFactory;
 class CgroupCollector;
@@ -34,15 +35,23 @@ public:
     void SetDescrition(boost::shared_ptr<baidu::galaxy::proto::Cgroup> cgroup);
 
     baidu::galaxy::util::ErrorCode Construct();
+    // attaches to the cgroup left by the agent before a hot upgrade, nothing
+    // is written to the kernel, last is the sample it collected
+    baidu::galaxy::util::ErrorCode Restore(const baidu::galaxy::proto::CgroupMetrix& last);
     baidu::galaxy::util::ErrorCode Destroy();
+    // stops collecting, the cgroup is left in the kernel
+    void Detach();
     void ExportEnv(std::map<std::string, std::string>& evn);
     std::string Id();
 
     baidu::galaxy::util::ErrorCode Collect(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix);
     boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> Statistics(); // call by container
 private:
+    baidu::galaxy::util::ErrorCode Construct_(const baidu::galaxy::proto::CgroupMetrix* last);
+
     std::vector<boost::shared_ptr<Subsystem> > subsystem_;
     boost::shared_ptr<FreezerSubsystem> freezer_;
+    boost::shared_ptr<UnifiedSubsystem> unified_;
     boost::shared_ptr<Subsystem> cpu_acct_;
     boost::shared_ptr<Subsystem> memory_;
 
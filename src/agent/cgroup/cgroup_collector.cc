@@ -6,15 +6,18 @@
 #include "protocol/agent.pb.h"
 #include "util/input_stream_file.h"
 #include "cgroup.h"
+#include "collector/pressure_collector.h"
 #include "timer.h"
 #include "boost/algorithm/string/predicate.hpp"
 #include <assert.h>
+#include <string.h>
 
 namespace baidu {
 namespace galaxy {
 namespace cgroup {
 
 const static long CPU_CORES = sysconf(_SC_NPROCESSORS_CONF);
+const static long CLOCK_TICKS = sysconf(_SC_CLK_TCK);
 CgroupCollector::CgroupCollector() :
     enabled_(false),
     cycle_(-1),
@@ -48,12 +51,22 @@ baidu::galaxy::util::ErrorCode CgroupCollector::Collect() {
         return ERRORCODE(-1, "%s", ec.Message().c_str());
     }
 
+    // io counters are optional, blkio may be absent
+    if (!io_stat_path_.empty()) {
+        IoStat(metrix2);
+    }
+
     // cal cpu
     boost::mutex::scoped_lock lock(mutex_);
     metrix_.reset(new baidu::galaxy::proto::CgroupMetrix());
     last_time_ = baidu::common::timer::get_micros();
     metrix_->set_memory_used_in_byte(metrix2->memory_used_in_byte());
 
+    if (metrix2->has_io_read_bytes()) {
+        metrix_->set_io_read_bytes(metrix2->io_read_bytes());
+        metrix_->set_io_write_bytes(metrix2->io_write_bytes());
+    }
+
     if (metrix1->has_container_cpu_time() && metrix1->has_system_cpu_time()
             && metrix2->has_container_cpu_time() && metrix2->has_system_cpu_time()) {
         double delta1 = (double)(metrix2->container_cpu_time() - metrix1->container_cpu_time());
@@ -65,6 +78,13 @@ baidu::galaxy::util::ErrorCode CgroupCollector::Collect() {
         }
     }
 
+    if (!pressure_dir_.empty()) {
+        baidu::galaxy::proto::Pressure pressure;
+        if (0 == baidu::galaxy::collector::ReadPressure(pressure_dir_, ".pressure", &pressure).Code()) {
+            metrix_->mutable_pressure()->CopyFrom(pressure);
+        }
+    }
+
     return ERRORCODE_OK;
 }
 
@@ -136,9 +156,18 @@ boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> CgroupCollector::Statistic
     return ret;
 }
 
+void CgroupCollector::Restore(const baidu::galaxy::proto::CgroupMetrix& metrix) {
+    boost::mutex::scoped_lock lock(mutex_);
+    metrix_->CopyFrom(metrix);
+}
+
 baidu::galaxy::util::ErrorCode CgroupCollector::ContainerCpuStat(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix) {
     assert(NULL != metrix.get());
 
+    if (!cpu_stat_path_.empty()) {
+        return ContainerCpuStatV2(metrix);
+    }
+
     if (cpuacct_path_.empty()) {
         return ERRORCODE(-1, "empty path");
     }
@@ -183,6 +212,39 @@ baidu::galaxy::util::ErrorCode CgroupCollector::ContainerCpuStat(boost::shared_p
 }
 
 
+// usage_usec in cpu.stat is converted to clock ticks, the unit of /proc/stat
+baidu::galaxy::util::ErrorCode CgroupCollector::ContainerCpuStatV2(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix) {
+    baidu::galaxy::file::InputStreamFile in(cpu_stat_path_);
+
+    if (!in.IsOpen()) {
+        baidu::galaxy::util::ErrorCode ec = in.GetLastError();
+        return ERRORCODE(-1, "open %s failed: %s", cpu_stat_path_.c_str(), ec.Message().c_str());
+    }
+
+    std::string line;
+
+    while (!in.Eof()) {
+        baidu::galaxy::util::ErrorCode ec = in.ReadLine(line);
+
+        if (ec.Code() != 0) {
+            return ERRORCODE(-1, "read (%s) failed: %s",
+                    cpu_stat_path_.c_str(),
+                    ec.Message().c_str());
+        }
+
+        char type[32];
+        long long int t = 0;
+
+        if (2 == sscanf(line.c_str(), "%31s %lld", type, &t)
+                && 0 == strcmp(type, "usage_usec")) {
+            metrix->set_container_cpu_time(t * CLOCK_TICKS / 1000000L);
+            return ERRORCODE_OK;
+        }
+    }
+
+    return ERRORCODE(-1, "no usage_usec in %s", cpu_stat_path_.c_str());
+}
+
 baidu::galaxy::util::ErrorCode CgroupCollector::SystemCpuStat(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix) {
     assert(NULL != metrix.get());
     int64_t cpu_time = 0;
@@ -276,6 +338,56 @@ baidu::galaxy::util::ErrorCode CgroupCollector::MemoryStat(boost::shared_ptr<bai
     return ERRORCODE_OK;
 }
 
+// v2 io.stat:  8:0 rbytes=4096 wbytes=8192 rios=1 wios=2 dbytes=0 dios=0
+// v1 io_service_bytes:  8:0 Read 4096, the Total lines are skipped
+baidu::galaxy::util::ErrorCode CgroupCollector::IoStat(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix) {
+    assert(NULL != metrix.get());
+    const std::string& path = io_stat_path_;
+    baidu::galaxy::file::InputStreamFile in(path);
+
+    if (!in.IsOpen()) {
+        baidu::galaxy::util::ErrorCode ec = in.GetLastError();
+        return ERRORCODE(-1, "open file(%s) failed: %s",
+                path.c_str(),
+                ec.Message().c_str());
+    }
+
+    const bool v2 = boost::ends_with(path, "/io.stat");
+    int64_t read_bytes = 0L;
+    int64_t write_bytes = 0L;
+    std::string line;
+
+    while (!in.Eof()) {
+        baidu::galaxy::util::ErrorCode ec = in.ReadLine(line);
+
+        if (ec.Code() != 0) {
+            return ERRORCODE(-1, "read (%s) failed: %s", path.c_str(), ec.Message().c_str());
+        }
+
+        char device[32];
+        char type[32];
+        long long int rbytes = 0L;
+        long long int wbytes = 0L;
+
+        if (v2) {
+            if (3 == sscanf(line.c_str(), "%31s rbytes=%lld wbytes=%lld", device, &rbytes, &wbytes)) {
+                read_bytes += rbytes;
+                write_bytes += wbytes;
+            }
+        } else if (3 == sscanf(line.c_str(), "%31s %31s %lld", device, type, &rbytes)) {
+            if (0 == strcmp(type, "Read")) {
+                read_bytes += rbytes;
+            } else if (0 == strcmp(type, "Write")) {
+                write_bytes += rbytes;
+            }
+        }
+    }
+
+    metrix->set_io_read_bytes(read_bytes);
+    metrix->set_io_write_bytes(write_bytes);
+    return ERRORCODE_OK;
+}
+
 }
 }
 }
@@ -32,20 +32,42 @@ public:
     std::string Name() const;
     void SetName(const std::string& name);
     boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> Statistics();
+    // takes the last sample of the agent before a hot upgrade, so that the
+    // usage is not reported as zero until the next collect
+    void Restore(const baidu::galaxy::proto::CgroupMetrix& metrix);
 
     void SetCpuacctPath(const std::string& path) {
         cpuacct_path_ = path;
     }
 
+    // cpu.stat of cgroup v2, used instead of cpuacct.stat when set
+    void SetCpuStatPath(const std::string& path) {
+        cpu_stat_path_ = path;
+    }
+
     void SetMemoryPath(const std::string& path) {
         memory_path_ = path;
     }
 
+    // io.stat of cgroup v2 or blkio.throttle.io_service_bytes of v1, io
+    // counters are left out of the metrix when not set
+    void SetIoStatPath(const std::string& path) {
+        io_stat_path_ = path;
+    }
+
+    // dir holding cpu.pressure, memory.pressure and io.pressure, pressure is
+    // left out of the metrix when the kernel has no psi
+    void SetPressureDir(const std::string& dir) {
+        pressure_dir_ = dir;
+    }
+
 private:
     baidu::galaxy::util::ErrorCode Collect(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix);
     baidu::galaxy::util::ErrorCode ContainerCpuStat(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix);
+    baidu::galaxy::util::ErrorCode ContainerCpuStatV2(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix);
     baidu::galaxy::util::ErrorCode SystemCpuStat(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix);
     baidu::galaxy::util::ErrorCode MemoryStat(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix);
+    baidu::galaxy::util::ErrorCode IoStat(boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix);
 
     bool enabled_;
     int cycle_;
@@ -55,7 +77,10 @@ private:
     boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> metrix_;
     int64_t last_time_;
     std::string cpuacct_path_;
+    std::string cpu_stat_path_;
     std::string memory_path_;
+    std::string io_stat_path_;
+    std::string pressure_dir_;
 };
 }
 }
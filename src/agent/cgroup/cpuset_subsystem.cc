@@ -0,0 +1,112 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "cpuset_subsystem.h"
+#include "protocol/galaxy.pb.h"
+#include "agent/util/path_tree.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast/lexical_cast_old.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <assert.h>
+
+#include <fstream>
+
+namespace baidu {
+namespace galaxy {
+namespace cgroup {
+
+CpusetSubsystem::CpusetSubsystem() {
+}
+
+CpusetSubsystem::~CpusetSubsystem() {
+}
+
+std::string CpusetSubsystem::Name() {
+    return "cpuset";
+}
+
+baidu::galaxy::util::ErrorCode CpusetSubsystem::Construct() {
+    assert(NULL != cgroup_);
+    assert(!container_id_.empty());
+    boost::filesystem::path path(this->Path());
+    boost::system::error_code ec;
+
+    if (!boost::filesystem::exists(path)
+            && !baidu::galaxy::file::create_directories(path, ec)) {
+        return ERRORCODE(-1, "failed in creating path %s: %s",
+                path.string().c_str(),
+                ec.message().c_str());
+    }
+
+    // galaxy dir is created together with the first container
+    baidu::galaxy::util::ErrorCode err = Inherit(path.parent_path(), "cpuset.cpus", "");
+    if (0 == err.Code()) {
+        err = Inherit(path.parent_path(), "cpuset.mems", "");
+    }
+
+    if (0 != err.Code()) {
+        return ERRORCODE(-1, "%s", err.Message().c_str());
+    }
+
+    std::string mems;
+    if (cgroup_->cpu().exclusive() && cgroup_->cpu().has_numa_node()) {
+        mems = boost::lexical_cast<std::string>(cgroup_->cpu().numa_node());
+    }
+
+    err = Inherit(path, "cpuset.cpus", cgroup_->cpu().cpu_set());
+    if (0 == err.Code()) {
+        err = Inherit(path, "cpuset.mems", mems);
+    }
+
+    if (0 != err.Code()) {
+        return ERRORCODE(-1, "%s", err.Message().c_str());
+    }
+
+    return ERRORCODE_OK;
+}
+
+baidu::galaxy::util::ErrorCode CpusetSubsystem::Inherit(const boost::filesystem::path& path,
+        const std::string& file,
+        const std::string& value) {
+    boost::filesystem::path target(path);
+    target.append(file);
+
+    if (!value.empty()) {
+        return baidu::galaxy::cgroup::Attach(target.string(), value, false);
+    }
+
+    std::string current;
+    std::ifstream in(target.string().c_str());
+    std::getline(in, current);
+    in.close();
+    boost::trim(current);
+
+    if (!current.empty()) {
+        return ERRORCODE_OK;
+    }
+
+    boost::filesystem::path parent(path.parent_path());
+    parent.append(file);
+    std::string inherited;
+    std::ifstream pin(parent.string().c_str());
+
+    if (!pin.is_open() || !std::getline(pin, inherited)) {
+        return ERRORCODE(-1, "failed in reading %s", parent.string().c_str());
+    }
+
+    boost::trim(inherited);
+    return baidu::galaxy::cgroup::Attach(target.string(), inherited, false);
+}
+
+boost::shared_ptr<Subsystem> CpusetSubsystem::Clone() {
+    boost::shared_ptr<Subsystem> ret(new CpusetSubsystem());
+    return ret;
+}
+
+} //namespace cgroup
+} //namespace galaxy
+} //namespace baidu
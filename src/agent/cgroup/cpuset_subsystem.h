@@ -0,0 +1,30 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#pragma once
+
+#include "subsystem.h"
+
+namespace baidu {
+namespace galaxy {
+namespace cgroup {
+
+class CpusetSubsystem : public Subsystem {
+public:
+    CpusetSubsystem();
+    ~CpusetSubsystem();
+
+    std::string Name();
+    baidu::galaxy::util::ErrorCode Construct();
+    boost::shared_ptr<Subsystem> Clone();
+
+private:
+    // a new cpuset starts empty, copy what the parent has if it is not given
+    baidu::galaxy::util::ErrorCode Inherit(const boost::filesystem::path& path,
+            const std::string& file,
+            const std::string& value);
+};
+
+} //namespace cgroup
+} //namespace galaxy
+} //namespace baidu
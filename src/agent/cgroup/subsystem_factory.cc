@@ -10,9 +10,16 @@
 #include "cpuacct_subsystem.h"
 #include "tcp_throt_subsystem.h"
 #include "blkio_subsystem.h"
+#include "cpuset_subsystem.h"
+#include "unified_subsystem.h"
 
+#include <gflags/gflags.h>
+#include <glog/logging.h>
 #include <assert.h>
 
+DECLARE_string(cpuset_exclusive_cores);
+DECLARE_bool(cgroup_v2);
+
 namespace baidu {
 namespace galaxy {
 namespace cgroup {
@@ -42,11 +49,28 @@ SubsystemFactory* SubsystemFactory::Register(Subsystem* malloc_subsystem) {
 }
 
 void SubsystemFactory::Setup() {
+    if (FLAGS_cgroup_v2) {
+        baidu::galaxy::util::ErrorCode ec = UnifiedSubsystem::EnableControllers();
+        if (0 != ec.Code()) {
+            LOG(FATAL) << "enable cgroup v2 controllers failed: " << ec.Message();
+            exit(1);
+        }
+
+        // net_cls and tcp_throt have no v2 counterpart
+        this->Register(new baidu::galaxy::cgroup::UnifiedSubsystem());
+        return;
+    }
+
     this->Register(new baidu::galaxy::cgroup::CpuSubsystem())
     ->Register(new baidu::galaxy::cgroup::FreezerSubsystem())
     ->Register(new baidu::galaxy::cgroup::TcpThrotSubsystem())
     ->Register(new baidu::galaxy::cgroup::CpuacctSubsystem())
     ->Register(new baidu::galaxy::cgroup::NetclsSubsystem());
+
+    // cpuset hierarchy is only required when cores are dedicated
+    if (!FLAGS_cpuset_exclusive_cores.empty()) {
+        this->Register(new baidu::galaxy::cgroup::CpusetSubsystem());
+    }
 }
 
  
@@ -76,7 +100,10 @@ void SubsystemFactory::GetSubsystems(std::vector<std::string>& subsystems) {
         subsystems.push_back(iter->first);
         iter++;
     }
-    subsystems.push_back("memory");
+
+    if (!FLAGS_cgroup_v2) {
+        subsystems.push_back("memory");
+    }
 }
 
 } //namespace cgroup
@@ -0,0 +1,258 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "unified_subsystem.h"
+#include "protocol/galaxy.pb.h"
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast/lexical_cast_old.hpp>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+DECLARE_string(cpuset_exclusive_cores);
+DECLARE_string(cgroup_io_devices);
+
+namespace baidu {
+namespace galaxy {
+namespace cgroup {
+
+static const int kRemoveRetry = 50;
+static const useconds_t kRemoveInterval = 20000;
+
+UnifiedSubsystem::UnifiedSubsystem() {
+}
+
+UnifiedSubsystem::~UnifiedSubsystem() {
+}
+
+boost::shared_ptr<Subsystem> UnifiedSubsystem::Clone() {
+    boost::shared_ptr<Subsystem> ret(new UnifiedSubsystem());
+    return ret;
+}
+
+std::string UnifiedSubsystem::Name() {
+    return "unified";
+}
+
+baidu::galaxy::util::ErrorCode UnifiedSubsystem::EnableControllers() {
+    std::string controllers = "+cpu +memory +io +pids";
+    if (!FLAGS_cpuset_exclusive_cores.empty()) {
+        controllers += " +cpuset";
+    }
+
+    boost::filesystem::path root(Subsystem::RootPath("unified"));
+    boost::filesystem::path galaxy(root);
+    galaxy.append("galaxy");
+    boost::system::error_code ec;
+
+    if (!boost::filesystem::exists(galaxy, ec)
+            && !baidu::galaxy::file::create_directories(galaxy, ec)) {
+        return ERRORCODE(-1, "failed in creating %s: %s",
+                galaxy.string().c_str(),
+                ec.message().c_str());
+    }
+
+    // a controller reaches a cgroup only if every ancestor delegates it
+    root.append("cgroup.subtree_control");
+    baidu::galaxy::util::ErrorCode err = baidu::galaxy::cgroup::Attach(root.string(), controllers, false);
+    if (0 != err.Code()) {
+        return err;
+    }
+
+    galaxy.append("cgroup.subtree_control");
+    return baidu::galaxy::cgroup::Attach(galaxy.string(), controllers, false);
+}
+
+baidu::galaxy::util::ErrorCode UnifiedSubsystem::Construct() {
+    assert(NULL != cgroup_);
+    assert(!container_id_.empty());
+    boost::filesystem::path path(this->Path());
+    boost::system::error_code ec;
+
+    if (!boost::filesystem::exists(path, ec)
+            && !baidu::galaxy::file::create_directories(path, ec)) {
+        return ERRORCODE(-1, "failed in creating path %s: %s",
+                path.string().c_str(),
+                ec.message().c_str());
+    }
+
+    baidu::galaxy::util::ErrorCode err;
+    const baidu::galaxy::proto::CpuRequired& cpu = cgroup_->cpu();
+
+    if (cpu.excess()) {
+        err = Write("cpu.weight", ShareToWeight(MilliCoreToShare(cpu.milli_core())));
+    } else {
+        err = Write("cpu.max", boost::lexical_cast<std::string>(MilliCoreToCfs(cpu.milli_core()))
+                + " 100000");
+    }
+
+    if (0 != err.Code()) {
+        return err;
+    }
+
+    if (!cpu.cpu_set().empty()) {
+        err = Write("cpuset.cpus", cpu.cpu_set());
+
+        if (0 == err.Code() && cpu.has_numa_node()) {
+            err = Write("cpuset.mems", cpu.numa_node());
+        }
+
+        if (0 != err.Code()) {
+            return err;
+        }
+    }
+
+    // memory.high throttles and reclaims instead of killing, which is
+    // the nearest thing to the excess mode of the v1 kernel
+    const baidu::galaxy::proto::MemoryRequired& memory = cgroup_->memory();
+    if (memory.excess()) {
+        err = Write("memory.high", memory.size());
+    } else {
+        err = Write("memory.max", memory.size());
+    }
+
+    if (0 != err.Code()) {
+        return err;
+    }
+
+    const baidu::galaxy::proto::BlkioRequired& blkio = cgroup_->blkio();
+    if (blkio.weight() > 0) {
+        err = Write("io.weight", "default " + boost::lexical_cast<std::string>(
+                    BlkioWeightToIoWeight(blkio.weight())));
+
+        if (0 != err.Code()) {
+            return err;
+        }
+    }
+
+    if ((blkio.read_bps_limit() > 0 || blkio.write_bps_limit() > 0)
+            && !FLAGS_cgroup_io_devices.empty()) {
+        std::string limit;
+        if (blkio.read_bps_limit() > 0) {
+            limit += " rbps=" + boost::lexical_cast<std::string>(blkio.read_bps_limit());
+        }
+
+        if (blkio.write_bps_limit() > 0) {
+            limit += " wbps=" + boost::lexical_cast<std::string>(blkio.write_bps_limit());
+        }
+
+        std::vector<std::string> devices;
+        boost::split(devices, FLAGS_cgroup_io_devices, boost::is_any_of(","));
+
+        for (size_t i = 0; i < devices.size(); i++) {
+            boost::trim(devices[i]);
+            if (devices[i].empty()) {
+                continue;
+            }
+
+            err = Write("io.max", devices[i] + limit);
+            if (0 != err.Code()) {
+                return err;
+            }
+        }
+    }
+
+    return ERRORCODE_OK;
+}
+
+baidu::galaxy::util::ErrorCode UnifiedSubsystem::Freeze() {
+    return Write("cgroup.freeze", 1L);
+}
+
+baidu::galaxy::util::ErrorCode UnifiedSubsystem::Thaw() {
+    return Write("cgroup.freeze", 0L);
+}
+
+void UnifiedSubsystem::Kill() {
+    // cgroup.kill (linux 5.14) kills the whole subtree in one write
+    if (0 == Write("cgroup.kill", 1L).Code()) {
+        return;
+    }
+
+    Freeze();
+    Subsystem::Kill();
+    Thaw();
+}
+
+baidu::galaxy::util::ErrorCode UnifiedSubsystem::Destroy() {
+    boost::filesystem::path path(this->Path());
+    boost::system::error_code ec;
+
+    if (!boost::filesystem::exists(path, ec)) {
+        return ERRORCODE_OK;
+    }
+
+    Kill();
+
+    // killed processes leave asynchronously, rmdir fails with EBUSY until then
+    for (int i = 0; i < kRemoveRetry; i++) {
+        if (0 == ::rmdir(path.string().c_str()) || ENOENT == errno) {
+            return ERRORCODE_OK;
+        }
+
+        if (EBUSY != errno) {
+            break;
+        }
+
+        ::usleep(kRemoveInterval);
+    }
+
+    return PERRORCODE(-1, errno, "failed in removing %s", path.string().c_str());
+}
+
+baidu::galaxy::util::ErrorCode UnifiedSubsystem::Attach(pid_t pid) {
+    return Write("cgroup.procs", int64_t(pid));
+}
+
+baidu::galaxy::util::ErrorCode UnifiedSubsystem::Write(const std::string& file, int64_t value) {
+    return Write(file, boost::lexical_cast<std::string>(value));
+}
+
+baidu::galaxy::util::ErrorCode UnifiedSubsystem::Write(const std::string& file, const std::string& value) {
+    boost::filesystem::path path(this->Path());
+    path.append(file);
+    baidu::galaxy::util::ErrorCode err = baidu::galaxy::cgroup::Attach(path.string(), value, false);
+
+    if (0 != err.Code()) {
+        return ERRORCODE(-1, "write %s to %s failed: %s",
+                value.c_str(),
+                path.string().c_str(),
+                err.Message().c_str());
+    }
+
+    return ERRORCODE_OK;
+}
+
+int64_t ShareToWeight(int64_t share) {
+    if (share < 2) {
+        share = 2;
+    } else if (share > 262144) {
+        share = 262144;
+    }
+
+    return 1 + ((share - 2) * 9999) / 262142;
+}
+
+int64_t BlkioWeightToIoWeight(int64_t weight) {
+    if (weight < 10) {
+        weight = 10;
+    } else if (weight > 1000) {
+        weight = 1000;
+    }
+
+    return 1 + ((weight - 10) * 9999) / 990;
+}
+
+} //namespace cgroup
+} //namespace galaxy
+} //namespace baidu
@@ -0,0 +1,44 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+#include "subsystem.h"
+
+namespace baidu {
+namespace galaxy {
+namespace cgroup {
+
+// One cgroup v2 directory carries cpu, memory, io, pids and cpuset of a
+// cgroup, freezing and killing are built in. The hierarchy is mounted at
+// <cgroup_root_path>/unified like the v1 hierarchies are.
+class UnifiedSubsystem : public Subsystem {
+public:
+    UnifiedSubsystem();
+    ~UnifiedSubsystem();
+
+    // enables the controllers for the galaxy subtree, called once on setup
+    static baidu::galaxy::util::ErrorCode EnableControllers();
+
+    boost::shared_ptr<Subsystem> Clone();
+    std::string Name();
+    baidu::galaxy::util::ErrorCode Construct();
+    baidu::galaxy::util::ErrorCode Destroy();
+    void Kill();
+    baidu::galaxy::util::ErrorCode Attach(pid_t pid);
+
+    baidu::galaxy::util::ErrorCode Freeze();
+    baidu::galaxy::util::ErrorCode Thaw();
+
+private:
+    baidu::galaxy::util::ErrorCode Write(const std::string& file, const std::string& value);
+    baidu::galaxy::util::ErrorCode Write(const std::string& file, int64_t value);
+};
+
+// v1 shares (2~262144) and blkio weight (10~1000) scaled to v2 weight (1~10000)
+int64_t ShareToWeight(int64_t share);
+int64_t BlkioWeightToIoWeight(int64_t weight);
+
+} //namespace cgroup
+} //namespace galaxy
+} //namespace baidu
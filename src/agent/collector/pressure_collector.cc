@@ -0,0 +1,189 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "pressure_collector.h"
+#include "protocol/galaxy.pb.h"
+#include "util/input_stream_file.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace baidu {
+namespace galaxy {
+namespace collector {
+
+baidu::galaxy::util::ErrorCode ReadPressureFile(const std::string& path,
+        baidu::galaxy::proto::PressureAvg* some,
+        baidu::galaxy::proto::PressureAvg* full) {
+    assert(NULL != some);
+    baidu::galaxy::file::InputStreamFile in(path);
+
+    if (!in.IsOpen()) {
+        baidu::galaxy::util::ErrorCode ec = in.GetLastError();
+        return ERRORCODE(-1, "open %s failed: %s", path.c_str(), ec.Message().c_str());
+    }
+
+    std::string line;
+    bool has_data = false;
+
+    while (!in.Eof()) {
+        baidu::galaxy::util::ErrorCode ec = in.ReadLine(line);
+
+        if (ec.Code() != 0) {
+            return ERRORCODE(-1, "read (%s) failed: %s", path.c_str(), ec.Message().c_str());
+        }
+
+        char type[8];
+        double avg10 = 0.0;
+        double avg60 = 0.0;
+        double avg300 = 0.0;
+
+        if (4 != sscanf(line.c_str(), "%7s avg10=%lf avg60=%lf avg300=%lf",
+                type, &avg10, &avg60, &avg300)) {
+            continue;
+        }
+
+        baidu::galaxy::proto::PressureAvg* avg = NULL;
+        if (0 == strcmp(type, "some")) {
+            avg = some;
+        } else if (0 == strcmp(type, "full")) {
+            avg = full;
+        }
+
+        if (NULL != avg) {
+            avg->set_avg10(avg10);
+            avg->set_avg60(avg60);
+            avg->set_avg300(avg300);
+            has_data = true;
+        }
+    }
+
+    if (!has_data) {
+        return ERRORCODE(-1, "no pressure in %s", path.c_str());
+    }
+
+    return ERRORCODE_OK;
+}
+
+baidu::galaxy::util::ErrorCode ReadPressure(const std::string& dir,
+        const std::string& suffix,
+        baidu::galaxy::proto::Pressure* pressure) {
+    assert(NULL != pressure);
+    baidu::galaxy::util::ErrorCode ec = ReadPressureFile(dir + "/cpu" + suffix,
+            pressure->mutable_cpu_some(),
+            NULL);
+
+    if (ec.Code() != 0) {
+        return ec;
+    }
+
+    ec = ReadPressureFile(dir + "/memory" + suffix,
+            pressure->mutable_memory_some(),
+            pressure->mutable_memory_full());
+
+    if (ec.Code() != 0) {
+        return ec;
+    }
+
+    return ReadPressureFile(dir + "/io" + suffix,
+            pressure->mutable_io_some(),
+            pressure->mutable_io_full());
+}
+
+static void MergeAvg(const baidu::galaxy::proto::PressureAvg& from,
+        baidu::galaxy::proto::PressureAvg* to) {
+    to->set_avg10(std::max(from.avg10(), to->avg10()));
+    to->set_avg60(std::max(from.avg60(), to->avg60()));
+    to->set_avg300(std::max(from.avg300(), to->avg300()));
+}
+
+void MergePressure(const baidu::galaxy::proto::Pressure& from,
+        baidu::galaxy::proto::Pressure* to) {
+    assert(NULL != to);
+    if (from.has_cpu_some()) {
+        MergeAvg(from.cpu_some(), to->mutable_cpu_some());
+    }
+
+    if (from.has_memory_some()) {
+        MergeAvg(from.memory_some(), to->mutable_memory_some());
+    }
+
+    if (from.has_memory_full()) {
+        MergeAvg(from.memory_full(), to->mutable_memory_full());
+    }
+
+    if (from.has_io_some()) {
+        MergeAvg(from.io_some(), to->mutable_io_some());
+    }
+
+    if (from.has_io_full()) {
+        MergeAvg(from.io_full(), to->mutable_io_full());
+    }
+}
+
+PressureCollector::PressureCollector(const std::string& dir) :
+    dir_(dir),
+    enabled_(false),
+    cycle_(-1),
+    pressure_(new baidu::galaxy::proto::Pressure()) {
+}
+
+PressureCollector::~PressureCollector() {
+}
+
+baidu::galaxy::util::ErrorCode PressureCollector::Collect() {
+    boost::shared_ptr<baidu::galaxy::proto::Pressure> pressure(new baidu::galaxy::proto::Pressure());
+    baidu::galaxy::util::ErrorCode ec = ReadPressure(dir_, "", pressure.get());
+
+    if (ec.Code() != 0) {
+        return ERRORCODE(-1, "%s", ec.Message().c_str());
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+    pressure_ = pressure;
+    return ERRORCODE_OK;
+}
+
+void PressureCollector::Enable(bool enable) {
+    boost::mutex::scoped_lock lock(mutex_);
+    enabled_ = enable;
+}
+
+bool PressureCollector::Enabled() {
+    boost::mutex::scoped_lock lock(mutex_);
+    return enabled_;
+}
+
+bool PressureCollector::Equal(const Collector* c) {
+    assert(NULL != c);
+    return this == c;
+}
+
+void PressureCollector::SetCycle(int cycle) {
+    boost::mutex::scoped_lock lock(mutex_);
+    cycle_ = cycle;
+}
+
+int PressureCollector::Cycle() {
+    boost::mutex::scoped_lock lock(mutex_);
+    return cycle_;
+}
+
+std::string PressureCollector::Name() const {
+    return "host_pressure";
+}
+
+boost::shared_ptr<baidu::galaxy::proto::Pressure> PressureCollector::Statistics() {
+    boost::mutex::scoped_lock lock(mutex_);
+    boost::shared_ptr<baidu::galaxy::proto::Pressure> ret(new baidu::galaxy::proto::Pressure());
+    ret->CopyFrom(*pressure_);
+    return ret;
+}
+
+}
+}
+}
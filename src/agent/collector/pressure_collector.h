@@ -0,0 +1,66 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+#include "collector.h"
+#include "util/error_code.h"
+
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include <string>
+
+namespace baidu {
+namespace galaxy {
+namespace proto {
+class Pressure;
+class PressureAvg;
+}
+
+namespace collector {
+
+// parses one psi file, eg: cpu.pressure of a cgroup or /proc/pressure/memory
+//   some avg10=0.12 avg60=0.05 avg300=0.01 total=123456
+//   full avg10=0.00 avg60=0.00 avg300=0.00 total=2345
+// full is optional, cpu of old kernels has the some line only
+baidu::galaxy::util::ErrorCode ReadPressureFile(const std::string& path,
+        baidu::galaxy::proto::PressureAvg* some,
+        baidu::galaxy::proto::PressureAvg* full);
+
+// reads <dir>/cpu<suffix>, <dir>/memory<suffix> and <dir>/io<suffix>
+baidu::galaxy::util::ErrorCode ReadPressure(const std::string& dir,
+        const std::string& suffix,
+        baidu::galaxy::proto::Pressure* pressure);
+
+// keeps the larger average of each field, a container is as stalled as its worst cgroup
+void MergePressure(const baidu::galaxy::proto::Pressure& from,
+        baidu::galaxy::proto::Pressure* to);
+
+// host pressure from /proc/pressure, kernels without psi leave it empty
+class PressureCollector : public Collector {
+public:
+    explicit PressureCollector(const std::string& dir);
+    ~PressureCollector();
+
+    baidu::galaxy::util::ErrorCode Collect();
+    void Enable(bool enable);
+    bool Enabled();
+    bool Equal(const Collector*);
+    void SetCycle(int cycle);
+    int Cycle(); // unit second
+    std::string Name() const;
+
+    boost::shared_ptr<baidu::galaxy::proto::Pressure> Statistics();
+
+private:
+    std::string dir_;
+    bool enabled_;
+    int cycle_;
+    boost::mutex mutex_;
+    boost::shared_ptr<baidu::galaxy::proto::Pressure> pressure_;
+};
+
+}
+}
+}
@@ -6,6 +6,7 @@
 
 #include "cgroup/subsystem_factory.h"
 #include "cgroup/cgroup.h"
+#include "collector/pressure_collector.h"
 #include "protocol/galaxy.pb.h"
 #include "volum/volum_group.h"
 #include "util/user.h"
@@ -169,7 +170,7 @@ baidu::galaxy::util::ErrorCode Container::Construct_() {
     }
 
     LOG(INFO) << "succeed in constructing cgroup for contanier " << id_.CompactId();
-    ret = ConstructVolumGroup();
+    ret = ConstructVolumGroup(NULL);
 
     if (0 != ret) {
         LOG(WARNING) << "failed in constructing volum group for container " << id_.CompactId();
@@ -203,7 +204,7 @@ baidu::galaxy::util::ErrorCode Container::Reload(boost::shared_ptr<baidu::galaxy
     }
 
     LOG(INFO) << "succeed in constructing cgroup for contanier " << id_.CompactId();
-    ret = ConstructVolumGroup();
+    ret = ConstructVolumGroup(NULL);
 
     if (0 != ret) {
         status_.EnterError();
@@ -216,6 +217,57 @@ baidu::galaxy::util::ErrorCode Container::Reload(boost::shared_ptr<baidu::galaxy
     return ERRORCODE_OK;
 }
 
+void Container::Dump(baidu::galaxy::proto::ContainerSnapshot* snapshot) {
+    snapshot->mutable_meta()->CopyFrom(*ContainerMeta());
+
+    for (size_t i = 0; i < cgroup_.size(); i++) {
+        baidu::galaxy::proto::CgroupSnapshot* cs = snapshot->add_cgroups();
+        cs->set_id(cgroup_[i]->Id());
+        cs->mutable_metrix()->CopyFrom(*cgroup_[i]->Statistics());
+    }
+
+    std::map<std::string, int64_t> used;
+    volum_group_->Dump(used);
+    std::map<std::string, int64_t>::const_iterator iter = used.begin();
+
+    for (; iter != used.end(); iter++) {
+        baidu::galaxy::proto::VolumSnapshot* vs = snapshot->add_volums();
+        vs->set_target_path(iter->first);
+        vs->set_used(iter->second);
+    }
+}
+
+baidu::galaxy::util::ErrorCode Container::Restore(const baidu::galaxy::proto::ContainerSnapshot& snapshot) {
+    assert(!id_.Empty());
+    created_time_ = snapshot.meta().created_time();
+    status_.EnterAllocating();
+
+    if (0 != RestoreCgroup(snapshot)) {
+        status_.EnterError();
+        return ERRORCODE(-1, "failed in restoring cgroup");
+    }
+
+    std::map<std::string, int64_t> used;
+
+    for (int i = 0; i < snapshot.volums_size(); i++) {
+        used[snapshot.volums(i).target_path()] = snapshot.volums(i).used();
+    }
+
+    if (0 != ConstructVolumGroup(&used)) {
+        for (size_t i = 0; i < cgroup_.size(); i++) {
+            cgroup_[i]->Detach();
+        }
+
+        cgroup_.clear();
+        status_.EnterError();
+        return ERRORCODE(-1, "failed in restoring volum group");
+    }
+
+    process_->Reload(snapshot.meta().pid());
+    status_.EnterReady();
+    return ERRORCODE_OK;
+}
+
 int Container::ConstructCgroup() {
     for (int i = 0; i < desc_.cgroups_size(); i++) {
         boost::shared_ptr<baidu::galaxy::cgroup::Cgroup> cg(new baidu::galaxy::cgroup::Cgroup(
@@ -258,7 +310,45 @@ int Container::ConstructCgroup() {
     return 0;
 }
 
-int Container::ConstructVolumGroup() {
+int Container::RestoreCgroup(const baidu::galaxy::proto::ContainerSnapshot& snapshot) {
+    for (int i = 0; i < desc_.cgroups_size(); i++) {
+        baidu::galaxy::proto::CgroupMetrix last;
+
+        for (int j = 0; j < snapshot.cgroups_size(); j++) {
+            if (snapshot.cgroups(j).id() == desc_.cgroups(i).id()) {
+                last.CopyFrom(snapshot.cgroups(j).metrix());
+                break;
+            }
+        }
+
+        boost::shared_ptr<baidu::galaxy::cgroup::Cgroup> cg(new baidu::galaxy::cgroup::Cgroup(
+                baidu::galaxy::cgroup::SubsystemFactory::GetInstance()));
+        boost::shared_ptr<baidu::galaxy::proto::Cgroup> desc(new baidu::galaxy::proto::Cgroup());
+        desc->CopyFrom(desc_.cgroups(i));
+        cg->SetContainerId(id_.SubId());
+        cg->SetDescrition(desc);
+        baidu::galaxy::util::ErrorCode err = cg->Restore(last);
+
+        if (0 != err.Code()) {
+            LOG(WARNING) << "fail in restoring cgroup(" << desc_.cgroups(i).id()
+                         << ") for container " << id_.CompactId();
+
+            // the processes are still in the cgroups, only stop collecting them
+            for (size_t j = 0; j < cgroup_.size(); j++) {
+                cgroup_[j]->Detach();
+            }
+
+            cgroup_.clear();
+            return -1;
+        }
+
+        cgroup_.push_back(cg);
+    }
+
+    return 0;
+}
+
+int Container::ConstructVolumGroup(const std::map<std::string, int64_t>* used) {
     assert(created_time_ > 0);
     volum_group_->SetContainerId(id_.SubId());
     volum_group_->SetWorkspaceVolum(desc_.workspace_volum());
@@ -310,7 +400,7 @@ int Container::ConstructVolumGroup() {
         volum_group_->AddOriginVolum(volum_desc);
     }
 
-    baidu::galaxy::util::ErrorCode ec = volum_group_->Construct();
+    baidu::galaxy::util::ErrorCode ec = NULL == used ? volum_group_->Construct() : volum_group_->Restore(*used);
 
     if (0 != ec.Code()) {
         LOG(WARNING) << "failed in constructing volum group for container " << id_.CompactId()
@@ -628,6 +718,10 @@ boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> Container::ContainerInfo(
         ret->set_cpu_used(metrix->cpu_used_in_millicore());
     }
 
+    if (metrix->has_pressure()) {
+        ret->mutable_pressure()->CopyFrom(metrix->pressure());
+    }
+
     baidu::galaxy::proto::ContainerDescription* cd = ret->mutable_container_desc();
 
     if (full_info) {
@@ -707,6 +801,8 @@ boost::shared_ptr<baidu::galaxy::proto::ContainerMetrix> Container::ContainerMet
     boost::shared_ptr<baidu::galaxy::proto::ContainerMetrix> cm(new baidu::galaxy::proto::ContainerMetrix);
     int64_t memory_used_in_byte = 0L;
     int64_t cpu_used_in_millicore = 0L;
+    int64_t io_read_bytes = 0L;
+    int64_t io_write_bytes = 0L;
 
     for (size_t i = 0; i < cgroup_.size(); i++) {
         boost::shared_ptr<baidu::galaxy::proto::CgroupMetrix> m = cgroup_[i]->Statistics();
@@ -714,11 +810,19 @@ boost::shared_ptr<baidu::galaxy::proto::ContainerMetrix> Container::ContainerMet
         if (NULL != cm.get()) {
             memory_used_in_byte += m->memory_used_in_byte();
             cpu_used_in_millicore += m->cpu_used_in_millicore();
+            io_read_bytes += m->io_read_bytes();
+            io_write_bytes += m->io_write_bytes();
+
+            if (m->has_pressure()) {
+                baidu::galaxy::collector::MergePressure(m->pressure(), cm->mutable_pressure());
+            }
         }
     }
 
     cm->set_memory_used_in_byte(memory_used_in_byte);
     cm->set_cpu_used_in_millicore(cpu_used_in_millicore);
+    cm->set_io_read_bytes(io_read_bytes);
+    cm->set_io_write_bytes(io_write_bytes);
     cm->set_time(baidu::common::timer::get_micros());
     return cm;
 }
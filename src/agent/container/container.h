@@ -36,6 +36,8 @@ public:
     baidu::galaxy::util::ErrorCode Construct();
     baidu::galaxy::util::ErrorCode Destroy();
     baidu::galaxy::util::ErrorCode Reload(boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> meta);
+    void Dump(baidu::galaxy::proto::ContainerSnapshot* snapshot);
+    baidu::galaxy::util::ErrorCode Restore(const baidu::galaxy::proto::ContainerSnapshot& snapshot);
     const baidu::galaxy::proto::ContainerDescription& Description();
     boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> ContainerInfo(bool full_info);
     boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> ContainerMeta();
@@ -56,7 +58,9 @@ private:
     bool TryKill();
 
     int ConstructCgroup();
-    int ConstructVolumGroup();
+    int RestoreCgroup(const baidu::galaxy::proto::ContainerSnapshot& snapshot);
+    // used is set when restoring, see VolumGroup::Restore
+    int ConstructVolumGroup(const std::map<std::string, int64_t>* used);
     int ConstructProcess();
 
     int RunRoutine(void*);
@@ -7,14 +7,24 @@
 #include "util/path_tree.h"
 #include "thread.h"
 #include "util/output_stream_file.h"
+#include "collector/collector_engine.h"
 
 #include "boost/bind.hpp"
+#include "timer.h"
 #include <glog/logging.h>
 
 DECLARE_int32(check_assign_interval);
 DECLARE_int64(cpu_resource);
 DECLARE_int64(memory_resource);
 DECLARE_int32(assign_level);
+DECLARE_double(evict_memory_pressure);
+DECLARE_double(evict_cpu_pressure);
+DECLARE_int32(pressure_collect_cycle);
+DECLARE_int32(metrics_sample_interval);
+DECLARE_int32(metrics_ring_size);
+DECLARE_int32(metrics_max_series);
+
+static const int64_t kPressureEvictInterval = 10000000L;
 
 namespace baidu {
 namespace galaxy {
@@ -24,16 +34,23 @@ ContainerManager::ContainerManager(boost::shared_ptr<baidu::galaxy::resource::Re
     res_man_(resman),
     check_assign_pool_(1),
     running_(false),
+    last_pressure_evict_time_(0L),
     serializer_(new Serializer()),
-    container_gc_(new ContainerGc()) {
+    container_gc_(new ContainerGc()),
+    warm_pool_(new WarmPool()),
+    pressure_collector_(new baidu::galaxy::collector::PressureCollector("/proc/pressure")),
+    metrics_(new MetricsStore(FLAGS_metrics_ring_size, FLAGS_metrics_max_series)),
+    metrics_pool_(1) {
     assert(NULL != resman);
 }
 
 ContainerManager::~ContainerManager() {
     running_ = false;
+    metrics_pool_.Stop(false);
+    warm_pool_->Stop();
 }
 
-void ContainerManager::Setup() {
+void ContainerManager::Setup(const baidu::galaxy::proto::AgentSnapshot* snapshot) {
     std::string path = baidu::galaxy::path::RootPath();
     path += "/data";
     baidu::galaxy::util::ErrorCode ec = serializer_->Setup(path);
@@ -45,7 +62,7 @@ void ContainerManager::Setup() {
     }
 
     LOG(INFO) << "succeed in setting up serialize db: " << path;
-    int ret = Reload();
+    int ret = Reload(snapshot);
 
     if (0 != ret) {
         LOG(WARNING) << "failed in recovering container from meta, agent will exit";
@@ -70,6 +87,10 @@ void ContainerManager::Setup() {
     }
 
     LOG(INFO) << "setup container gc successful";
+    warm_pool_->Setup();
+    pressure_collector_->SetCycle(FLAGS_pressure_collect_cycle);
+    pressure_collector_->Enable(true);
+    baidu::galaxy::collector::CollectorEngine::GetInstance()->Register(pressure_collector_);
     running_ = true;
     this->keep_alive_thread_.Start(boost::bind(&ContainerManager::KeepAliveRoutine, this));
     if (FLAGS_assign_level > 0) {
@@ -77,6 +98,10 @@ void ContainerManager::Setup() {
             FLAGS_check_assign_interval,
             boost::bind(&ContainerManager::CheckAssignRoutine, this));
     }
+
+    if (FLAGS_metrics_sample_interval > 0) {
+        metrics_pool_.AddTask(boost::bind(&ContainerManager::MetricsRoutine, this));
+    }
 }
 
 void ContainerManager::KeepAliveRoutine() {
@@ -135,13 +160,29 @@ void ContainerManager::CheckAssignRoutine() {
         << ", memory: " << (memory_used + memory_deep_assigned)
         << ", memory_total: " << FLAGS_memory_resource;
 
+    // stalls show contention before the summed usage reaches the limits
+    boost::shared_ptr<baidu::galaxy::proto::Pressure> pressure = HostPressure();
+    double memory_pressure = pressure->memory_some().avg10();
+    double cpu_pressure = pressure->cpu_some().avg10();
+    int64_t now = baidu::common::timer::get_micros();
+    VLOG(10) << "### host pressure, memory: " << memory_pressure << ", cpu: " << cpu_pressure;
+
     if (memory_used + memory_deep_assigned > FLAGS_memory_resource) {
         LOG(WARNING) << "memory_reserved is danger";
         EvictAssignedContainer(cis, kEvictTypeMemory);
-    } else {
-        if (cpu_used + cpu_deep_assigned > FLAGS_cpu_resource) {
-            LOG(WARNING) << "cpu_reserved is danger";
+    } else if (cpu_used + cpu_deep_assigned > FLAGS_cpu_resource) {
+        LOG(WARNING) << "cpu_reserved is danger";
+        EvictAssignedContainer(cis, kEvictTypeCpu);
+    } else if (now - last_pressure_evict_time_ > kPressureEvictInterval) {
+        // avg10 lags behind an eviction, wait for it to settle before the next one
+        if (FLAGS_evict_memory_pressure > 0.0 && memory_pressure > FLAGS_evict_memory_pressure) {
+            LOG(WARNING) << "memory pressure is danger: " << memory_pressure;
+            EvictAssignedContainer(cis, kEvictTypeMemory);
+            last_pressure_evict_time_ = now;
+        } else if (FLAGS_evict_cpu_pressure > 0.0 && cpu_pressure > FLAGS_evict_cpu_pressure) {
+            LOG(WARNING) << "cpu pressure is danger: " << cpu_pressure;
             EvictAssignedContainer(cis, kEvictTypeCpu);
+            last_pressure_evict_time_ = now;
         }
     }
 
@@ -150,6 +191,65 @@ void ContainerManager::CheckAssignRoutine() {
         boost::bind(&ContainerManager::CheckAssignRoutine, this));
 }
 
+boost::shared_ptr<baidu::galaxy::proto::Pressure> ContainerManager::HostPressure() {
+    return pressure_collector_->Statistics();
+}
+
+void ContainerManager::QueryMetrics(const baidu::galaxy::proto::QueryMetricsRequest& request,
+        baidu::galaxy::proto::QueryMetricsResponse* response) {
+    metrics_->Query(request, response);
+}
+
+void ContainerManager::MetricsRoutine() {
+    std::vector<boost::shared_ptr<baidu::galaxy::container::IContainer> > containers;
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        std::map<ContainerId, boost::shared_ptr<baidu::galaxy::container::IContainer> >::iterator iter = work_containers_.begin();
+
+        for (; iter != work_containers_.end(); iter++) {
+            containers.push_back(iter->second);
+        }
+    }
+
+    int64_t now = baidu::common::timer::get_micros();
+
+    for (size_t i = 0; i < containers.size(); i++) {
+        boost::shared_ptr<baidu::galaxy::proto::ContainerMetrix> m = containers[i]->ContainerMetrix();
+
+        // volum containers have no cgroup
+        if (NULL == m.get()) {
+            continue;
+        }
+
+        boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> ci = containers[i]->ContainerInfo(false);
+        MetricPoint point;
+        point.time_ = now;
+        point.cpu_used_in_millicore_ = m->cpu_used_in_millicore();
+        point.memory_used_in_byte_ = m->memory_used_in_byte();
+        point.io_read_bytes_ = m->io_read_bytes();
+        point.io_write_bytes_ = m->io_write_bytes();
+
+        for (int j = 0; j < ci->volum_used_size(); j++) {
+            point.volum_used_in_byte_ += ci->volum_used(j).used_size();
+        }
+
+        metrics_->Append(ci->id(), ci->group_id(), point);
+    }
+
+    MetricPoint host;
+    host.time_ = now;
+    baidu::galaxy::util::ErrorCode ec = ReadNetDev("/proc/net/dev", &host.net_recv_bytes_, &host.net_send_bytes_);
+
+    if (0 == ec.Code()) {
+        metrics_->Append(kHostSeries, "", host);
+    } else {
+        LOG(WARNING) << "failed in sampling host network: " << ec.Message();
+    }
+
+    metrics_pool_.DelayTask(FLAGS_metrics_sample_interval * 1000,
+            boost::bind(&ContainerManager::MetricsRoutine, this));
+}
+
 void ContainerManager::EvictAssignedContainer(
         std::vector<boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> >& cis,
         EvictType evict_type) {
@@ -220,13 +320,36 @@ baidu::galaxy::util::ErrorCode ContainerManager::CreateContainer(const Container
         LOG(INFO) << "succeed in allocating resource for " << id.CompactId();
     }
 
+    // bound cores are kept in the description, so that reloading takes the same ones
+    baidu::galaxy::proto::ContainerDescription bound_desc(desc);
+    ec = res_man_->AllocateCpuset(bound_desc);
+
+    if (0 != ec.Code()) {
+        LOG(WARNING) << "fail in allocating cpuset for container "
+                     << id.CompactId() << ", detail reason is: "
+                     << ec.Message();
+        ec = res_man_->Release(desc);
+
+        if (ec.Code() != 0) {
+            LOG(FATAL) << "failed in releasing resource for container "
+                       << id.CompactId() << ", detail reason is: "
+                       << ec.Message();
+        }
+
+        return ERRORCODE(-1, "resource");
+    }
+
     // create container
-    baidu::galaxy::util::ErrorCode ret = CreateContainer_(id, desc);
+    baidu::galaxy::util::ErrorCode ret = CreateContainer_(id, bound_desc);
 
     if (0 != ret.Code()) {
         LOG(WARNING) <<  id.CompactId() << " create container failed " << ret.Message();
         ec = res_man_->Release(desc);
 
+        if (ec.Code() == 0) {
+            ec = res_man_->ReleaseCpuset(bound_desc);
+        }
+
         if (ec.Code() != 0) {
             LOG(FATAL) << "failed in releasing resource for container "
                        << id.CompactId() << ", detail reason is: "
@@ -280,6 +403,10 @@ baidu::galaxy::util::ErrorCode ContainerManager::ReleaseContainer(const Containe
     if (0 == ret.Code()) {
         ec = res_man_->Release(iter->second->Description());
 
+        if (0 == ec.Code()) {
+            ec = res_man_->ReleaseCpuset(iter->second->Description());
+        }
+
         if (0 != ec.Code()) {
             LOG(FATAL) << "failed in releasing resource for container " << id.CompactId()
                        << " reason is: " << ec.Message();
@@ -317,6 +444,7 @@ baidu::galaxy::util::ErrorCode ContainerManager::ReleaseContainer(const Containe
 
 baidu::galaxy::util::ErrorCode ContainerManager::CreateContainer_(const ContainerId& id,
         const baidu::galaxy::proto::ContainerDescription& desc) {
+    int64_t start_time = baidu::common::timer::get_micros();
     VLOG(10)
         << "container manager create container, volum_view:  "
         << baidu::galaxy::proto::VolumViewType_Name(desc.volum_view());
@@ -340,6 +468,7 @@ baidu::galaxy::util::ErrorCode ContainerManager::CreateContainer_(const Containe
     }
 
     container->SetDependentVolums(depend_volums);
+    bool warm = warm_pool_->Claim(id.SubId(), desc);
     err = container->Construct();
 
     if (0 != err.Code()) {
@@ -361,7 +490,10 @@ baidu::galaxy::util::ErrorCode ContainerManager::CreateContainer_(const Containe
         work_containers_[id] = container;
     }
     DumpProperty(container);
-    LOG(INFO) << "succeed in constructing container " << id.CompactId();
+    int64_t latency = baidu::common::timer::get_micros() - start_time;
+    warm_pool_->RecordLatency(warm, latency);
+    LOG(INFO) << "succeed in constructing container " << id.CompactId()
+              << ", warm: " << warm << ", cost " << latency / 1000 << "ms";
     return ERRORCODE_OK;
 }
 
@@ -414,7 +546,37 @@ void ContainerManager::ListContainers(std::vector<boost::shared_ptr<baidu::galax
 }
 
 
-int ContainerManager::Reload() {
+bool ContainerManager::Pause(int32_t timeout_ms) {
+    stage_.Hold(true);
+    int64_t deadline = baidu::common::timer::get_micros() + timeout_ms * 1000L;
+
+    while (!stage_.Empty()) {
+        if (baidu::common::timer::get_micros() > deadline) {
+            stage_.Hold(false);
+            return false;
+        }
+
+        ::usleep(10000);
+    }
+
+    return true;
+}
+
+void ContainerManager::Resume() {
+    stage_.Hold(false);
+}
+
+void ContainerManager::Dump(baidu::galaxy::proto::AgentSnapshot* snapshot) {
+    boost::mutex::scoped_lock lock(mutex_);
+    std::map<ContainerId, boost::shared_ptr<baidu::galaxy::container::IContainer> >::iterator iter = work_containers_.begin();
+
+    for (; iter != work_containers_.end(); iter++) {
+        iter->second->Dump(snapshot->add_containers());
+    }
+}
+
+int ContainerManager::Reload(const baidu::galaxy::proto::AgentSnapshot* snapshot) {
+    int64_t start_time = baidu::common::timer::get_micros();
     std::vector<boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> > metas;
     baidu::galaxy::util::ErrorCode ec = serializer_->LoadWork(metas);
 
@@ -423,6 +585,15 @@ int ContainerManager::Reload() {
         return -1;
     }
 
+    // the db stays the truth, the snapshot only saves rebuilding what is there
+    std::map<std::string, const baidu::galaxy::proto::ContainerSnapshot*> snapshots;
+
+    for (int i = 0; NULL != snapshot && i < snapshot->containers_size(); i++) {
+        snapshots[snapshot->containers(i).meta().container_id()] = &snapshot->containers(i);
+    }
+
+    int restored = 0;
+
     for (size_t i = 0; i < metas.size(); i++) {
         ec = res_man_->Allocate(metas[i]->container());
         ContainerId id(metas[i]->group_id(), metas[i]->container_id());
@@ -433,7 +604,33 @@ int ContainerManager::Reload() {
             return -1;
         }
 
+        ec = res_man_->AllocateCpuset(*metas[i]->mutable_container());
+
+        if (ec.Code() != 0) {
+            LOG(WARNING) << "allocat cpuset failed for container " << id.CompactId()
+                         << " reason is:" << ec.Message();
+            return -1;
+        }
+
         boost::shared_ptr<IContainer> container = IContainer::NewContainer(id, metas[i]->container());
+        std::map<std::string, const baidu::galaxy::proto::ContainerSnapshot*>::const_iterator iter
+            = snapshots.find(id.SubId());
+
+        if (snapshots.end() != iter
+                && iter->second->meta().created_time() == metas[i]->created_time()
+                && iter->second->meta().pid() == metas[i]->pid()) {
+            ec = container->Restore(*iter->second);
+
+            if (0 == ec.Code()) {
+                work_containers_[id] = container;
+                restored++;
+                continue;
+            }
+
+            LOG(WARNING) << id.CompactId() << " failed in restoring container, reload it: " << ec.Message();
+            container = IContainer::NewContainer(id, metas[i]->container());
+        }
+
         ec = container->Reload(metas[i]);
 
         if (0 != ec.Code()) {
@@ -444,6 +641,8 @@ int ContainerManager::Reload() {
         work_containers_[id] = container;
     }
 
+    LOG(INFO) << "reload " << metas.size() << " containers, " << restored
+              << " restored from snapshot, cost " << (baidu::common::timer::get_micros() - start_time) / 1000 << "ms";
     return 0;
 }
 
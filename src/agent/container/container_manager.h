@@ -13,6 +13,9 @@
 #include "thread.h"
 #include "thread_pool.h"
 #include "container_gc.h"
+#include "warm_pool.h"
+#include "collector/pressure_collector.h"
+#include "metrics_store.h"
 
 #include <map>
 #include <string>
@@ -31,12 +34,24 @@ public:
     explicit ContainerManager(boost::shared_ptr<baidu::galaxy::resource::ResourceManager> resman);
     ~ContainerManager();
 
-    void Setup();
+    // snapshot is the state of the agent before a hot upgrade, NULL on a
+    // fresh start
+    void Setup(const baidu::galaxy::proto::AgentSnapshot* snapshot);
     baidu::galaxy::util::ErrorCode CreateContainer(const ContainerId& id,
             const baidu::galaxy::proto::ContainerDescription& desc);
 
     baidu::galaxy::util::ErrorCode ReleaseContainer(const ContainerId& id);
     void ListContainers(std::vector<boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> >& cis, bool fullinfo);
+    // empty when the kernel has no psi
+    boost::shared_ptr<baidu::galaxy::proto::Pressure> HostPressure();
+    void QueryMetrics(const baidu::galaxy::proto::QueryMetricsRequest& request,
+            baidu::galaxy::proto::QueryMetricsResponse* response);
+
+    // hot upgrade: Pause stops creating and releasing and waits for the ones
+    // running, false when they take longer than timeout_ms
+    bool Pause(int32_t timeout_ms);
+    void Resume();
+    void Dump(baidu::galaxy::proto::AgentSnapshot* snapshot);
 
 private:
     baidu::galaxy::util::ErrorCode DependentVolums(const baidu::galaxy::proto::ContainerDescription& desc,
@@ -51,10 +66,11 @@ private:
 
     void KeepAliveRoutine();
     void CheckAssignRoutine();
+    void MetricsRoutine();
     void EvictAssignedContainer(
         std::vector<boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> >& cis,
         EvictType evict_type);
-    int Reload();
+    int Reload(const baidu::galaxy::proto::AgentSnapshot* snapshot);
     void DumpProperty(boost::shared_ptr<IContainer> container);
 
     std::map<ContainerId, boost::shared_ptr<baidu::galaxy::container::IContainer> > work_containers_;
@@ -68,9 +84,14 @@ private:
     baidu::common::Thread keep_alive_thread_;
     baidu::common::ThreadPool check_assign_pool_;
     bool running_;
+    int64_t last_pressure_evict_time_;
 
     boost::shared_ptr<Serializer> serializer_;
     boost::shared_ptr<ContainerGc> container_gc_;
+    boost::shared_ptr<WarmPool> warm_pool_;
+    boost::shared_ptr<baidu::galaxy::collector::PressureCollector> pressure_collector_;
+    boost::shared_ptr<MetricsStore> metrics_;
+    baidu::common::ThreadPool metrics_pool_;
 };
 
 } //namespace agent
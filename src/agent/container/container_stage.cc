@@ -10,7 +10,8 @@ namespace baidu {
 namespace galaxy {
 namespace container {
 
-ContainerStage::ContainerStage() {
+ContainerStage::ContainerStage() :
+    held_(false) {
 }
 
 ContainerStage::~ContainerStage() {
@@ -18,6 +19,13 @@ ContainerStage::~ContainerStage() {
 
 baidu::galaxy::util::ErrorCode ContainerStage::EnterDestroyingStage(const std::string& id) {
     boost::mutex::scoped_lock lock(mutex_);
+
+    if (held_) {
+        return ERRORCODE(baidu::galaxy::util::kErrorNotAllowed,
+                "container %s CANNOT enter a stage, stages are held",
+                id.c_str());
+    }
+
     boost::unordered_map<std::string, baidu::galaxy::proto::ContainerStatus>::const_iterator iter = stage_.find(id);
 
     if (stage_.end() == iter) {
@@ -41,6 +49,13 @@ baidu::galaxy::util::ErrorCode ContainerStage::EnterDestroyingStage(const std::s
 
 baidu::galaxy::util::ErrorCode ContainerStage::EnterCreatingStage(const std::string& id) {
     boost::mutex::scoped_lock lock(mutex_);
+
+    if (held_) {
+        return ERRORCODE(baidu::galaxy::util::kErrorNotAllowed,
+                "container %s CANNOT enter a stage, stages are held",
+                id.c_str());
+    }
+
     boost::unordered_map<std::string, baidu::galaxy::proto::ContainerStatus>::const_iterator iter = stage_.find(id);
 
     if (stage_.end() == iter) {
@@ -80,6 +95,16 @@ baidu::galaxy::util::ErrorCode ContainerStage::LeaveCreatingStage(const std::str
     return ERRORCODE(baidu::galaxy::util::kErrorOk, "");
 }
 
+void ContainerStage::Hold(bool hold) {
+    boost::mutex::scoped_lock lock(mutex_);
+    held_ = hold;
+}
+
+bool ContainerStage::Empty() {
+    boost::mutex::scoped_lock lock(mutex_);
+    return stage_.empty();
+}
+
 }
 }
 }
@@ -26,9 +26,14 @@ public:
     baidu::galaxy::util::ErrorCode LeaveDestroyingStage(const std::string& id);
     baidu::galaxy::util::ErrorCode LeaveCreatingStage(const std::string& id);
 
+    // no container enters a stage while held, the ones in a stage go on
+    void Hold(bool hold);
+    bool Empty();
+
 private:
     // use kContainerAlloctation & kContainerDestroying only
     boost::unordered_map<std::string, baidu::galaxy::proto::ContainerStatus> stage_;
+    bool held_;
     boost::mutex mutex_;
 
 };
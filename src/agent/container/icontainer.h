@@ -93,6 +93,10 @@ public:
     virtual baidu::galaxy::util::ErrorCode Construct() = 0;
     virtual baidu::galaxy::util::ErrorCode Destroy() = 0;
     virtual baidu::galaxy::util::ErrorCode Reload(boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> meta) = 0;
+    // hot upgrade of the agent, Dump hands the state to the next agent and
+    // Restore takes it over, leaving cgroups and mounts as they are
+    virtual void Dump(baidu::galaxy::proto::ContainerSnapshot* snapshot) = 0;
+    virtual baidu::galaxy::util::ErrorCode Restore(const baidu::galaxy::proto::ContainerSnapshot& snapshot) = 0;
     virtual void KeepAlive() = 0;
 
     virtual boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> ContainerMeta() = 0;
@@ -0,0 +1,280 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "metrics_store.h"
+#include "protocol/agent.pb.h"
+#include "util/input_stream_file.h"
+
+#include "boost/algorithm/string/trim.hpp"
+#include "timer.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <sstream>
+
+namespace baidu {
+namespace galaxy {
+namespace container {
+
+const std::string kHostSeries = "host";
+
+static int64_t Rate(int64_t current, int64_t last, int64_t interval_us) {
+    // counters go back when the cgroups are rebuilt
+    if (interval_us <= 0 || current < last) {
+        return 0L;
+    }
+    return (current - last) * 1000000L / interval_us;
+}
+
+MetricsStore::MetricsStore(size_t ring_size, size_t max_series) :
+    ring_size_(ring_size > 0 ? ring_size : 1),
+    max_series_(max_series > 0 ? max_series : 1) {
+}
+
+MetricsStore::~MetricsStore() {
+}
+
+void MetricsStore::Append(const std::string& id, const std::string& group_id, const MetricPoint& point) {
+    boost::mutex::scoped_lock lock(mutex_);
+    std::map<std::string, Series>::iterator iter = series_.find(id);
+
+    if (series_.end() == iter) {
+        if (series_.size() >= max_series_) {
+            Evict();
+        }
+
+        iter = series_.insert(std::make_pair(id, Series())).first;
+        iter->second.ring_.resize(ring_size_);
+    }
+
+    Series& series = iter->second;
+    series.group_id_ = group_id;
+
+    int64_t interval = series.last_.time_ > 0 ? point.time_ - series.last_.time_ : 0L;
+    Sample sample;
+    sample.time_ = point.time_;
+    sample.cpu_used_in_millicore_ = point.cpu_used_in_millicore_;
+    sample.memory_used_in_byte_ = point.memory_used_in_byte_;
+    sample.io_read_bps_ = Rate(point.io_read_bytes_, series.last_.io_read_bytes_, interval);
+    sample.io_write_bps_ = Rate(point.io_write_bytes_, series.last_.io_write_bytes_, interval);
+    sample.net_recv_bps_ = Rate(point.net_recv_bytes_, series.last_.net_recv_bytes_, interval);
+    sample.net_send_bps_ = Rate(point.net_send_bytes_, series.last_.net_send_bytes_, interval);
+    sample.volum_used_in_byte_ = point.volum_used_in_byte_;
+    series.last_ = point;
+
+    if (series.size_ < ring_size_) {
+        series.ring_[(series.head_ + series.size_) % ring_size_] = sample;
+        series.size_++;
+    } else {
+        // overwrite the oldest one
+        series.ring_[series.head_] = sample;
+        series.head_ = (series.head_ + 1) % ring_size_;
+    }
+}
+
+void MetricsStore::Query(const baidu::galaxy::proto::QueryMetricsRequest& request,
+        baidu::galaxy::proto::QueryMetricsResponse* response) {
+    assert(NULL != response);
+    int64_t start_time = request.start_time();
+    int64_t end_time = request.has_end_time() ? request.end_time() : baidu::common::timer::get_micros();
+    int64_t step = request.step() > 0 ? request.step() * 1000000L : 0L;
+
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        std::map<std::string, Series>::const_iterator iter = series_.begin();
+
+        for (; iter != series_.end(); iter++) {
+            if (!request.id().empty() && request.id() != iter->first) {
+                continue;
+            }
+
+            Fill(iter->first, iter->second, start_time, end_time, step, response);
+        }
+    }
+
+    if (request.text()) {
+        response->set_text(MetricsToText(*response));
+        response->clear_series();
+    }
+}
+
+void MetricsStore::Fill(const std::string& id,
+        const Series& series,
+        int64_t start_time,
+        int64_t end_time,
+        int64_t step,
+        baidu::galaxy::proto::QueryMetricsResponse* response) {
+    baidu::galaxy::proto::MetricSeries* ms = response->add_series();
+    ms->set_id(id);
+    ms->set_group_id(series.group_id_);
+    const bool host = (kHostSeries == id);
+
+    // samples of one step are summed up here and averaged on flushing
+    Sample sum = Sample();
+    int64_t count = 0L;
+    int64_t bucket = -1L;
+
+    for (size_t i = 0; i <= series.size_; i++) {
+        const Sample* sample = NULL;
+
+        if (i < series.size_) {
+            sample = &series.ring_[(series.head_ + i) % ring_size_];
+
+            if (sample->time_ < start_time || sample->time_ > end_time) {
+                continue;
+            }
+        }
+
+        int64_t b = (NULL != sample && step > 0) ? sample->time_ / step : -1L;
+
+        if (count > 0 && (NULL == sample || step <= 0 || b != bucket)) {
+            baidu::galaxy::proto::MetricSample* out = ms->add_samples();
+            out->set_time(step > 0 ? bucket * step : sum.time_);
+
+            if (host) {
+                out->set_net_recv_bps(sum.net_recv_bps_ / count);
+                out->set_net_send_bps(sum.net_send_bps_ / count);
+            } else {
+                out->set_cpu_used_in_millicore(sum.cpu_used_in_millicore_ / count);
+                out->set_memory_used_in_byte(sum.memory_used_in_byte_ / count);
+                out->set_io_read_bps(sum.io_read_bps_ / count);
+                out->set_io_write_bps(sum.io_write_bps_ / count);
+                out->set_volum_used_in_byte(sum.volum_used_in_byte_ / count);
+            }
+
+            sum = Sample();
+            count = 0L;
+        }
+
+        if (NULL == sample) {
+            break;
+        }
+
+        bucket = b;
+        sum.time_ = sample->time_;
+        sum.cpu_used_in_millicore_ += sample->cpu_used_in_millicore_;
+        sum.memory_used_in_byte_ += sample->memory_used_in_byte_;
+        sum.io_read_bps_ += sample->io_read_bps_;
+        sum.io_write_bps_ += sample->io_write_bps_;
+        sum.net_recv_bps_ += sample->net_recv_bps_;
+        sum.net_send_bps_ += sample->net_send_bps_;
+        sum.volum_used_in_byte_ += sample->volum_used_in_byte_;
+        count++;
+    }
+}
+
+void MetricsStore::Evict() {
+    std::map<std::string, Series>::iterator oldest = series_.end();
+    std::map<std::string, Series>::iterator iter = series_.begin();
+
+    for (; iter != series_.end(); iter++) {
+        if (series_.end() == oldest || iter->second.last_.time_ < oldest->second.last_.time_) {
+            oldest = iter;
+        }
+    }
+
+    if (series_.end() != oldest) {
+        series_.erase(oldest);
+    }
+}
+
+baidu::galaxy::util::ErrorCode ReadNetDev(const std::string& path,
+        int64_t* recv_bytes,
+        int64_t* send_bytes) {
+    assert(NULL != recv_bytes);
+    assert(NULL != send_bytes);
+    baidu::galaxy::file::InputStreamFile in(path);
+
+    if (!in.IsOpen()) {
+        baidu::galaxy::util::ErrorCode ec = in.GetLastError();
+        return ERRORCODE(-1, "open %s failed: %s", path.c_str(), ec.Message().c_str());
+    }
+
+    *recv_bytes = 0L;
+    *send_bytes = 0L;
+    std::string line;
+
+    while (!in.Eof()) {
+        baidu::galaxy::util::ErrorCode ec = in.ReadLine(line);
+
+        if (ec.Code() != 0) {
+            return ERRORCODE(-1, "read (%s) failed: %s", path.c_str(), ec.Message().c_str());
+        }
+
+        // eth0: 1234 5 0 0 0 0 0 0 5678 6 0 0 0 0 0 0, the two header lines have no colon
+        std::string::size_type pos = line.find(':');
+        if (std::string::npos == pos) {
+            continue;
+        }
+
+        std::string name = line.substr(0, pos);
+        boost::algorithm::trim(name);
+        long long int r = 0L;
+        long long int s = 0L;
+
+        if ("lo" != name && 2 == sscanf(line.c_str() + pos + 1,
+                "%lld %*d %*d %*d %*d %*d %*d %*d %lld", &r, &s)) {
+            *recv_bytes += r;
+            *send_bytes += s;
+        }
+    }
+
+    return ERRORCODE_OK;
+}
+
+static void AppendLine(std::stringstream& ss,
+        const char* name,
+        const std::string& labels,
+        int64_t value,
+        int64_t time) {
+    ss << "galaxy_" << name << labels << " " << value << " " << time / 1000L << "\n";
+}
+
+std::string MetricsToText(const baidu::galaxy::proto::QueryMetricsResponse& response) {
+    std::stringstream ss;
+
+    for (int i = 0; i < response.series_size(); i++) {
+        const baidu::galaxy::proto::MetricSeries& ms = response.series(i);
+        const std::string labels = "{id=\"" + ms.id() + "\",group=\"" + ms.group_id() + "\"}";
+
+        for (int j = 0; j < ms.samples_size(); j++) {
+            const baidu::galaxy::proto::MetricSample& s = ms.samples(j);
+
+            if (s.has_cpu_used_in_millicore()) {
+                AppendLine(ss, "cpu_used_millicore", labels, s.cpu_used_in_millicore(), s.time());
+            }
+
+            if (s.has_memory_used_in_byte()) {
+                AppendLine(ss, "memory_used_bytes", labels, s.memory_used_in_byte(), s.time());
+            }
+
+            if (s.has_io_read_bps()) {
+                AppendLine(ss, "io_read_bytes_per_second", labels, s.io_read_bps(), s.time());
+            }
+
+            if (s.has_io_write_bps()) {
+                AppendLine(ss, "io_write_bytes_per_second", labels, s.io_write_bps(), s.time());
+            }
+
+            if (s.has_net_recv_bps()) {
+                AppendLine(ss, "net_recv_bytes_per_second", labels, s.net_recv_bps(), s.time());
+            }
+
+            if (s.has_net_send_bps()) {
+                AppendLine(ss, "net_send_bytes_per_second", labels, s.net_send_bps(), s.time());
+            }
+
+            if (s.has_volum_used_in_byte()) {
+                AppendLine(ss, "volum_used_bytes", labels, s.volum_used_in_byte(), s.time());
+            }
+        }
+    }
+
+    return ss.str();
+}
+
+} //namespace container
+} //namespace galaxy
+} //namespace baidu
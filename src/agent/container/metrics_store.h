@@ -0,0 +1,116 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+#include "util/error_code.h"
+
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace baidu {
+namespace galaxy {
+namespace proto {
+class QueryMetricsRequest;
+class QueryMetricsResponse;
+}
+
+namespace container {
+
+extern const std::string kHostSeries;
+
+// one sample as collected, io and net are accumulated counters
+class MetricPoint {
+public:
+    MetricPoint() :
+        time_(0L),
+        cpu_used_in_millicore_(0L),
+        memory_used_in_byte_(0L),
+        io_read_bytes_(0L),
+        io_write_bytes_(0L),
+        net_recv_bytes_(0L),
+        net_send_bytes_(0L),
+        volum_used_in_byte_(0L) {}
+
+    int64_t time_;
+    int64_t cpu_used_in_millicore_;
+    int64_t memory_used_in_byte_;
+    int64_t io_read_bytes_;
+    int64_t io_write_bytes_;
+    int64_t net_recv_bytes_;
+    int64_t net_send_bytes_;
+    int64_t volum_used_in_byte_;
+};
+
+// Keeps the recent samples of each container in a ring of fixed size, the
+// memory of the whole history is bounded by ring_size * max_series. Series
+// of released containers stay until the slots are needed by new ones, so
+// that the history of a dead container is there for debugging.
+class MetricsStore {
+public:
+    MetricsStore(size_t ring_size, size_t max_series);
+    ~MetricsStore();
+
+    void Append(const std::string& id, const std::string& group_id, const MetricPoint& point);
+    void Query(const baidu::galaxy::proto::QueryMetricsRequest& request,
+            baidu::galaxy::proto::QueryMetricsResponse* response);
+
+private:
+    // counters are turned into rates on appending
+    class Sample {
+    public:
+        int64_t time_;
+        int64_t cpu_used_in_millicore_;
+        int64_t memory_used_in_byte_;
+        int64_t io_read_bps_;
+        int64_t io_write_bps_;
+        int64_t net_recv_bps_;
+        int64_t net_send_bps_;
+        int64_t volum_used_in_byte_;
+    };
+
+    class Series {
+    public:
+        Series() :
+            head_(0),
+            size_(0) {}
+
+        std::string group_id_;
+        std::vector<Sample> ring_;
+        // index of the oldest sample
+        size_t head_;
+        size_t size_;
+        MetricPoint last_;
+    };
+
+    void Fill(const std::string& id,
+            const Series& series,
+            int64_t start_time,
+            int64_t end_time,
+            int64_t step,
+            baidu::galaxy::proto::QueryMetricsResponse* response);
+    void Evict();
+
+    size_t ring_size_;
+    size_t max_series_;
+    boost::mutex mutex_;
+    std::map<std::string, Series> series_;
+};
+
+// sums the counters of /proc/net/dev except the loopback
+baidu::galaxy::util::ErrorCode ReadNetDev(const std::string& path,
+        int64_t* recv_bytes,
+        int64_t* send_bytes);
+
+// renders the series of a response in the text format, one line per point
+std::string MetricsToText(const baidu::galaxy::proto::QueryMetricsResponse& response);
+
+} //namespace container
+} //namespace galaxy
+} //namespace baidu
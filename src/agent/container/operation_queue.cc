@@ -0,0 +1,193 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "operation_queue.h"
+
+#include "boost/bind.hpp"
+#include "timer.h"
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+DECLARE_int32(container_op_threads);
+
+namespace baidu {
+namespace galaxy {
+namespace container {
+
+OperationQueue::OperationQueue(boost::shared_ptr<ContainerManager> cm) :
+    cm_(cm),
+    seq_(baidu::common::timer::get_micros()),
+    running_(false),
+    pool_(FLAGS_container_op_threads > 0 ? FLAGS_container_op_threads : 1) {
+    assert(NULL != cm);
+}
+
+OperationQueue::~OperationQueue() {
+    Stop();
+}
+
+void OperationQueue::Setup() {
+    boost::mutex::scoped_lock lock(mutex_);
+    running_ = true;
+    LOG(INFO) << "container operation queue is set up, threads: " << FLAGS_container_op_threads;
+}
+
+void OperationQueue::Stop() {
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    // operations handed to the pool finish, the ones queued behind them are dropped
+    pool_.Stop(true);
+}
+
+int64_t OperationQueue::Submit(const ContainerId& id, OperationType type) {
+    return Submit(id, type, baidu::galaxy::proto::ContainerDescription());
+}
+
+int64_t OperationQueue::Submit(const ContainerId& id,
+        OperationType type,
+        const baidu::galaxy::proto::ContainerDescription& desc) {
+    boost::mutex::scoped_lock lock(mutex_);
+    if (!running_) {
+        return -1;
+    }
+
+    OperationList& list = ops_[id.SubId()];
+    // a create of another version, eg a reschedule in place, is queued
+    // on its own, merging would drop its description
+    if (!list.ops_.empty() && list.ops_.back().type_ == type
+            && (kOperationCreate != type || list.ops_.back().desc_.version() == desc.version())) {
+        VLOG(10) << "operation " << list.ops_.back().op_id_ << " of container "
+                 << id.CompactId() << " is waiting already";
+        return list.ops_.back().op_id_;
+    }
+
+    Operation op;
+    op.op_id_ = ++seq_;
+    op.type_ = type;
+    op.id_ = id;
+    op.submit_time_ = baidu::common::timer::get_micros();
+    if (kOperationCreate == type) {
+        op.desc_.CopyFrom(desc);
+    }
+    list.ops_.push_back(op);
+
+    // a new operation decides the state of the container from now on
+    failed_.erase(id.SubId());
+
+    if (!list.running_) {
+        list.running_ = true;
+        pool_.AddTask(boost::bind(&OperationQueue::Run, this, id.SubId()));
+    }
+
+    LOG(INFO) << "submit operation " << op.op_id_ << " (" << (kOperationCreate == type ? "create" : "release")
+              << ") of container " << id.CompactId() << ", " << list.ops_.size() << " in its queue";
+    return op.op_id_;
+}
+
+void OperationQueue::Run(const std::string& container_id) {
+    Operation op;
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        std::map<std::string, OperationList>::iterator iter = ops_.find(container_id);
+        assert(ops_.end() != iter);
+        assert(!iter->second.ops_.empty());
+        op = iter->second.ops_.front();
+    }
+
+    int64_t start_time = baidu::common::timer::get_micros();
+    baidu::galaxy::util::ErrorCode ec;
+    if (kOperationCreate == op.type_) {
+        ec = cm_->CreateContainer(op.id_, op.desc_);
+    } else {
+        ec = cm_->ReleaseContainer(op.id_);
+    }
+    int64_t end_time = baidu::common::timer::get_micros();
+
+    if (0 != ec.Code()) {
+        LOG(WARNING) << "operation " << op.op_id_ << " of container " << op.id_.CompactId()
+                     << " failed: " << ec.Message();
+    } else {
+        LOG(INFO) << "operation " << op.op_id_ << " of container " << op.id_.CompactId()
+                  << " done, waited " << (start_time - op.submit_time_) / 1000
+                  << "ms, cost " << (end_time - start_time) / 1000 << "ms";
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+    std::map<std::string, OperationList>::iterator iter = ops_.find(container_id);
+    assert(ops_.end() != iter);
+    OperationList& list = iter->second;
+    list.ops_.pop_front();
+
+    if (0 != ec.Code() && kOperationCreate == op.type_ && list.ops_.empty()) {
+        failed_[container_id] = op;
+    }
+
+    if (list.ops_.empty()) {
+        ops_.erase(iter);
+    } else if (running_) {
+        // requeue instead of looping, so that a busy container does not starve the others
+        pool_.AddTask(boost::bind(&OperationQueue::Run, this, container_id));
+    }
+}
+
+void OperationQueue::Overlay(std::vector<boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> >& cis,
+        bool fullinfo) {
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < cis.size(); i++) {
+        index[cis[i]->id()] = i;
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+    std::map<std::string, OperationList>::const_iterator iter = ops_.begin();
+    for (; iter != ops_.end(); iter++) {
+        // the latest operation is what the container is heading to
+        const Operation& op = iter->second.ops_.back();
+        std::map<std::string, size_t>::const_iterator it = index.find(iter->first);
+
+        if (kOperationCreate == op.type_) {
+            if (index.end() == it) {
+                cis.push_back(NewInfo(op, baidu::galaxy::proto::kContainerAllocating, fullinfo));
+            }
+        } else if (index.end() != it) {
+            cis[it->second]->set_status(baidu::galaxy::proto::kContainerDestroying);
+        }
+    }
+
+    std::map<std::string, Operation>::const_iterator fiter = failed_.begin();
+    for (; fiter != failed_.end(); fiter++) {
+        if (index.find(fiter->first) == index.end()) {
+            cis.push_back(NewInfo(fiter->second, baidu::galaxy::proto::kContainerError, fullinfo));
+        }
+    }
+}
+
+boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> OperationQueue::NewInfo(const Operation& op,
+        baidu::galaxy::proto::ContainerStatus status,
+        bool fullinfo) {
+    boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> ret(new baidu::galaxy::proto::ContainerInfo());
+    ret->set_id(op.id_.SubId());
+    ret->set_group_id(op.id_.GroupId());
+    ret->set_created_time(0);
+    ret->set_status(status);
+    ret->set_cpu_used(0);
+    ret->set_memory_used(0);
+
+    baidu::galaxy::proto::ContainerDescription* cd = ret->mutable_container_desc();
+    if (fullinfo) {
+        cd->CopyFrom(op.desc_);
+    } else {
+        cd->set_version(op.desc_.version());
+    }
+
+    return ret;
+}
+
+} //namespace container
+} //namespace galaxy
+} //namespace baidu
@@ -0,0 +1,96 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+#include "container_manager.h"
+#include "protocol/galaxy.pb.h"
+
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/mutex.hpp"
+#include "thread_pool.h"
+
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace baidu {
+namespace galaxy {
+namespace container {
+
+enum OperationType {
+    kOperationCreate = 1,
+    kOperationRelease = 2
+};
+
+// Runs container creating and releasing off the rpc threads. Operations of
+// one container are serialized in submitting order, different containers
+// proceed in parallel on a bounded pool. Rpc handlers only get an operation
+// id back, the progress is reported through the status of ContainerInfo.
+class OperationQueue {
+public:
+    explicit OperationQueue(boost::shared_ptr<ContainerManager> cm);
+    ~OperationQueue();
+
+    void Setup();
+    void Stop();
+
+    // a repeated submit of the operation already waiting for the container
+    // returns the id of the existing one
+    int64_t Submit(const ContainerId& id,
+            OperationType type,
+            const baidu::galaxy::proto::ContainerDescription& desc);
+
+    int64_t Submit(const ContainerId& id, OperationType type);
+
+    // adds containers still being created and failed ones to cis, and marks
+    // containers being released
+    void Overlay(std::vector<boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> >& cis,
+            bool fullinfo);
+
+private:
+    class Operation {
+    public:
+        Operation() :
+            op_id_(0),
+            type_(kOperationCreate),
+            submit_time_(0) {}
+
+        int64_t op_id_;
+        OperationType type_;
+        ContainerId id_;
+        baidu::galaxy::proto::ContainerDescription desc_;
+        int64_t submit_time_;
+    };
+
+    class OperationList {
+    public:
+        OperationList() :
+            running_(false) {}
+
+        std::deque<Operation> ops_;
+        bool running_;
+    };
+
+    void Run(const std::string& container_id);
+    boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> NewInfo(const Operation& op,
+            baidu::galaxy::proto::ContainerStatus status,
+            bool fullinfo);
+
+    boost::shared_ptr<ContainerManager> cm_;
+    boost::mutex mutex_;
+    // key: sub id of container, the front operation is the one running
+    std::map<std::string, OperationList> ops_;
+    // creates failed lately, reported as kContainerError until released
+    std::map<std::string, Operation> failed_;
+    int64_t seq_;
+    bool running_;
+    baidu::common::ThreadPool pool_;
+};
+
+} //namespace container
+} //namespace galaxy
+} //namespace baidu
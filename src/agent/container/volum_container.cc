@@ -42,7 +42,7 @@ baidu::galaxy::util::ErrorCode VolumContainer::Construct() {
 
     created_time_ = baidu::common::timer::get_micros();
 
-    if (0 != ConstructVolumGroup()) {
+    if (0 != ConstructVolumGroup(NULL)) {
         LOG(WARNING) << id_.CompactId() << " construct volum group failed: ";
         ec = status_.EnterError();
         assert(ec.Code() == baidu::galaxy::util::kErrorOk);
@@ -56,7 +56,7 @@ baidu::galaxy::util::ErrorCode VolumContainer::Construct() {
     return ec;
 }
 
-int VolumContainer::ConstructVolumGroup() {
+int VolumContainer::ConstructVolumGroup(const std::map<std::string, int64_t>* used) {
     assert(created_time_ > 0);
     volum_group_->SetContainerId(id_.SubId());
     volum_group_->SetWorkspaceVolum(desc_.workspace_volum());
@@ -67,7 +67,7 @@ int VolumContainer::ConstructVolumGroup() {
         volum_group_->AddDataVolum(desc_.data_volums(i));
     }
 
-    baidu::galaxy::util::ErrorCode ec = volum_group_->Construct();
+    baidu::galaxy::util::ErrorCode ec = NULL == used ? volum_group_->Construct() : volum_group_->Restore(*used);
 
     if (0 != ec.Code()) {
         LOG(WARNING) << "failed in constructing volum group for container " << id_.CompactId()
@@ -122,7 +122,7 @@ baidu::galaxy::util::ErrorCode VolumContainer::Reload(boost::shared_ptr<baidu::g
     assert(!id_.Empty());
     created_time_ = meta->created_time();
     status_.EnterAllocating();
-    int ret = ConstructVolumGroup();
+    int ret = ConstructVolumGroup(NULL);
 
     if (0 != ret) {
         status_.EnterError();
@@ -134,6 +134,38 @@ baidu::galaxy::util::ErrorCode VolumContainer::Reload(boost::shared_ptr<baidu::g
     return ERRORCODE_OK;
 }
 
+void VolumContainer::Dump(baidu::galaxy::proto::ContainerSnapshot* snapshot) {
+    snapshot->mutable_meta()->CopyFrom(*ContainerMeta());
+    std::map<std::string, int64_t> used;
+    volum_group_->Dump(used);
+    std::map<std::string, int64_t>::const_iterator iter = used.begin();
+
+    for (; iter != used.end(); iter++) {
+        baidu::galaxy::proto::VolumSnapshot* vs = snapshot->add_volums();
+        vs->set_target_path(iter->first);
+        vs->set_used(iter->second);
+    }
+}
+
+baidu::galaxy::util::ErrorCode VolumContainer::Restore(const baidu::galaxy::proto::ContainerSnapshot& snapshot) {
+    assert(!id_.Empty());
+    created_time_ = snapshot.meta().created_time();
+    status_.EnterAllocating();
+    std::map<std::string, int64_t> used;
+
+    for (int i = 0; i < snapshot.volums_size(); i++) {
+        used[snapshot.volums(i).target_path()] = snapshot.volums(i).used();
+    }
+
+    if (0 != ConstructVolumGroup(&used)) {
+        status_.EnterError();
+        return ERRORCODE(-1, "failed in restoring volum group");
+    }
+
+    status_.EnterReady();
+    return ERRORCODE_OK;
+}
+
 boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> VolumContainer::ContainerMeta() {
     boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> ret(new baidu::galaxy::proto::ContainerMeta());
     ret->set_container_id(id_.SubId());
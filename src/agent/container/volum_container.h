@@ -24,6 +24,8 @@ public:
     baidu::galaxy::util::ErrorCode Construct();
     baidu::galaxy::util::ErrorCode Destroy();
     baidu::galaxy::util::ErrorCode Reload(boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> meta);
+    void Dump(baidu::galaxy::proto::ContainerSnapshot* snapshot);
+    baidu::galaxy::util::ErrorCode Restore(const baidu::galaxy::proto::ContainerSnapshot& snapshot);
 
     boost::shared_ptr<baidu::galaxy::proto::ContainerMeta> ContainerMeta();
     boost::shared_ptr<baidu::galaxy::proto::ContainerInfo> ContainerInfo(bool full_info);
@@ -37,7 +39,7 @@ private:
     boost::shared_ptr<baidu::galaxy::volum::VolumGroup> volum_group_;
     int64_t created_time_;
     int64_t destroy_time_;
-    int ConstructVolumGroup();
+    int ConstructVolumGroup(const std::map<std::string, int64_t>* used);
 };
 }
 }
@@ -0,0 +1,342 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "warm_pool.h"
+#include "cgroup/subsystem.h"
+#include "cgroup/subsystem_factory.h"
+#include "protocol/galaxy.pb.h"
+#include "util/path_tree.h"
+#include "util/util.h"
+
+#include "boost/bind.hpp"
+#include "boost/algorithm/string.hpp"
+#include "boost/lexical_cast/lexical_cast_old.hpp"
+#include "timer.h"
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+
+DECLARE_int32(warm_pool_max);
+DECLARE_int32(warm_pool_refill_interval);
+DECLARE_int32(warm_pool_demand_window);
+DECLARE_string(mount_templat);
+DECLARE_string(mount_cgroups);
+
+namespace baidu {
+namespace galaxy {
+namespace container {
+
+static const std::string kWarmPrefix = "galaxy_warm_";
+static const size_t kRecentCgroups = 64;
+static const int64_t kReportInterval = 60000000L;
+
+WarmPool::WarmPool() :
+    seq_(0),
+    running_(false),
+    last_report_time_(0),
+    refill_pool_(1) {
+}
+
+WarmPool::~WarmPool() {
+    Stop();
+}
+
+bool WarmPool::Enabled() const {
+    return FLAGS_warm_pool_max > 0;
+}
+
+void WarmPool::Setup() {
+    if (!Enabled()) {
+        return;
+    }
+
+    baidu::galaxy::cgroup::SubsystemFactory::GetInstance()->GetSubsystems(subsystems_);
+    CleanLeftover();
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        running_ = true;
+        last_report_time_ = baidu::common::timer::get_micros();
+    }
+    refill_pool_.AddTask(boost::bind(&WarmPool::RefillRoutine, this));
+    LOG(INFO) << "warm pool is set up, max size: " << FLAGS_warm_pool_max;
+}
+
+void WarmPool::Stop() {
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    refill_pool_.Stop(true);
+    boost::mutex::scoped_lock lock(mutex_);
+    while (!entries_.empty()) {
+        Drop(entries_.front());
+        entries_.pop_front();
+    }
+}
+
+bool WarmPool::Claim(const std::string& container_id,
+        const baidu::galaxy::proto::ContainerDescription& desc) {
+    if (!Enabled()) {
+        return false;
+    }
+
+    Entry entry;
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (!demand_.empty()) {
+            demand_.back()++;
+        }
+        recent_cgroups_.push_back(desc.cgroups_size());
+        if (recent_cgroups_.size() > kRecentCgroups) {
+            recent_cgroups_.pop_front();
+        }
+
+        if (!running_ || entries_.empty()) {
+            return false;
+        }
+        entry = entries_.front();
+        entries_.pop_front();
+    }
+
+    // resize the entry to the cgroups of the container, a failed claim is
+    // undone so that the container is constructed cold on clean paths
+    std::vector<std::string> claimed;
+    bool ok = true;
+    for (int32_t i = 0; ok && i < entry.cgroups_; i++) {
+        const std::string slot = entry.name_ + "_" + boost::lexical_cast<std::string>(i);
+        for (size_t j = 0; j < subsystems_.size(); j++) {
+            boost::system::error_code ec;
+            std::string from = CgroupPath(subsystems_[j], slot);
+            if (i < desc.cgroups_size()) {
+                std::string to = CgroupPath(subsystems_[j], container_id + "_" + desc.cgroups(i).id());
+                boost::filesystem::rename(from, to, ec);
+                if (ec.value() == 0) {
+                    claimed.push_back(to);
+                }
+            } else {
+                boost::filesystem::remove(from, ec);
+            }
+
+            if (ec.value() != 0) {
+                LOG(WARNING) << "failed in claiming warm cgroup " << from
+                             << " for container " << container_id << ": " << ec.message();
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    if (ok) {
+        boost::system::error_code ec;
+        boost::filesystem::rename(baidu::galaxy::path::ContainerRootPath(entry.name_),
+                baidu::galaxy::path::ContainerRootPath(container_id), ec);
+
+        if (ec.value() != 0) {
+            LOG(WARNING) << "failed in claiming warm root for container " << container_id
+                         << ": " << ec.message();
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        boost::system::error_code ec;
+        for (size_t i = 0; i < claimed.size(); i++) {
+            boost::filesystem::remove(claimed[i], ec);
+        }
+        Drop(entry);
+        return false;
+    }
+
+    VLOG(10) << container_id << " claims warm entry " << entry.name_
+             << " with " << entry.cgroups_ << " cgroups";
+    return true;
+}
+
+void WarmPool::RecordLatency(bool warm, int64_t latency_us) {
+    boost::mutex::scoped_lock lock(mutex_);
+    if (warm) {
+        warm_latency_.Add(latency_us);
+    } else {
+        cold_latency_.Add(latency_us);
+    }
+}
+
+void WarmPool::RefillRoutine() {
+    int32_t target = 0;
+    int32_t cgroups = 0;
+    int32_t size = 0;
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (!running_) {
+            return;
+        }
+
+        target = TargetSize();
+        cgroups = TargetCgroups();
+        size = entries_.size();
+
+        // shrink slowly so that a short lull does not throw the pool away
+        if (size > target) {
+            Drop(entries_.back());
+            entries_.pop_back();
+            size--;
+        }
+
+        demand_.push_back(0);
+        while ((int32_t)demand_.size() > std::max(FLAGS_warm_pool_demand_window, 1)) {
+            demand_.pop_front();
+        }
+
+        int64_t now = baidu::common::timer::get_micros();
+        if (now - last_report_time_ > kReportInterval) {
+            LOG(INFO) << "warm pool size: " << size << ", target: " << target;
+            LOG(INFO) << "create latency with warm pool, " << warm_latency_.ToString();
+            LOG(INFO) << "create latency without warm pool, " << cold_latency_.ToString();
+            last_report_time_ = now;
+        }
+    }
+
+    // build outside the lock, claims are never blocked by refilling
+    for (; size < target; size++) {
+        Entry entry;
+        entry.cgroups_ = cgroups;
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+            entry.name_ = kWarmPrefix + boost::lexical_cast<std::string>(seq_++);
+        }
+
+        baidu::galaxy::util::ErrorCode ec = Build(entry);
+        if (0 != ec.Code()) {
+            LOG(WARNING) << "failed in building warm entry " << entry.name_ << ": " << ec.Message();
+            Drop(entry);
+            break;
+        }
+
+        boost::mutex::scoped_lock lock(mutex_);
+        entries_.push_back(entry);
+    }
+
+    refill_pool_.DelayTask(FLAGS_warm_pool_refill_interval,
+            boost::bind(&WarmPool::RefillRoutine, this));
+}
+
+baidu::galaxy::util::ErrorCode WarmPool::Build(const Entry& entry) {
+    boost::system::error_code ec;
+    for (int32_t i = 0; i < entry.cgroups_; i++) {
+        const std::string slot = entry.name_ + "_" + boost::lexical_cast<std::string>(i);
+        for (size_t j = 0; j < subsystems_.size(); j++) {
+            boost::filesystem::path path(CgroupPath(subsystems_[j], slot));
+            if (!baidu::galaxy::file::create_directories(path, ec)) {
+                return ERRORCODE(-1, "failed in creating %s: %s",
+                        path.string().c_str(),
+                        ec.message().c_str());
+            }
+        }
+    }
+
+    // skeleton of the mount points, mounting is left to the appworker namespace
+    std::vector<std::string> dirs;
+    boost::split(dirs, FLAGS_mount_templat + "," + FLAGS_mount_cgroups, boost::is_any_of(","));
+    std::string root_path = baidu::galaxy::path::ContainerRootPath(entry.name_);
+    dirs.push_back("");
+
+    for (size_t i = 0; i < dirs.size(); i++) {
+        boost::filesystem::path path(root_path);
+        if (!dirs[i].empty()) {
+            path.append(dirs[i]);
+        }
+
+        if (!boost::filesystem::exists(path, ec)
+                && !baidu::galaxy::file::create_directories(path, ec)) {
+            return ERRORCODE(-1, "failed in creating %s: %s",
+                    path.string().c_str(),
+                    ec.message().c_str());
+        }
+    }
+
+    return ERRORCODE_OK;
+}
+
+void WarmPool::Drop(const Entry& entry) {
+    boost::system::error_code ec;
+    for (int32_t i = 0; i < entry.cgroups_; i++) {
+        const std::string slot = entry.name_ + "_" + boost::lexical_cast<std::string>(i);
+        for (size_t j = 0; j < subsystems_.size(); j++) {
+            boost::filesystem::remove(CgroupPath(subsystems_[j], slot), ec);
+        }
+    }
+    boost::filesystem::remove_all(baidu::galaxy::path::ContainerRootPath(entry.name_), ec);
+}
+
+void WarmPool::CleanLeftover() {
+    std::vector<boost::filesystem::path> dirs;
+    for (size_t i = 0; i < subsystems_.size(); i++) {
+        boost::filesystem::path path(baidu::galaxy::cgroup::Subsystem::RootPath(subsystems_[i]));
+        path.append("galaxy");
+        dirs.push_back(path);
+    }
+    dirs.push_back(boost::filesystem::path(baidu::galaxy::path::WorkDir()));
+
+    for (size_t i = 0; i < dirs.size(); i++) {
+        boost::system::error_code ec;
+        if (!boost::filesystem::exists(dirs[i], ec)) {
+            continue;
+        }
+
+        boost::filesystem::directory_iterator end;
+        std::vector<boost::filesystem::path> leftover;
+        for (boost::filesystem::directory_iterator iter(dirs[i], ec); iter != end; iter++) {
+            if (iter->path().filename().string().compare(0, kWarmPrefix.size(), kWarmPrefix) == 0) {
+                leftover.push_back(iter->path());
+            }
+        }
+
+        for (size_t j = 0; j < leftover.size(); j++) {
+            // cgroup dirs only go with rmdir, root skeletons are plain dirs
+            if (i + 1 < dirs.size()) {
+                boost::filesystem::remove(leftover[j], ec);
+            } else {
+                boost::filesystem::remove_all(leftover[j], ec);
+            }
+            LOG(INFO) << "remove leftover warm entry " << leftover[j].string();
+        }
+    }
+}
+
+int32_t WarmPool::TargetSize() {
+    int32_t peak = 0;
+    for (size_t i = 0; i < demand_.size(); i++) {
+        peak = std::max(peak, demand_[i]);
+    }
+    return std::min(peak, FLAGS_warm_pool_max);
+}
+
+int32_t WarmPool::TargetCgroups() {
+    std::map<int32_t, int32_t> histogram;
+    int32_t cgroups = 1;
+    int32_t most = 0;
+    for (size_t i = 0; i < recent_cgroups_.size(); i++) {
+        int32_t count = ++histogram[recent_cgroups_[i]];
+        if (count > most) {
+            most = count;
+            cgroups = recent_cgroups_[i];
+        }
+    }
+    return cgroups;
+}
+
+std::string WarmPool::CgroupPath(const std::string& subsystem, const std::string& name) {
+    boost::filesystem::path path(baidu::galaxy::cgroup::Subsystem::RootPath(subsystem));
+    path.append("galaxy");
+    path.append(name);
+    return path.string();
+}
+
+} //namespace container
+} //namespace galaxy
+} //namespace baidu
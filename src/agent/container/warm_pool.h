@@ -0,0 +1,80 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+#include "util/error_code.h"
+#include "latency_histogram.h"
+
+#include "boost/thread/mutex.hpp"
+#include "thread_pool.h"
+
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace baidu {
+namespace galaxy {
+namespace proto {
+class ContainerDescription;
+}
+
+namespace container {
+
+// Keeps cgroup directories in every hierarchy and container root skeletons
+// built ahead of time, a create request claims one by renaming it to the
+// names of the container. The pool follows the recent create demand.
+class WarmPool {
+public:
+    WarmPool();
+    ~WarmPool();
+
+    void Setup();
+    void Stop();
+    bool Enabled() const;
+
+    // true if a warm entry is renamed to the container, the cgroups it
+    // lacks are left to the normal construction
+    bool Claim(const std::string& container_id,
+            const baidu::galaxy::proto::ContainerDescription& desc);
+    void RecordLatency(bool warm, int64_t latency_us);
+
+private:
+    class Entry {
+    public:
+        Entry() : cgroups_(0) {}
+        std::string name_;
+        int32_t cgroups_;
+    };
+
+    void RefillRoutine();
+    baidu::galaxy::util::ErrorCode Build(const Entry& entry);
+    void Drop(const Entry& entry);
+    void CleanLeftover();
+    int32_t TargetSize();
+    int32_t TargetCgroups();
+    std::string CgroupPath(const std::string& subsystem, const std::string& name);
+
+    boost::mutex mutex_;
+    std::deque<Entry> entries_;
+    int64_t seq_;
+    bool running_;
+    std::vector<std::string> subsystems_;
+
+    // creates in each refill interval, the latest one is at the back
+    std::deque<int32_t> demand_;
+    // cgroup number of the recent creates
+    std::deque<int32_t> recent_cgroups_;
+
+    LatencyHistogram warm_latency_;
+    LatencyHistogram cold_latency_;
+    int64_t last_report_time_;
+    baidu::common::ThreadPool refill_pool_;
+};
+
+} //namespace container
+} //namespace galaxy
+} //namespace baidu
@@ -0,0 +1,180 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "fetch_relay.h"
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+DECLARE_string(agent_ip);
+DECLARE_string(agent_port);
+DECLARE_string(appmaster_path);
+DECLARE_int32(fetch_relay_interval);
+DECLARE_int32(fetch_relay_timeout);
+
+namespace baidu {
+namespace galaxy {
+
+FetchRelay::FetchRelay() :
+    running_(false),
+    fetches_(new std::vector<Fetch>()),
+    appmaster_stub_(NULL),
+    rpc_(new baidu::galaxy::RpcClient()),
+    agent_endpoint_(FLAGS_agent_ip + ":" + FLAGS_agent_port),
+    flush_pool_(1)
+{
+}
+
+FetchRelay::~FetchRelay()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        running_ = false;
+    }
+    flush_pool_.Stop(true);
+
+    boost::mutex::scoped_lock lock(mutex_);
+    for (size_t i = 0; i < fetches_->size(); i++) {
+        Fail((*fetches_)[i], "fetch relay stopped");
+    }
+    fetches_->clear();
+    delete appmaster_stub_;
+}
+
+void FetchRelay::Setup()
+{
+    if (FLAGS_appmaster_path.empty()) {
+        LOG(INFO) << "appmaster path is not set, fetches of appworkers are not relayed";
+        return;
+    }
+
+    watcher_.reset(new baidu::galaxy::MasterWatcher(FLAGS_appmaster_path));
+    if (!watcher_->Init(boost::bind(&FetchRelay::HandleAppMasterChange, this, _1))) {
+        LOG(FATAL) << "init appmaster watch failed, agent will exit ...";
+        exit(1);
+    }
+
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        running_ = true;
+    }
+    flush_pool_.DelayTask(FLAGS_fetch_relay_interval, boost::bind(&FetchRelay::FlushRoutine, this));
+    LOG(INFO) << "fetch relay is set up, interval is " << FLAGS_fetch_relay_interval << "ms";
+}
+
+void FetchRelay::HandleAppMasterChange(const std::string& new_endpoint)
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    if (new_endpoint.empty()) {
+        LOG(WARNING) << "endpoint of appmaster is deleted from nexus";
+    }
+
+    if (new_endpoint == appmaster_endpoint_ && NULL != appmaster_stub_) {
+        return;
+    }
+
+    LOG(INFO) << "appmaster changes to " << new_endpoint;
+    appmaster_endpoint_ = new_endpoint;
+    delete appmaster_stub_;
+    appmaster_stub_ = NULL;
+
+    if (!appmaster_endpoint_.empty() && !rpc_->GetStub(appmaster_endpoint_, &appmaster_stub_)) {
+        LOG(WARNING) << "connect appmaster failed: " << appmaster_endpoint_;
+    }
+}
+
+void FetchRelay::FetchTask(::google::protobuf::RpcController* controller,
+        const ::baidu::galaxy::proto::FetchTaskRequest* request,
+        ::baidu::galaxy::proto::FetchTaskResponse* response,
+        ::google::protobuf::Closure* done)
+{
+    Fetch fetch;
+    fetch.controller = controller;
+    fetch.request = request;
+    fetch.response = response;
+    fetch.done = done;
+
+    boost::mutex::scoped_lock lock(mutex_);
+    if (!running_) {
+        Fail(fetch, "fetch relay is not running");
+        return;
+    }
+    fetches_->push_back(fetch);
+}
+
+void FetchRelay::FlushRoutine()
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    if (!running_) {
+        return;
+    }
+
+    if (!fetches_->empty()) {
+        FetchList fetches = fetches_;
+        fetches_.reset(new std::vector<Fetch>());
+
+        if (NULL == appmaster_stub_) {
+            for (size_t i = 0; i < fetches->size(); i++) {
+                Fail((*fetches)[i], "appmaster is unknown");
+            }
+        } else {
+            baidu::galaxy::proto::BatchFetchTaskRequest* request =
+                new baidu::galaxy::proto::BatchFetchTaskRequest();
+            baidu::galaxy::proto::BatchFetchTaskResponse* response =
+                new baidu::galaxy::proto::BatchFetchTaskResponse();
+            request->set_endpoint(agent_endpoint_);
+            for (size_t i = 0; i < fetches->size(); i++) {
+                request->add_requests()->CopyFrom(*(*fetches)[i].request);
+            }
+
+            VLOG(10) << "relay fetches of " << fetches->size() << " pods to " << appmaster_endpoint_;
+            boost::function<void (const baidu::galaxy::proto::BatchFetchTaskRequest*,
+                    baidu::galaxy::proto::BatchFetchTaskResponse*, bool, int)> callback;
+            callback = boost::bind(&FetchRelay::FlushCallback, this, fetches, _1, _2, _3, _4);
+            rpc_->AsyncRequest(appmaster_stub_,
+                    &baidu::galaxy::proto::AppMaster_Stub::BatchFetchTask,
+                    request, response, callback,
+                    FLAGS_fetch_relay_timeout, 0);
+        }
+    }
+
+    flush_pool_.DelayTask(FLAGS_fetch_relay_interval, boost::bind(&FetchRelay::FlushRoutine, this));
+}
+
+void FetchRelay::FlushCallback(FetchList fetches,
+        const ::baidu::galaxy::proto::BatchFetchTaskRequest* request,
+        ::baidu::galaxy::proto::BatchFetchTaskResponse* response,
+        bool failed, int error)
+{
+    boost::scoped_ptr<const baidu::galaxy::proto::BatchFetchTaskRequest> request_ptr(request);
+    boost::scoped_ptr<baidu::galaxy::proto::BatchFetchTaskResponse> response_ptr(response);
+
+    if (!failed && response->responses_size() != (int)fetches->size()) {
+        LOG(WARNING) << "appmaster replies " << response->responses_size()
+                     << " of " << fetches->size() << " relayed fetches";
+        failed = true;
+    }
+
+    for (size_t i = 0; i < fetches->size(); i++) {
+        Fetch& fetch = (*fetches)[i];
+        if (failed) {
+            Fail(fetch, "relayed fetch failed");
+        } else {
+            fetch.response->Swap(response->mutable_responses(i));
+            fetch.done->Run();
+        }
+    }
+}
+
+void FetchRelay::Fail(const Fetch& fetch, const std::string& reason)
+{
+    // appworkers take it as an rpc failure and look up appmaster again
+    fetch.controller->SetFailed(reason);
+    fetch.done->Run();
+}
+
+}
+}
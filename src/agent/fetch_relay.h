@@ -0,0 +1,65 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "src/protocol/appmaster.pb.h"
+#include "master_watcher.h"
+#include "thread_pool.h"
+#include "rpc/rpc_client.h"
+#include "boost/scoped_ptr.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/mutex.hpp"
+
+namespace baidu {
+namespace galaxy {
+
+// Serves FetchTask of appworkers on the host in place of appmaster. Fetches
+// queue up and go to appmaster in one BatchFetchTask rpc per tick, replies
+// are fanned back out to the waiting appworkers. The appmaster endpoint is
+// followed by one nexus watch for the whole host.
+class FetchRelay : public baidu::galaxy::proto::AppMaster {
+public:
+    FetchRelay();
+    virtual ~FetchRelay();
+
+    void Setup();
+
+    void FetchTask(::google::protobuf::RpcController* controller,
+            const ::baidu::galaxy::proto::FetchTaskRequest* request,
+            ::baidu::galaxy::proto::FetchTaskResponse* response,
+            ::google::protobuf::Closure* done);
+
+private:
+    struct Fetch {
+        ::google::protobuf::RpcController* controller;
+        const ::baidu::galaxy::proto::FetchTaskRequest* request;
+        ::baidu::galaxy::proto::FetchTaskResponse* response;
+        ::google::protobuf::Closure* done;
+    };
+    typedef boost::shared_ptr<std::vector<Fetch> > FetchList;
+
+    void HandleAppMasterChange(const std::string& new_endpoint);
+    void FlushRoutine();
+    void FlushCallback(FetchList fetches,
+            const ::baidu::galaxy::proto::BatchFetchTaskRequest* request,
+            ::baidu::galaxy::proto::BatchFetchTaskResponse* response,
+            bool failed, int error);
+    void Fail(const Fetch& fetch, const std::string& reason);
+
+    boost::mutex mutex_;
+    bool running_;
+    FetchList fetches_;
+    std::string appmaster_endpoint_;
+    baidu::galaxy::proto::AppMaster_Stub* appmaster_stub_;
+    boost::scoped_ptr<baidu::galaxy::RpcClient> rpc_;
+    boost::scoped_ptr<baidu::galaxy::MasterWatcher> watcher_;
+    const std::string agent_endpoint_;
+    baidu::common::ThreadPool flush_pool_;
+};
+
+}
+}
@@ -13,7 +13,12 @@ DECLARE_string(nexus_servers);
 namespace baidu {
 namespace galaxy {
 
-MasterWatcher::MasterWatcher() : nexus_(NULL)
+MasterWatcher::MasterWatcher() : nexus_(NULL), path_(FLAGS_master_path)
+{
+    nexus_ =  new InsSDK(FLAGS_nexus_servers);
+}
+
+MasterWatcher::MasterWatcher(const std::string& path) : nexus_(NULL), path_(path)
 {
     nexus_ =  new InsSDK(FLAGS_nexus_servers);
 }
@@ -48,7 +53,7 @@ void MasterWatcher::EventMasterChange(const ::galaxy::ins::sdk::WatchParam& para
 
 bool MasterWatcher::IssueNewWatch()
 {
-    std::string master_path_key = FLAGS_nexus_root_path + FLAGS_master_path;
+    std::string master_path_key = FLAGS_nexus_root_path + path_;
     ::galaxy::ins::sdk::SDKError err;
     bool ok = nexus_->Watch(master_path_key, &EventMasterChange, this, &err);
     if (!ok) {
@@ -18,6 +18,8 @@ using ::galaxy::ins::sdk::InsSDK;
 class MasterWatcher {
 public:
     MasterWatcher();
+    // watches the endpoint under path instead of the one of RM
+    explicit MasterWatcher(const std::string& path);
     ~MasterWatcher();
     bool Init(boost::function<void(const std::string& new_master_endpoint)> handler);
     std::string GetMasterEndpoint();
@@ -29,6 +31,7 @@ private:
 
 
     InsSDK* nexus_;
+    std::string path_;
     std::string master_endpoint_;
     Mutex mutex_;
     boost::function<void(const std::string& new_master_endpoint)> handler_;
@@ -25,6 +25,16 @@ public:
         return 0;
     }
 
+    // cores dedicated to exclusive cgroups are not shared
+    int Exclude(uint64_t milli_cores) {
+        if (milli_cores > total_) {
+            return -1;
+        }
+
+        total_ -= milli_cores;
+        return 0;
+    }
+
     int Allocate(uint64_t milli_cores) {
         if (assigned_ + milli_cores > total_) {
             return -1;
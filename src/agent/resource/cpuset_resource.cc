@@ -0,0 +1,301 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "cpuset_resource.h"
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string.hpp>
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <vector>
+
+DECLARE_string(cpuset_exclusive_cores);
+
+namespace baidu {
+namespace galaxy {
+namespace resource {
+
+static const std::string kCpuOnlinePath = "/sys/devices/system/cpu/online";
+static const std::string kNumaNodePath = "/sys/devices/system/node";
+
+static bool ReadLine(const std::string& file, std::string& line) {
+    std::ifstream in(file.c_str());
+    if (!in.is_open() || !std::getline(in, line)) {
+        return false;
+    }
+    boost::trim(line);
+    return true;
+}
+
+CpusetResource::CpusetResource() {
+}
+
+CpusetResource::~CpusetResource() {
+}
+
+int CpusetResource::Load() {
+    cpu_node_.clear();
+    total_.clear();
+    free_.clear();
+    shared_cpus_.clear();
+
+    if (FLAGS_cpuset_exclusive_cores.empty()) {
+        return 0;
+    }
+
+    std::set<int32_t> exclusive;
+    if (!ParseCpuList(FLAGS_cpuset_exclusive_cores, exclusive) || exclusive.empty()) {
+        LOG(WARNING) << "bad cpuset_exclusive_cores: " << FLAGS_cpuset_exclusive_cores;
+        return -1;
+    }
+
+    std::string line;
+    std::set<int32_t> online;
+    if (!ReadLine(kCpuOnlinePath, line) || !ParseCpuList(line, online)) {
+        LOG(WARNING) << "failed in reading online cpus from " << kCpuOnlinePath;
+        return -1;
+    }
+
+    if (0 != LoadTopology(online)) {
+        return -1;
+    }
+
+    std::set<int32_t> shared;
+    for (std::set<int32_t>::const_iterator it = online.begin(); it != online.end(); ++it) {
+        if (exclusive.find(*it) == exclusive.end()) {
+            shared.insert(*it);
+        }
+    }
+
+    for (std::set<int32_t>::const_iterator it = exclusive.begin(); it != exclusive.end(); ++it) {
+        std::map<int32_t, int32_t>::const_iterator node = cpu_node_.find(*it);
+        if (node == cpu_node_.end()) {
+            LOG(WARNING) << "exclusive core " << *it << " is not online";
+            return -1;
+        }
+        total_[node->second].insert(*it);
+    }
+
+    if (shared.empty()) {
+        LOG(WARNING) << "no core is left for shared cgroups";
+        return -1;
+    }
+
+    free_ = total_;
+    shared_cpus_ = FormatCpuList(shared);
+    for (std::map<int32_t, std::set<int32_t> >::const_iterator it = total_.begin();
+            it != total_.end(); ++it) {
+        LOG(INFO) << "numa node " << it->first << " exclusive cores: "
+                  << FormatCpuList(it->second);
+    }
+    LOG(INFO) << "shared cores: " << shared_cpus_;
+    return 0;
+}
+
+int32_t CpusetResource::ExclusiveCores() const {
+    int32_t cores = 0;
+    for (std::map<int32_t, std::set<int32_t> >::const_iterator it = total_.begin();
+            it != total_.end(); ++it) {
+        cores += it->second.size();
+    }
+    return cores;
+}
+
+int CpusetResource::LoadTopology(const std::set<int32_t>& online) {
+    boost::filesystem::path node_root(kNumaNodePath);
+    boost::system::error_code ec;
+
+    if (boost::filesystem::exists(node_root, ec)) {
+        boost::filesystem::directory_iterator end;
+        for (boost::filesystem::directory_iterator it(node_root, ec); it != end; ++it) {
+            const std::string name = it->path().filename().string();
+            if (name.size() <= 4 || name.compare(0, 4, "node") != 0
+                    || name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                continue;
+            }
+
+            int32_t node = atoi(name.c_str() + 4);
+            std::string line;
+            std::set<int32_t> cpus;
+            boost::filesystem::path cpulist = it->path();
+            cpulist.append("cpulist");
+            if (!ReadLine(cpulist.string(), line) || !ParseCpuList(line, cpus)) {
+                LOG(WARNING) << "failed in reading " << cpulist.string();
+                return -1;
+            }
+
+            for (std::set<int32_t>::const_iterator cpu = cpus.begin(); cpu != cpus.end(); ++cpu) {
+                cpu_node_[*cpu] = node;
+            }
+        }
+    }
+
+    // kernels without numa support expose no node, all cores are local then
+    for (std::set<int32_t>::const_iterator it = online.begin(); it != online.end(); ++it) {
+        if (cpu_node_.find(*it) == cpu_node_.end()) {
+            cpu_node_[*it] = 0;
+        }
+    }
+
+    return 0;
+}
+
+baidu::galaxy::util::ErrorCode CpusetResource::Allocate(int32_t cores,
+        int32_t& node,
+        std::string& cpu_set) {
+    if (cores <= 0) {
+        return ERRORCODE(-1, "invalid core number %d", cores);
+    }
+
+    std::map<int32_t, std::set<int32_t> >::iterator selected = free_.end();
+
+    if (node >= 0) {
+        selected = free_.find(node);
+        if (selected == free_.end() || (int32_t)selected->second.size() < cores) {
+            return ERRORCODE(-1, "no %d free cores on numa node %d", cores, node);
+        }
+    } else {
+        // best fit, keeps larger free sets for bigger requests
+        for (std::map<int32_t, std::set<int32_t> >::iterator it = free_.begin();
+                it != free_.end(); ++it) {
+            if ((int32_t)it->second.size() >= cores
+                    && (selected == free_.end() || it->second.size() < selected->second.size())) {
+                selected = it;
+            }
+        }
+
+        if (selected == free_.end()) {
+            return ERRORCODE(-1, "no numa node has %d free cores", cores);
+        }
+    }
+
+    std::set<int32_t> cpus;
+    std::set<int32_t>& free_cores = selected->second;
+    while ((int32_t)cpus.size() < cores) {
+        cpus.insert(*free_cores.begin());
+        free_cores.erase(free_cores.begin());
+    }
+
+    node = selected->first;
+    cpu_set = FormatCpuList(cpus);
+    return ERRORCODE_OK;
+}
+
+baidu::galaxy::util::ErrorCode CpusetResource::Assign(const std::string& cpu_set) {
+    std::set<int32_t> cpus;
+    if (!ParseCpuList(cpu_set, cpus)) {
+        return ERRORCODE(-1, "bad cpu set %s", cpu_set.c_str());
+    }
+
+    for (std::set<int32_t>::const_iterator it = cpus.begin(); it != cpus.end(); ++it) {
+        std::map<int32_t, int32_t>::const_iterator node = cpu_node_.find(*it);
+        if (node == cpu_node_.end() || free_[node->second].find(*it) == free_[node->second].end()) {
+            return ERRORCODE(-1, "core %d is not free", *it);
+        }
+    }
+
+    for (std::set<int32_t>::const_iterator it = cpus.begin(); it != cpus.end(); ++it) {
+        free_[cpu_node_[*it]].erase(*it);
+    }
+
+    return ERRORCODE_OK;
+}
+
+baidu::galaxy::util::ErrorCode CpusetResource::Release(const std::string& cpu_set) {
+    std::set<int32_t> cpus;
+    if (!ParseCpuList(cpu_set, cpus)) {
+        return ERRORCODE(-1, "bad cpu set %s", cpu_set.c_str());
+    }
+
+    for (std::set<int32_t>::const_iterator it = cpus.begin(); it != cpus.end(); ++it) {
+        std::map<int32_t, int32_t>::const_iterator node = cpu_node_.find(*it);
+        if (node == cpu_node_.end()
+                || total_[node->second].find(*it) == total_[node->second].end()) {
+            return ERRORCODE(-1, "core %d is not exclusive", *it);
+        }
+        free_[node->second].insert(*it);
+    }
+
+    return ERRORCODE_OK;
+}
+
+void CpusetResource::Resource(std::map<int32_t, Numa>& r) {
+    r.clear();
+    for (std::map<int32_t, std::set<int32_t> >::const_iterator it = total_.begin();
+            it != total_.end(); ++it) {
+        Numa& numa = r[it->first];
+        numa.total_ = it->second.size();
+        numa.free_ = free_[it->first].size();
+    }
+}
+
+bool CpusetResource::ParseCpuList(const std::string& list, std::set<int32_t>& cpus) {
+    std::vector<std::string> ranges;
+    boost::split(ranges, list, boost::is_any_of(","));
+
+    for (size_t i = 0; i < ranges.size(); i++) {
+        std::string range = boost::trim_copy(ranges[i]);
+        if (range.empty()) {
+            continue;
+        }
+
+        if (range.find_first_not_of("0123456789-") != std::string::npos) {
+            return false;
+        }
+
+        size_t dash = range.find('-');
+        int32_t first = atoi(range.substr(0, dash).c_str());
+        int32_t last = first;
+        if (dash != std::string::npos) {
+            last = atoi(range.substr(dash + 1).c_str());
+        }
+
+        if (first < 0 || last < first) {
+            return false;
+        }
+
+        for (int32_t cpu = first; cpu <= last; cpu++) {
+            cpus.insert(cpu);
+        }
+    }
+
+    return true;
+}
+
+std::string CpusetResource::FormatCpuList(const std::set<int32_t>& cpus) {
+    std::string list;
+    std::set<int32_t>::const_iterator it = cpus.begin();
+
+    while (it != cpus.end()) {
+        int32_t first = *it;
+        int32_t last = first;
+        ++it;
+        while (it != cpus.end() && *it == last + 1) {
+            last = *it;
+            ++it;
+        }
+
+        if (!list.empty()) {
+            list += ",";
+        }
+
+        char buf[32];
+        if (first == last) {
+            snprintf(buf, sizeof(buf), "%d", first);
+        } else {
+            snprintf(buf, sizeof(buf), "%d-%d", first, last);
+        }
+        list += buf;
+    }
+
+    return list;
+}
+
+}
+}
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+#include "util/error_code.h"
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace baidu {
+namespace galaxy {
+namespace resource {
+
+// whole cores which can be dedicated to one cgroup, grouped by numa node.
+// cores not listed in --cpuset_exclusive_cores stay shared by other cgroups
+class CpusetResource {
+public:
+    class Numa {
+    public:
+        Numa() :
+            total_(0),
+            free_(0) {}
+
+        int32_t total_;
+        int32_t free_;
+    };
+
+public:
+    CpusetResource();
+    ~CpusetResource();
+    int Load();
+
+    bool Enabled() const {
+        return !total_.empty();
+    }
+
+    const std::string& SharedCpus() const {
+        return shared_cpus_;
+    }
+
+    int32_t ExclusiveCores() const;
+
+    // take cores on node, or on the best fitting node when node < 0
+    baidu::galaxy::util::ErrorCode Allocate(int32_t cores, int32_t& node, std::string& cpu_set);
+    // take exactly the cores of cpu_set again, used when reloading containers
+    baidu::galaxy::util::ErrorCode Assign(const std::string& cpu_set);
+    baidu::galaxy::util::ErrorCode Release(const std::string& cpu_set);
+    void Resource(std::map<int32_t, Numa>& r);
+
+    // cpu list format of cpuset and sysfs, eg: 0-3,8,10-11
+    static bool ParseCpuList(const std::string& list, std::set<int32_t>& cpus);
+    static std::string FormatCpuList(const std::set<int32_t>& cpus);
+
+private:
+    int LoadTopology(const std::set<int32_t>& online);
+    std::map<int32_t, int32_t> cpu_node_;
+    std::map<int32_t, std::set<int32_t> > total_;
+    std::map<int32_t, std::set<int32_t> > free_;
+    std::string shared_cpus_;
+};
+
+}
+}
+}
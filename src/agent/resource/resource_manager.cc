@@ -20,7 +20,8 @@ namespace resource {
 ResourceManager::ResourceManager() :
     cpu_(new CpuResource()),
     memory_(new MemoryResource()),
-    volum_(new VolumResource()) {
+    volum_(new VolumResource()),
+    cpuset_(new CpusetResource()) {
 }
 
 ResourceManager::~ResourceManager() {
@@ -42,6 +43,16 @@ int ResourceManager::Load() {
         return -1;
     }
 
+    if (0 != cpuset_->Load()) {
+        LOG(WARNING) << "load cpuset resource failed";
+        return -1;
+    }
+
+    if (0 != cpu_->Exclude(cpuset_->ExclusiveCores() * 1000L)) {
+        LOG(WARNING) << "cpu_resource is less than the exclusive cores";
+        return -1;
+    }
+
     return 0;
 }
 
@@ -137,6 +148,75 @@ baidu::galaxy::util::ErrorCode ResourceManager::Release(const baidu::galaxy::pro
     return ERRORCODE_OK;
 }
 
+baidu::galaxy::util::ErrorCode ResourceManager::AllocateCpuset(baidu::galaxy::proto::ContainerDescription& desc) {
+    boost::mutex::scoped_lock lock(mutex_);
+    std::vector<std::string> allocated;
+    baidu::galaxy::util::ErrorCode ec = ERRORCODE_OK;
+
+    for (int i = 0; i < desc.cgroups_size(); i++) {
+        baidu::galaxy::proto::CpuRequired* cpu = desc.mutable_cgroups(i)->mutable_cpu();
+
+        if (!cpu->exclusive()) {
+            // shared cgroups keep off the cores which may be dedicated
+            if (cpuset_->Enabled()) {
+                cpu->set_cpu_set(cpuset_->SharedCpus());
+            }
+            continue;
+        }
+
+        if (!cpuset_->Enabled()) {
+            ec = ERRORCODE(-1, "exclusive cpu is not supported on this agent");
+            break;
+        }
+
+        if (!cpu->cpu_set().empty()) {
+            // reloaded container, cores were bound before
+            ec = cpuset_->Assign(cpu->cpu_set());
+        } else {
+            int32_t cores = (cpu->milli_core() + 999) / 1000;
+            int32_t node = cpu->has_numa_node() ? cpu->numa_node() : -1;
+            std::string cpu_set;
+            ec = cpuset_->Allocate(cores, node, cpu_set);
+            if (0 == ec.Code()) {
+                cpu->set_numa_node(node);
+                cpu->set_cpu_set(cpu_set);
+            }
+        }
+
+        if (0 != ec.Code()) {
+            break;
+        }
+        allocated.push_back(cpu->cpu_set());
+    }
+
+    if (0 != ec.Code()) {
+        for (size_t i = 0; i < allocated.size(); i++) {
+            cpuset_->Release(allocated[i]);
+        }
+        return ERRORCODE(-1, "allocate cpuset failed: %s", ec.Message().c_str());
+    }
+
+    return ERRORCODE_OK;
+}
+
+baidu::galaxy::util::ErrorCode ResourceManager::ReleaseCpuset(const baidu::galaxy::proto::ContainerDescription& desc) {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    for (int i = 0; i < desc.cgroups_size(); i++) {
+        const baidu::galaxy::proto::CpuRequired& cpu = desc.cgroups(i).cpu();
+        if (!cpu.exclusive() || cpu.cpu_set().empty()) {
+            continue;
+        }
+
+        baidu::galaxy::util::ErrorCode ec = cpuset_->Release(cpu.cpu_set());
+        if (0 != ec.Code()) {
+            return ERRORCODE(-1, "release cpuset failed: %s", ec.Message().c_str());
+        }
+    }
+
+    return ERRORCODE_OK;
+}
+
 int ResourceManager::Resource(boost::shared_ptr<void> resource) {
     assert(0);
     return -1;
@@ -178,6 +258,24 @@ void ResourceManager::GetVolumResource(std::vector<boost::shared_ptr<baidu::gala
     }
 }
 
+void ResourceManager::GetNumaResource(std::vector<boost::shared_ptr<baidu::galaxy::proto::NumaNodeResource> >& resource) {
+    std::map<int32_t, baidu::galaxy::resource::CpusetResource::Numa> m;
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        cpuset_->Resource(m);
+    }
+    std::map<int32_t, baidu::galaxy::resource::CpusetResource::Numa>::iterator iter = m.begin();
+
+    while (iter != m.end()) {
+        boost::shared_ptr<baidu::galaxy::proto::NumaNodeResource> nr(new baidu::galaxy::proto::NumaNodeResource());
+        nr->set_node(iter->first);
+        nr->set_total_cores(iter->second.total_);
+        nr->set_free_cores(iter->second.free_);
+        resource.push_back(nr);
+        iter++;
+    }
+}
+
 void ResourceManager::CalResource(const baidu::galaxy::proto::ContainerDescription& desc,
         int64_t& cpu_millicores,
         int64_t& memroy_require,
@@ -189,7 +287,10 @@ void ResourceManager::CalResource(const baidu::galaxy::proto::ContainerDescripti
     for (int i = 0; i < desc.cgroups_size(); i++) {
         if (desc.priority() != proto::kJobBestEffort) {
             memroy_require += desc.cgroups(i).memory().size();
-            cpu_millicores += desc.cgroups(i).cpu().milli_core();
+            // exclusive cgroups take whole cores from cpuset_ instead
+            if (!desc.cgroups(i).cpu().exclusive()) {
+                cpu_millicores += desc.cgroups(i).cpu().milli_core();
+            }
         }
     }
 
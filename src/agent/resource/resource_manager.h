@@ -4,6 +4,7 @@
 
 #pragma once
 #include "cpu_resource.h"
+#include "cpuset_resource.h"
 #include "memory_resource.h"
 #include "volum_resource.h"
 
@@ -20,6 +21,7 @@ namespace galaxy {
 namespace proto {
 class ContainerDescription;
 class VolumRequired;
+class NumaNodeResource;
 }
 
 namespace resource {
@@ -34,11 +36,15 @@ public:
 
     baidu::galaxy::util::ErrorCode Allocate(const baidu::galaxy::proto::ContainerDescription& desc);
     baidu::galaxy::util::ErrorCode Release(const baidu::galaxy::proto::ContainerDescription& desc);
+    // bind cores to the cgroups of desc, the cores are recorded in desc
+    baidu::galaxy::util::ErrorCode AllocateCpuset(baidu::galaxy::proto::ContainerDescription& desc);
+    baidu::galaxy::util::ErrorCode ReleaseCpuset(const baidu::galaxy::proto::ContainerDescription& desc);
     int Resource(boost::shared_ptr<void> resource);
 
     boost::shared_ptr<baidu::galaxy::proto::Resource> GetCpuResource();
     boost::shared_ptr<baidu::galaxy::proto::Resource> GetMemoryResource();
     void GetVolumResource(std::vector<boost::shared_ptr<baidu::galaxy::proto::VolumResource> >& resource);
+    void GetNumaResource(std::vector<boost::shared_ptr<baidu::galaxy::proto::NumaNodeResource> >& resource);
 
 private:
     baidu::galaxy::util::ErrorCode Allocate(std::vector<const baidu::galaxy::proto::VolumRequired*>& vv);
@@ -50,6 +56,7 @@ private:
     boost::scoped_ptr<CpuResource> cpu_;
     boost::scoped_ptr<MemoryResource> memory_;
     boost::scoped_ptr<VolumResource> volum_;
+    boost::scoped_ptr<CpusetResource> cpuset_;
 
 };
 
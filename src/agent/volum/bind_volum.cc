@@ -37,6 +37,14 @@ baidu::galaxy::util::ErrorCode BindVolum::Construct() {
     return err;
 }
 
+baidu::galaxy::util::ErrorCode BindVolum::Restore(int64_t used) {
+    vc_.reset(new VolumCollector(this->SourcePath()));
+    vc_->Restore(used);
+    vc_->Enable(true);
+    baidu::galaxy::collector::CollectorEngine::GetInstance()->Register(vc_);
+    return ERRORCODE_OK;
+}
+
 baidu::galaxy::util::ErrorCode BindVolum::Construct_() {
     const boost::shared_ptr<baidu::galaxy::proto::VolumRequired> vr = Description();
     assert(vr->medium() == baidu::galaxy::proto::kDisk
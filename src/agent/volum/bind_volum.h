@@ -17,6 +17,7 @@ public:
     ~BindVolum();
 
     baidu::galaxy::util::ErrorCode Construct();
+    baidu::galaxy::util::ErrorCode Restore(int64_t used);
     baidu::galaxy::util::ErrorCode Destroy();
     baidu::galaxy::util::ErrorCode Gc();
     int64_t Used();
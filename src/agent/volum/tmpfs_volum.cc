@@ -38,6 +38,14 @@ baidu::galaxy::util::ErrorCode TmpfsVolum::Construct() {
     return err;
 }
 
+baidu::galaxy::util::ErrorCode TmpfsVolum::Restore(int64_t used) {
+    vc_.reset(new VolumCollector(this->TargetPath()));
+    vc_->Restore(used);
+    vc_->Enable(true);
+    baidu::galaxy::collector::CollectorEngine::GetInstance()->Register(vc_);
+    return ERRORCODE_OK;
+}
+
 baidu::galaxy::util::ErrorCode TmpfsVolum::Construct_() {
     const boost::shared_ptr<baidu::galaxy::proto::VolumRequired> vr = Description();
     assert(baidu::galaxy::proto::kTmpfs == vr->medium());
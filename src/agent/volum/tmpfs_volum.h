@@ -16,6 +16,7 @@ public:
     ~TmpfsVolum();
 
     baidu::galaxy::util::ErrorCode Construct();
+    baidu::galaxy::util::ErrorCode Restore(int64_t used);
     baidu::galaxy::util::ErrorCode Destroy();
     //baidu::galaxy::util::ErrorCode Gc();
 
@@ -48,6 +48,11 @@ public:
 
     virtual baidu::galaxy::util::ErrorCode Destroy();
     virtual baidu::galaxy::util::ErrorCode Construct() = 0;
+    // takes over the volum built by the agent before a hot upgrade, the
+    // mounts are still there, used is the size it collected last
+    virtual baidu::galaxy::util::ErrorCode Restore(int64_t used) {
+        return ERRORCODE_OK;
+    }
     virtual baidu::galaxy::util::ErrorCode Gc() {
         return ERRORCODE_OK;
     }
@@ -109,6 +109,11 @@ int64_t VolumCollector::Size() {
     return size_;
 }
 
+void VolumCollector::Restore(int64_t size) {
+    boost::mutex::scoped_lock lock(mutex_);
+    size_ = size;
+}
+
 }
 }
 }
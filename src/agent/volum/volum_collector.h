@@ -27,6 +27,8 @@ public:
     void SetCycle(const int cycle);
 
     int64_t Size();
+    // size from the agent before a hot upgrade, du takes a whole cycle
+    void Restore(int64_t size);
 private:
     void Du(const boost::filesystem::path& p, int64_t& size, int64_t& counter);
     bool enable_;
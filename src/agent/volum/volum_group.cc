@@ -61,7 +61,25 @@ void VolumGroup::SetContainerId(const std::string& container_id) {
 }
 
 baidu::galaxy::util::ErrorCode VolumGroup::Construct() {
-    workspace_volum_ = Construct(this->ws_description_);
+    return Construct_(NULL);
+}
+
+baidu::galaxy::util::ErrorCode VolumGroup::Restore(const std::map<std::string, int64_t>& used) {
+    return Construct_(&used);
+}
+
+void VolumGroup::Dump(std::map<std::string, int64_t>& used) {
+    if (NULL != workspace_volum_.get()) {
+        used[workspace_volum_->TargetPath()] = workspace_volum_->Used();
+    }
+
+    for (size_t i = 0; i < data_volum_.size(); i++) {
+        used[data_volum_[i]->TargetPath()] = data_volum_[i]->Used();
+    }
+}
+
+baidu::galaxy::util::ErrorCode VolumGroup::Construct_(const std::map<std::string, int64_t>* used) {
+    workspace_volum_ = Construct(this->ws_description_, used);
 
     if (NULL == workspace_volum_.get()) {
         return ERRORCODE(-1, "failed in constructing workspace volum");
@@ -70,7 +88,7 @@ baidu::galaxy::util::ErrorCode VolumGroup::Construct() {
     baidu::galaxy::util::ErrorCode ec;
 
     for (size_t i = 0; i < dv_description_.size(); i++) {
-        boost::shared_ptr<Volum> v = Construct(dv_description_[i]);
+        boost::shared_ptr<Volum> v = Construct(dv_description_[i], used);
 
         if (v.get() == NULL) {
             ec = ERRORCODE(-1,
@@ -84,7 +102,8 @@ baidu::galaxy::util::ErrorCode VolumGroup::Construct() {
     }
 
     if (data_volum_.size() != dv_description_.size()) {
-        for (size_t i = 0; i < data_volum_.size(); i++) {
+        // mounts in use by the container are left alone when restoring
+        for (size_t i = 0; NULL == used && i < data_volum_.size(); i++) {
             baidu::galaxy::util::ErrorCode err = data_volum_[i]->Destroy();
 
             if (0 != err.Code()) {
@@ -98,7 +117,7 @@ baidu::galaxy::util::ErrorCode VolumGroup::Construct() {
 
     // origin volum
     for (size_t i = 0; i < ov_description_.size(); i++) {
-        boost::shared_ptr<Volum> v = Construct(ov_description_[i]);
+        boost::shared_ptr<Volum> v = Construct(ov_description_[i], used);
 
         if (v.get() == NULL) {
             ec = ERRORCODE(-1,
@@ -112,7 +131,7 @@ baidu::galaxy::util::ErrorCode VolumGroup::Construct() {
     }
 
     if (origin_volum_.size() != ov_description_.size()) {
-        for (size_t i = 0; i < origin_volum_.size(); i++) {
+        for (size_t i = 0; NULL == used && i < origin_volum_.size(); i++) {
             baidu::galaxy::util::ErrorCode err = origin_volum_[i]->Destroy();
 
             if (0 != err.Code()) {
@@ -218,14 +237,22 @@ int VolumGroup::ExportEnv(std::map<std::string, std::string>& env) {
     return 0;
 }
 
-boost::shared_ptr<Volum> VolumGroup::Construct(boost::shared_ptr<baidu::galaxy::proto::VolumRequired> dp) {
+boost::shared_ptr<Volum> VolumGroup::Construct(boost::shared_ptr<baidu::galaxy::proto::VolumRequired> dp,
+        const std::map<std::string, int64_t>* used) {
     boost::shared_ptr<Volum> volum = NewVolum(dp);
 
     if (NULL == volum.get()) {
         return volum;
     }
 
-    baidu::galaxy::util::ErrorCode ec = volum->Construct();
+    baidu::galaxy::util::ErrorCode ec;
+
+    if (NULL == used) {
+        ec = volum->Construct();
+    } else {
+        std::map<std::string, int64_t>::const_iterator iter = used->find(volum->TargetPath());
+        ec = volum->Restore(iter == used->end() ? 0L : iter->second);
+    }
 
     if (0 != ec.Code()) {
         LOG(WARNING) << "failed in constructing volum for container "
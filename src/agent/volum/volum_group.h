@@ -40,6 +40,10 @@ public:
     }
 
     baidu::galaxy::util::ErrorCode Construct();
+    // takes over the volums mounted by the agent before a hot upgrade, used
+    // is the size of each volum it collected, key: target path
+    baidu::galaxy::util::ErrorCode Restore(const std::map<std::string, int64_t>& used);
+    void Dump(std::map<std::string, int64_t>& used);
     baidu::galaxy::util::ErrorCode  Destroy();
 
     int ExportEnv(std::map<std::string, std::string>& env);
@@ -51,7 +55,9 @@ public:
     std::string ContainerGcPath();
 private:
     baidu::galaxy::util::ErrorCode MountDir_(const std::string& source, const std::string& target);
-    boost::shared_ptr<Volum> Construct(boost::shared_ptr<baidu::galaxy::proto::VolumRequired> volum);
+    baidu::galaxy::util::ErrorCode Construct_(const std::map<std::string, int64_t>* used);
+    boost::shared_ptr<Volum> Construct(boost::shared_ptr<baidu::galaxy::proto::VolumRequired> volum,
+            const std::map<std::string, int64_t>* used);
     boost::shared_ptr<Volum> NewVolum(boost::shared_ptr<baidu::galaxy::proto::VolumRequired> volum);
 
     int MountCgroups(const std::string& cg);
@@ -10,3 +10,7 @@ DEFINE_int32(master_pod_dead_time, 10, "master pod overtime threshold");
 DEFINE_int32(master_pod_check_interval, 5, "master pod checker interval");
 DEFINE_int32(master_fail_last_threshold, 3600, "master pod fail status lasts time threshold");
 DEFINE_int32(safe_interval, 20, "master safe mode interval");
+DEFINE_int32(reload_threads, 8, "number of workers parsing and loading jobs on startup");
+DEFINE_int32(service_registry_log_size, 1000, "changes of a service kept for subscribers to catch up with");
+DEFINE_int32(service_subscribe_max_wait, 30000, "max ms a subscriber waits for the service to change");
+DEFINE_int32(reload_batch_size, 256, "number of jobs handed to a reload worker at once");
@@ -14,12 +14,15 @@
 #include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <snappy.h>
+#include "log_utils.h"
 
 DECLARE_string(nexus_root);
 DECLARE_string(nexus_addr);
 DECLARE_string(jobs_store_path);
 DECLARE_string(appworker_cmdline);
 DECLARE_int32(safe_interval);
+DECLARE_int32(reload_threads);
+DECLARE_int32(reload_batch_size);
 
 const std::string sMASTERLock = "/appmaster_lock";
 const std::string sMASTERAddr = "/appmaster";
@@ -28,7 +31,8 @@ const std::string sRESMANPath = "/resman";
 namespace baidu {
 namespace galaxy {
 
-AppMasterImpl::AppMasterImpl() : running_(false) {
+AppMasterImpl::AppMasterImpl() : running_(false),
+                                 start_time_(::baidu::common::timer::get_micros()) {
     nexus_ = new ::galaxy::ins::sdk::InsSDK(FLAGS_nexus_addr);
     resman_watcher_ = new baidu::galaxy::Watcher();
 }
@@ -42,6 +46,8 @@ AppMasterImpl::~AppMasterImpl() {
 void AppMasterImpl::RunMaster() {
     running_ = true;
     job_manager_.Run();
+    LOG(INFO) << "appmaster serving, time to serving: "
+              << (::baidu::common::timer::get_micros() - start_time_) / 1000 << " ms";
     return;
 }
 void AppMasterImpl::Init() {
@@ -59,30 +65,68 @@ void AppMasterImpl::Init() {
 }
 
 void AppMasterImpl::ReloadAppInfo() {
+    int64_t begin_time = ::baidu::common::timer::get_micros();
     std::string start_key = FLAGS_nexus_root + FLAGS_jobs_store_path + "/";
     std::string end_key = start_key + "~";
     ::galaxy::ins::sdk::ScanResult* result = nexus_->Scan(start_key, end_key);
+    // the scan streams on this thread while workers parse and load batches
+    ReloadStat stat;
+    // the workers build naming sdks, which share this pool
+    CurlThreadPool::GetInstance();
+    ThreadPool reload_pool(FLAGS_reload_threads > 0 ? FLAGS_reload_threads : 1);
+    size_t batch_size = FLAGS_reload_batch_size > 0 ? FLAGS_reload_batch_size : 1;
+    boost::shared_ptr<RawJobs> batch(new RawJobs());
+    batch->reserve(batch_size);
     int job_amount = 0;
     while (!result->Done()) {
         assert(result->Error() == ::galaxy::ins::sdk::kOK);
-        std::string key = result->Key();
-        std::string job_raw_data = result->Value();
-        JobInfo job_info;
-        bool ok = job_info.ParseFromString(job_raw_data);
-        if (ok) {
-            LOG(INFO) << "reload job: " << job_info.jobid();
-            job_manager_.ReloadJobInfo(job_info);
-        } else {
-            LOG(WARNING) <<  "faild to parse job_info: " << key;
+        batch->push_back(std::make_pair(result->Key(), result->Value()));
+        if (batch->size() >= batch_size) {
+            reload_pool.AddTask(boost::bind(&AppMasterImpl::ReloadJobBatch, this, batch, &stat));
+            batch.reset(new RawJobs());
+            batch->reserve(batch_size);
         }
         result->Next();
         job_amount++;
     }
+    if (!batch->empty()) {
+        reload_pool.AddTask(boost::bind(&AppMasterImpl::ReloadJobBatch, this, batch, &stat));
+    }
+    int64_t scan_time = ::baidu::common::timer::get_micros() - begin_time;
+    reload_pool.Stop(true);
 
     if (result) {
         delete result;
     }
-    LOG(INFO) << "reload all job desc finish, total#: " << job_amount;
+    int64_t reload_time = ::baidu::common::timer::get_micros() - begin_time;
+    LOG(INFO) << "reload all job desc finish, total#: " << job_amount
+              << ", loaded#: " << stat.loaded
+              << ", failed#: " << stat.failed
+              << ", scan: " << scan_time / 1000 << " ms"
+              << ", reload: " << reload_time / 1000 << " ms"
+              << ", throughput: " << stat.loaded * 1000000 / (reload_time > 0 ? reload_time : 1)
+              << " jobs/s";
+}
+
+void AppMasterImpl::ReloadJobBatch(boost::shared_ptr<RawJobs> raw_jobs,
+                                   ReloadStat* stat) {
+    std::vector<JobInfo> job_infos(raw_jobs->size());
+    size_t parsed = 0;
+    for (size_t i = 0; i < raw_jobs->size(); i++) {
+        JobInfo& job_info = job_infos[parsed];
+        if (job_info.ParseFromString((*raw_jobs)[i].second)) {
+            LOG(INFO) << "reload job: " << job_info.jobid();
+            parsed++;
+        } else {
+            LOG(WARNING) <<  "faild to parse job_info: " << (*raw_jobs)[i].first;
+            job_info.Clear();
+        }
+    }
+    job_infos.resize(parsed);
+    job_manager_.ReloadJobInfos(job_infos);
+    MutexLock lock(&stat->mutex);
+    stat->loaded += parsed;
+    stat->failed += raw_jobs->size() - parsed;
 }
 
 void AppMasterImpl::HandleResmanChange(const std::string& new_endpoint) {
@@ -168,6 +212,11 @@ void AppMasterImpl::BuildContainerDescription(const ::baidu::galaxy::proto::JobD
     container_desc->set_run_user(job_desc.run_user());
     container_desc->set_version(job_desc.version());
     container_desc->set_max_per_host(job_desc.deploy().max_per_host());
+    container_desc->mutable_spreads()->CopyFrom(job_desc.deploy().spreads());
+    container_desc->mutable_anti_affinities()->CopyFrom(job_desc.deploy().anti_affinities());
+    container_desc->set_gang(job_desc.deploy().gang());
+    container_desc->set_gang_min(job_desc.deploy().gang_min());
+    container_desc->set_gang_timeout(job_desc.deploy().gang_timeout());
     container_desc->set_tag(job_desc.deploy().tag());
 
     if (job_desc.has_volum_view()) {
@@ -378,6 +427,8 @@ void AppMasterImpl::UpdateJob(::google::protobuf::RpcController* controller,
             return;
         }
         container_request->set_interval(last_desc.deploy().interval());
+        container_request->set_max_surge(last_desc.deploy().max_surge());
+        container_request->set_max_unavailable(last_desc.deploy().max_unavailable());
         container_request->set_replica(last_desc.deploy().replica());
         BuildContainerDescription(last_desc, container_request->mutable_desc());
         VLOG(10) << "DEBUG RollbackUpdateContainer: ";
@@ -433,6 +484,8 @@ void AppMasterImpl::UpdateJob(::google::protobuf::RpcController* controller,
     container_request->mutable_user()->CopyFrom(request->user());
     container_request->set_id(request->jobid());
     container_request->set_interval(job_desc.deploy().interval());
+    container_request->set_max_surge(job_desc.deploy().max_surge());
+    container_request->set_max_unavailable(job_desc.deploy().max_unavailable());
     BuildContainerDescription(job_desc, container_request->mutable_desc());
     container_request->set_replica(job_desc.deploy().replica());
     VLOG(10) << "DEBUG UpdateContainer: ";
@@ -554,16 +607,30 @@ void AppMasterImpl::FetchTask(::google::protobuf::RpcController* controller,
                               const ::baidu::galaxy::proto::FetchTaskRequest* request,
                               ::baidu::galaxy::proto::FetchTaskResponse* response,
                               ::google::protobuf::Closure* done) {
-    VLOG(10) << "DEBUG: FetchTask"
-    << request->DebugString()
-    <<"DEBUG END";
+    VLOG(10) << "DEBUG: FetchTask " << ProtoDump(*request);
     Status status = job_manager_.HandleFetch(request, response);
     if (status != kOk) {
         LOG(WARNING) << "FetchTask failed, code:" << Status_Name(status) << ", method:" << __FUNCTION__;
     }
-    VLOG(10) << "DEBUG: Fetch response "
-    << response->DebugString()
-    <<"DEBUG END";
+    VLOG(10) << "DEBUG: Fetch response " << ProtoDump(*response);
+    done->Run();
+    return;
+}
+
+void AppMasterImpl::BatchFetchTask(::google::protobuf::RpcController* controller,
+                                   const ::baidu::galaxy::proto::BatchFetchTaskRequest* request,
+                                   ::baidu::galaxy::proto::BatchFetchTaskResponse* response,
+                                   ::google::protobuf::Closure* done) {
+    VLOG(10) << "DEBUG: BatchFetchTask from " << request->endpoint()
+    << ", pods: " << request->requests_size();
+    for (int i = 0; i < request->requests_size(); i++) {
+        Status status = job_manager_.HandleFetch(&request->requests(i),
+                                                 response->add_responses());
+        if (status != kOk) {
+            LOG(WARNING) << "FetchTask failed, code:" << Status_Name(status)
+            << ", pod: " << request->requests(i).podid() << ", method:" << __FUNCTION__;
+        }
+    }
     done->Run();
     return;
 }
@@ -588,6 +655,16 @@ void AppMasterImpl::RecoverInstance(::google::protobuf::RpcController* controlle
     return;
 }
 
+void AppMasterImpl::SubscribeService(::google::protobuf::RpcController* controller,
+                                     const ::baidu::galaxy::proto::SubscribeServiceRequest* request,
+                                     ::baidu::galaxy::proto::SubscribeServiceResponse* response,
+                                     ::google::protobuf::Closure* done) {
+    VLOG(10) << "DEBUG: SubscribeService " << request->service_name()
+    << ", version: " << request->version();
+    // done runs once the service changes or the wait times out
+    job_manager_.SubscribeService(request, response, done);
+}
+
 void AppMasterImpl::UpdateJobUser(::google::protobuf::RpcController* controller,
                     const ::baidu::galaxy::proto::UpdateJobUserRequest* request,
                     ::baidu::galaxy::proto::UpdateJobUserResponse* response,
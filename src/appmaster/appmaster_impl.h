@@ -6,6 +6,8 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
+#include <boost/shared_ptr.hpp>
 
 #include "job_manager.h"
 #include "ins_sdk.h"
@@ -68,6 +70,10 @@ public:
                   const ::baidu::galaxy::proto::FetchTaskRequest* request,
                   ::baidu::galaxy::proto::FetchTaskResponse* response,
                   ::google::protobuf::Closure* done);
+    void BatchFetchTask(::google::protobuf::RpcController* controller,
+                        const ::baidu::galaxy::proto::BatchFetchTaskRequest* request,
+                        ::baidu::galaxy::proto::BatchFetchTaskResponse* response,
+                        ::google::protobuf::Closure* done);
     bool RegisterOnNexus(const std::string endpoint);
 
     void RecoverInstance(::google::protobuf::RpcController* controller,
@@ -75,6 +81,11 @@ public:
                         ::baidu::galaxy::proto::RecoverInstanceResponse* response,
                         ::google::protobuf::Closure* done);
 
+    void SubscribeService(::google::protobuf::RpcController* controller,
+                          const ::baidu::galaxy::proto::SubscribeServiceRequest* request,
+                          ::baidu::galaxy::proto::SubscribeServiceResponse* response,
+                          ::google::protobuf::Closure* done);
+
     void UpdateJobUser(::google::protobuf::RpcController* controller,
                         const ::baidu::galaxy::proto::UpdateJobUserRequest* request,
                         ::baidu::galaxy::proto::UpdateJobUserResponse* response,
@@ -107,6 +118,16 @@ private:
     void HandleResmanChange(const std::string& new_endpoint);
     void OnLockChange(std::string lock_session_id);
     void ReloadAppInfo();
+    // key and raw value of jobs scanned from nexus
+    typedef std::vector<std::pair<std::string, std::string> > RawJobs;
+    struct ReloadStat {
+        ReloadStat() : loaded(0), failed(0) {}
+        Mutex mutex;
+        int64_t loaded;
+        int64_t failed;
+    };
+    void ReloadJobBatch(boost::shared_ptr<RawJobs> raw_jobs,
+                        ReloadStat* stat);
     static void OnMasterLockChange(const ::galaxy::ins::sdk::WatchParam& param,
                             ::galaxy::ins::sdk::SDKError err);
     void RunMaster();
@@ -121,6 +142,7 @@ private:
     Watcher* resman_watcher_;
     Mutex resman_mutex_;
     bool running_;
+    int64_t start_time_;
     //::baidu::galaxy::proto::ResourceManager_Stub* resman_;
 };
 
@@ -5,6 +5,7 @@
 
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <gflags/gflags.h>
 #include "timer.h"
@@ -883,55 +884,92 @@ bool JobManager::IsSerivceSame(const ServiceInfo& src, const ServiceInfo& dest)
     return true;
 }
 
+static size_t ServicesFingerprint(const ServiceList& services) {
+    // the fields IsSerivceSame looks at
+    size_t seed = services.size();
+    for (int i = 0; i < services.size(); i++) {
+        const ServiceInfo& service = services.Get(i);
+        boost::hash_combine(seed, service.name());
+        boost::hash_combine(seed, service.port());
+        boost::hash_combine(seed, service.ip());
+        boost::hash_combine(seed, static_cast<int>(service.status()));
+        boost::hash_combine(seed, service.deploy_path());
+    }
+    return seed;
+}
+
 void JobManager::RefreshService(Job* job, ServiceList* src, PodInfo* pod) {
-    for (int i = 0; i < pod->services().size(); i++) {
-        bool found = false;
-        for (int j = 0; j < src->size(); j++) {
-            if (pod->services(i).name() == src->Get(j).name()) {
-                found = true;
-                break;
-            }
+    size_t fingerprint = ServicesFingerprint(*src);
+    std::map<PodId, PodServices>::iterator state_it = job->pod_services_.find(pod->podid());
+    if (state_it != job->pod_services_.end()
+            && state_it->second.fingerprint == fingerprint) {
+        return;
+    }
+    PodServices& state = job->pod_services_[pod->podid()];
+    state.fingerprint = fingerprint;
+
+    boost::unordered_map<ServiceName, const ServiceInfo*> reported;
+    for (int i = 0; i < src->size(); i++) {
+        reported[src->Get(i).name()] = &src->Get(i);
+    }
+
+    bool changed = false;
+    boost::unordered_map<ServiceName, ServiceInfo>::iterator it = state.services.begin();
+    while (it != state.services.end()) {
+        if (reported.find(it->first) != reported.end()) {
+            ++it;
+            continue;
         }
-        if (!found) {
-            pod->mutable_services()->DeleteSubrange(i, 1);
-            //todo
+        LOG(INFO) << " remove service : " << it->first;
+        service_registry_.Remove(it->first, pod->podid());
+        std::map<std::string, PublicSdk*>::iterator sdk_it = job->naming_sdk_.find(it->first);
+        if (sdk_it != job->naming_sdk_.end()) {
+            sdk_it->second->DelServiceInstance(pod->podid());
         }
+        it = state.services.erase(it);
+        changed = true;
     }
-    for (int i = 0; i < src->size(); i++) {
-        ServiceInfo src_serv = src->Get(i);
-        bool found = false;
-        for (int j = 0; j < pod->services().size(); j++) {
-            if (src_serv.name() != pod->services(j).name()) {
+
+    boost::unordered_map<ServiceName, const ServiceInfo*>::iterator r_it = reported.begin();
+    for (; r_it != reported.end(); ++r_it) {
+        const ServiceInfo& src_serv = *r_it->second;
+        std::map<std::string, PublicSdk*>::iterator sdk_it = job->naming_sdk_.find(src_serv.name());
+        it = state.services.find(src_serv.name());
+        if (it != state.services.end()) {
+            if (IsSerivceSame(src_serv, it->second)) {
                 continue;
-            } else {
-                found = true;
-                if (!IsSerivceSame(src_serv, pod->services(j))) {
-                    pod->mutable_services(j)->CopyFrom(src_serv);
-                    VLOG(10) << "refresh service : "
-                    << " name : " << pod->services(j).name()
-                    << " ip : " << pod->services(j).ip()
-                    << " port : " << pod->services(j).port()
-                    << " status : " << pod->services(j).status()
-                    << " deploy_path : " << pod->services(j).status();
-                    std::map<std::string, PublicSdk*>::iterator it = job->naming_sdk_.find(src_serv.name());
-                    if (it != job->naming_sdk_.end()) {
-                        it->second->DelServiceInstance(pod->podid());
-                        if (src_serv.status() == kOk) {
-                            it->second->AddServiceInstance(pod->podid(), src_serv);
-                        }
-                    }
+            }
+            it->second.CopyFrom(src_serv);
+            service_registry_.Update(pod->podid(), src_serv);
+            VLOG(10) << "refresh service : "
+            << " name : " << src_serv.name()
+            << " ip : " << src_serv.ip()
+            << " port : " << src_serv.port()
+            << " status : " << src_serv.status()
+            << " deploy_path : " << src_serv.deploy_path();
+            if (sdk_it != job->naming_sdk_.end()) {
+                sdk_it->second->DelServiceInstance(pod->podid());
+                if (src_serv.status() == kOk) {
+                    sdk_it->second->AddServiceInstance(pod->podid(), src_serv);
                 }
-                break;
             }
-        }
-        if (!found && src_serv.status() == kOk) {
-            pod->add_services()->CopyFrom(src_serv);
+            changed = true;
+        } else if (src_serv.status() == kOk) {
+            state.services[src_serv.name()].CopyFrom(src_serv);
+            service_registry_.Update(pod->podid(), src_serv);
             LOG(INFO) << " add service : " << src_serv.name();
-            std::map<std::string, PublicSdk*>::iterator it = job->naming_sdk_.find(src_serv.name());
-            if (it != job->naming_sdk_.end()) {
-                it->second->AddServiceInstance(pod->podid(), src_serv);
+            if (sdk_it != job->naming_sdk_.end()) {
+                sdk_it->second->AddServiceInstance(pod->podid(), src_serv);
                 LOG(INFO) << " AddServiceInstance : " << pod->podid();
-            }      
+            }
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        pod->clear_services();
+        for (it = state.services.begin(); it != state.services.end(); ++it) {
+            pod->add_services()->CopyFrom(it->second);
         }
     }
     return;
@@ -939,12 +977,14 @@ void JobManager::RefreshService(Job* job, ServiceList* src, PodInfo* pod) {
 
 void JobManager::DestroyService(Job* job, PodInfo* pod) {
     for (int j = 0; j < pod->services().size(); j++) {
+        service_registry_.Remove(pod->services(j).name(), pod->podid());
         std::map<std::string, PublicSdk*>::iterator it = job->naming_sdk_.find(pod->services(j).name());
         if (it != job->naming_sdk_.end()) {
             it->second->DelServiceInstance(pod->podid());
         }
     }
     pod->clear_services();
+    job->pod_services_.erase(pod->podid());
     return;
 }
 
@@ -1208,7 +1248,23 @@ void JobManager::RebuildPods(Job* job,
     }
 }
 
-void JobManager::ReloadJobInfo(const JobInfo& job_info) {
+void JobManager::ReloadJobInfos(const std::vector<JobInfo>& job_infos) {
+    // build outside the lock, reload workers only contend on the insertion
+    std::vector<Job*> jobs;
+    jobs.reserve(job_infos.size());
+    for (size_t i = 0; i < job_infos.size(); i++) {
+        jobs.push_back(BuildJob(job_infos[i]));
+    }
+    MutexLock lock(&mutex_);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        Job* job = jobs[i];
+        jobs_[job->id_] = job;
+        job_checker_.DelayTask(FLAGS_master_job_check_interval * 1000, boost::bind(&JobManager::CheckJobStatus, this, job));
+    }
+    return;
+}
+
+Job* JobManager::BuildJob(const JobInfo& job_info) {
     Job* job = new Job();
     job->status_ = job_info.status();
     job->user_.CopyFrom(job_info.user());
@@ -1231,10 +1287,7 @@ void JobManager::ReloadJobInfo(const JobInfo& job_info) {
             }
         }
     }
-    MutexLock lock(&mutex_);
-    jobs_[job->id_] = job;
-    job_checker_.DelayTask(FLAGS_master_job_check_interval * 1000, boost::bind(&JobManager::CheckJobStatus, this, job));
-    return;
+    return job;
 }
 
 void JobManager::GetJobsOverview(JobOverviewList* jobs_overview) {
@@ -1360,6 +1413,13 @@ JobDescription JobManager::GetLastDesc(const JobId jobid) {
     return job->last_desc_;
 }
 
+void JobManager::SubscribeService(const ::baidu::galaxy::proto::SubscribeServiceRequest* request,
+                                  ::baidu::galaxy::proto::SubscribeServiceResponse* response,
+                                  ::google::protobuf::Closure* done) {
+    // the registry has its own lock, subscribers never wait for the job lock
+    service_registry_.Subscribe(request, response, done);
+}
+
 Status JobManager::RecoverPod(const User& user, const std::string jobid, const std::string podid) {
     MutexLock lock(&mutex_);
     LOG(INFO) << __FUNCTION__ << " : " << jobid << " " << podid;
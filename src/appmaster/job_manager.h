@@ -8,12 +8,14 @@
 #include <map>
 #include <vector>
 #include <thread_pool.h>
+#include <boost/unordered_map.hpp>
 #include "ins_sdk.h"
 #include "protocol/resman.pb.h"
 #include "protocol/appmaster.pb.h"
 #include "protocol/galaxy.pb.h"
 #include "rpc/rpc_client.h"
 #include "naming/private_sdk.h"
+#include "service_registry.h"
 
 namespace baidu {
 namespace galaxy {
@@ -85,6 +87,14 @@ typedef baidu::galaxy::proto::JobOverview JobOverview;
 typedef ::google::protobuf::RepeatedPtrField<JobOverview> JobOverviewList;
 typedef ::google::protobuf::RepeatedPtrField<ServiceInfo> ServiceList;
 
+// services of a pod as last reported, key: service name
+struct PodServices {
+    PodServices() : fingerprint(0) {}
+    // of the reported list, an unchanged list is skipped by comparing it
+    size_t fingerprint;
+    boost::unordered_map<ServiceName, ServiceInfo> services;
+};
+
 struct Job {
     JobStatus status_;
     User user_;
@@ -102,6 +112,7 @@ struct Job {
     int64_t rollback_time_;
     uint32_t updated_cnt_;
     std::map<std::string, PublicSdk*> naming_sdk_;
+    std::map<PodId, PodServices> pod_services_;
 };
 
 typedef boost::function<Status (Job* job, void* arg)> TransFunc;
@@ -127,12 +138,15 @@ public:
                      ::baidu::galaxy::proto::FetchTaskResponse* response);
     Status RecoverPod(const User& user, const std::string jobid, const std::string podid);
 
-    void ReloadJobInfo(const JobInfo& job_info);
+    void ReloadJobInfos(const std::vector<JobInfo>& job_infos);
     void GetJobsOverview(JobOverviewList* jobs_overview);
     void SetResmanEndpoint(std::string new_endpoint);
     Status GetJobInfo(const JobId& jobid, JobInfo* job_info);
     Status UpdateUser(const JobId& jobid, const User& user);
     JobDescription GetLastDesc(const JobId jonid);
+    void SubscribeService(const ::baidu::galaxy::proto::SubscribeServiceRequest* request,
+                          ::baidu::galaxy::proto::SubscribeServiceResponse* response,
+                          ::google::protobuf::Closure* done);
     void Run();
     JobManager();
     ~JobManager();
@@ -144,6 +158,7 @@ private:
     void BuildFsm();
     void BuildDispatch();
     void BuildAging();
+    Job* BuildJob(const JobInfo& job_info);
     void CheckPending(Job* job);
     void CheckRunning(Job* job);
     void CheckUpdating(Job* job);
@@ -209,6 +224,7 @@ private:
     std::map<std::string, DispatchFunc> dispatch_;
     std::map<std::string, AgingFunc> aging_;
     bool running_;
+    ServiceRegistry service_registry_;
 };
 
 }
@@ -0,0 +1,190 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "service_registry.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include "timer.h"
+
+DECLARE_int32(service_registry_log_size);
+DECLARE_int32(service_subscribe_max_wait);
+
+namespace baidu {
+namespace galaxy {
+
+static const int kExpireCheckInterval = 100;
+
+ServiceRegistry::ServiceRegistry() :
+    // versions of a new appmaster never go back to those of the old one
+    version_(::baidu::common::timer::get_micros()),
+    expire_pool_(1) {
+    expire_pool_.DelayTask(kExpireCheckInterval,
+                           boost::bind(&ServiceRegistry::ExpireRoutine, this));
+}
+
+ServiceRegistry::~ServiceRegistry() {
+    expire_pool_.Stop(false);
+}
+
+void ServiceRegistry::Update(const std::string& podid,
+                             const ::baidu::galaxy::proto::ServiceInfo& service) {
+    if (service.status() != ::baidu::galaxy::proto::kOk) {
+        Remove(service.name(), podid);
+        return;
+    }
+    std::vector< ::google::protobuf::Closure*> dones;
+    {
+        MutexLock lock(&mutex_);
+        std::map<std::string, Service>::iterator it = services_.find(service.name());
+        if (it == services_.end()) {
+            it = services_.insert(std::make_pair(service.name(), Service())).first;
+            it->second.base_version = version_;
+            it->second.version = version_;
+        }
+        std::map<std::string, ::baidu::galaxy::proto::ServiceInfo>::iterator inst_it =
+            it->second.instances.find(podid);
+        if (inst_it != it->second.instances.end()
+                && inst_it->second.SerializeAsString() == service.SerializeAsString()) {
+            return;
+        }
+        it->second.instances[podid] = service;
+        Append(it->second, podid, &service, dones);
+    }
+    for (size_t i = 0; i < dones.size(); i++) {
+        dones[i]->Run();
+    }
+}
+
+void ServiceRegistry::Remove(const std::string& service_name, const std::string& podid) {
+    std::vector< ::google::protobuf::Closure*> dones;
+    {
+        MutexLock lock(&mutex_);
+        std::map<std::string, Service>::iterator it = services_.find(service_name);
+        if (it == services_.end() || it->second.instances.erase(podid) == 0) {
+            return;
+        }
+        Append(it->second, podid, NULL, dones);
+    }
+    for (size_t i = 0; i < dones.size(); i++) {
+        dones[i]->Run();
+    }
+}
+
+void ServiceRegistry::Append(Service& service, const std::string& podid,
+                             const ::baidu::galaxy::proto::ServiceInfo* info,
+                             std::vector< ::google::protobuf::Closure*>& dones) {
+    mutex_.AssertHeld();
+    ::baidu::galaxy::proto::ServiceDelta delta;
+    delta.set_version(++version_);
+    delta.set_podid(podid);
+    delta.set_deleted(NULL == info);
+    if (NULL != info) {
+        delta.mutable_service()->CopyFrom(*info);
+    }
+    service.deltas.push_back(delta);
+    service.version = version_;
+    while ((int32_t)service.deltas.size() > std::max(FLAGS_service_registry_log_size, 1)) {
+        service.base_version = service.deltas.front().version();
+        service.deltas.pop_front();
+    }
+
+    // every waiter is behind now
+    for (size_t i = 0; i < service.waiters.size(); i++) {
+        Fill(service, service.waiters[i].version, service.waiters[i].response);
+        dones.push_back(service.waiters[i].done);
+    }
+    service.waiters.clear();
+}
+
+bool ServiceRegistry::Fill(const Service& service, int64_t version,
+                           ::baidu::galaxy::proto::SubscribeServiceResponse* response) {
+    mutex_.AssertHeld();
+    response->mutable_error_code()->set_status(::baidu::galaxy::proto::kOk);
+    response->set_version(service.version);
+    if (version == service.version) {
+        response->set_full(false);
+        return false;
+    }
+
+    if (version >= service.base_version && version < service.version) {
+        response->set_full(false);
+        std::deque< ::baidu::galaxy::proto::ServiceDelta>::const_iterator it = service.deltas.begin();
+        for (; it != service.deltas.end(); it++) {
+            if (it->version() > version) {
+                response->add_deltas()->CopyFrom(*it);
+            }
+        }
+        return true;
+    }
+
+    // too old or from another appmaster, start over with all instances
+    response->set_full(true);
+    std::map<std::string, ::baidu::galaxy::proto::ServiceInfo>::const_iterator it = service.instances.begin();
+    for (; it != service.instances.end(); it++) {
+        ::baidu::galaxy::proto::ServiceDelta* delta = response->add_deltas();
+        delta->set_version(service.version);
+        delta->set_podid(it->first);
+        delta->set_deleted(false);
+        delta->mutable_service()->CopyFrom(it->second);
+    }
+    return true;
+}
+
+void ServiceRegistry::Subscribe(const ::baidu::galaxy::proto::SubscribeServiceRequest* request,
+                                ::baidu::galaxy::proto::SubscribeServiceResponse* response,
+                                ::google::protobuf::Closure* done) {
+    {
+        MutexLock lock(&mutex_);
+        std::map<std::string, Service>::iterator it = services_.find(request->service_name());
+        if (it == services_.end()) {
+            it = services_.insert(std::make_pair(request->service_name(), Service())).first;
+            it->second.base_version = version_;
+            it->second.version = version_;
+        }
+        Service& service = it->second;
+        int32_t timeout = std::min(request->timeout(), FLAGS_service_subscribe_max_wait);
+        if (!Fill(service, request->version(), response) && timeout > 0) {
+            Waiter waiter;
+            waiter.version = request->version();
+            waiter.deadline = ::baidu::common::timer::get_micros() + timeout * 1000L;
+            waiter.response = response;
+            waiter.done = done;
+            service.waiters.push_back(waiter);
+            return;
+        }
+    }
+    done->Run();
+}
+
+void ServiceRegistry::ExpireRoutine() {
+    std::vector< ::google::protobuf::Closure*> dones;
+    {
+        MutexLock lock(&mutex_);
+        int64_t now = ::baidu::common::timer::get_micros();
+        std::map<std::string, Service>::iterator it = services_.begin();
+        for (; it != services_.end(); it++) {
+            std::vector<Waiter>& waiters = it->second.waiters;
+            for (size_t i = 0; i < waiters.size();) {
+                if (waiters[i].deadline > now) {
+                    i++;
+                    continue;
+                }
+                // nothing changed, the response is filled already
+                dones.push_back(waiters[i].done);
+                waiters[i] = waiters.back();
+                waiters.pop_back();
+            }
+        }
+    }
+    for (size_t i = 0; i < dones.size(); i++) {
+        dones[i]->Run();
+    }
+    expire_pool_.DelayTask(kExpireCheckInterval,
+                           boost::bind(&ServiceRegistry::ExpireRoutine, this));
+}
+
+}
+}
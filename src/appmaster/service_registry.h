@@ -0,0 +1,69 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef BAIDU_GALAXY_SERVICE_REGISTRY_H
+#define BAIDU_GALAXY_SERVICE_REGISTRY_H
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex.h>
+#include <thread_pool.h>
+#include "protocol/appmaster.pb.h"
+#include "protocol/galaxy.pb.h"
+
+namespace baidu {
+namespace galaxy {
+
+// Healthy instances of every service reported by the pods, with a short log
+// of versioned changes. Subscribers ask for the changes after the version
+// they hold and are parked until there is one, so a change reaches them in
+// one rpc instead of a scan of nexus.
+class ServiceRegistry {
+public:
+    ServiceRegistry();
+    ~ServiceRegistry();
+
+    // an instance not in kOk leaves the service
+    void Update(const std::string& podid, const ::baidu::galaxy::proto::ServiceInfo& service);
+    void Remove(const std::string& service_name, const std::string& podid);
+    void Subscribe(const ::baidu::galaxy::proto::SubscribeServiceRequest* request,
+                   ::baidu::galaxy::proto::SubscribeServiceResponse* response,
+                   ::google::protobuf::Closure* done);
+
+private:
+    struct Waiter {
+        int64_t version;
+        int64_t deadline;
+        ::baidu::galaxy::proto::SubscribeServiceResponse* response;
+        ::google::protobuf::Closure* done;
+    };
+
+    struct Service {
+        Service() : base_version(0), version(0) {}
+        // key: podid
+        std::map<std::string, ::baidu::galaxy::proto::ServiceInfo> instances;
+        std::deque< ::baidu::galaxy::proto::ServiceDelta> deltas;
+        // deltas after base_version are all in the log
+        int64_t base_version;
+        int64_t version;
+        std::vector<Waiter> waiters;
+    };
+
+    void Append(Service& service, const std::string& podid,
+                const ::baidu::galaxy::proto::ServiceInfo* info,
+                std::vector< ::google::protobuf::Closure*>& dones);
+    bool Fill(const Service& service, int64_t version,
+              ::baidu::galaxy::proto::SubscribeServiceResponse* response);
+    void ExpireRoutine();
+
+    Mutex mutex_;
+    int64_t version_;
+    std::map<std::string, Service> services_;
+    ThreadPool expire_pool_;
+};
+
+}
+}
+
+#endif
@@ -18,6 +18,7 @@
 #include <timer.h>
 
 #include "utils.h"
+#include "src/utils/log_utils.h"
 
 DECLARE_string(nexus_addr);
 DECLARE_string(nexus_root_path);
@@ -37,6 +38,7 @@ DECLARE_string(appworker_task_ids_env);
 DECLARE_string(appworker_cgroup_subsystems_env);
 DECLARE_int32(appworker_fetch_task_timeout);
 DECLARE_int32(appworker_fetch_task_interval);
+DECLARE_bool(appworker_fetch_via_agent);
 DECLARE_int32(appworker_background_thread_pool_size);
 
 namespace baidu {
@@ -52,7 +54,9 @@ AppWorkerImpl::AppWorkerImpl() :
         appmaster_stub_(NULL),
         backgroud_pool_(FLAGS_appworker_background_thread_pool_size) {
     start_time_ = baidu::common::timer::get_micros();
-    nexus_ = new ::galaxy::ins::sdk::InsSDK(FLAGS_nexus_addr);
+    if (!FLAGS_appworker_fetch_via_agent) {
+        nexus_ = new ::galaxy::ins::sdk::InsSDK(FLAGS_nexus_addr);
+    }
     backgroud_pool_.AddTask(boost::bind(&AppWorkerImpl::UpdateAppMasterStub, this));
 }
 
@@ -357,7 +361,9 @@ void AppWorkerImpl::Load() {
     }
 
     backgroud_pool_.AddTask(boost::bind(&AppWorkerImpl::UpdateAppMasterStub, this));
-    nexus_ = new ::galaxy::ins::sdk::InsSDK(FLAGS_nexus_addr);
+    if (!FLAGS_appworker_fetch_via_agent && NULL == nexus_) {
+        nexus_ = new ::galaxy::ins::sdk::InsSDK(FLAGS_nexus_addr);
+    }
     LOG(WARNING) << "appworker load for upgrading ok";
     // LOG(INFO) << "\n" << appworker->DebugString();
 
@@ -383,8 +389,15 @@ void AppWorkerImpl::UpdateAppMasterStub() {
     MutexLock lock(&mutex_);
     SDKError err;
     std::string new_endpoint;
-    std::string key = FLAGS_nexus_root_path + "/" + FLAGS_appmaster_nexus_path;
-    bool ok = nexus_->Get(key, &new_endpoint, &err);
+    bool ok = true;
+
+    if (FLAGS_appworker_fetch_via_agent) {
+        // the agent relays fetches of all pods on the host to appmaster
+        new_endpoint = endpoint_;
+    } else {
+        std::string key = FLAGS_nexus_root_path + "/" + FLAGS_appmaster_nexus_path;
+        ok = nexus_->Get(key, &new_endpoint, &err);
+    }
 
     do {
         if (!ok) {
@@ -394,6 +407,11 @@ void AppWorkerImpl::UpdateAppMasterStub() {
             break;
         }
 
+        // envs are not parsed yet
+        if (new_endpoint.empty()) {
+            break;
+        }
+
         if (appmaster_endpoint_ == new_endpoint
                 && NULL != appmaster_stub_) {
             break;
@@ -453,9 +471,6 @@ void AppWorkerImpl::FetchTask() {
     request->set_status(pod.status);
     request->set_reload_status(pod.reload_status);
     request->set_fail_count(pod.fail_count);
-    LOG(INFO) << "pod status: " << proto::PodStatus_Name(pod.status);
-    LOG(INFO) << "fail count: " << pod.fail_count;
-    LOG(INFO) << "pod health: " << proto::Status_Name(pod.health);
 
     // copy services status
     for (unsigned i = 0; i < pod.services.size(); ++i) {
@@ -465,10 +480,15 @@ void AppWorkerImpl::FetchTask() {
         }
         request->add_services()->CopyFrom(pod.services[i]);
     }
-    LOG(INFO) << "++++++ " << proto::PodStatus_Name(pod.status);
+    // fetches go every few seconds, the state is logged now and then
+    LOG_EVERY_MS(INFO, 30000)
+            << "pod status: " << proto::PodStatus_Name(pod.status) << ", "
+            << "fail count: " << pod.fail_count << ", "
+            << "pod health: " << proto::Status_Name(pod.health) << ", "
+            << "services: " << request->services().size();
 
     for (int j = 0; j < request->services().size(); ++j) {
-        LOG(INFO)
+        VLOG(10)
                 << "service: " << request->services(j).name() << ", "
                 << "ip: " << request->services(j).ip() << ", "
                 << "port: " << request->services(j).port() << ", "
@@ -476,7 +496,7 @@ void AppWorkerImpl::FetchTask() {
     }
 
     if (proto::kPodStageReloading == pod.stage) {
-        LOG(INFO) << "pod reload_status: " << proto::PodStatus_Name(pod.reload_status);
+        LOG_EVERY_MS(INFO, 30000) << "pod reload_status: " << proto::PodStatus_Name(pod.reload_status);
     }
 
     boost::function<void (const FetchTaskRequest*, FetchTaskResponse*, bool, int)> fetch_task_callback;
@@ -510,7 +530,7 @@ void AppWorkerImpl::FetchTaskCallback(const FetchTaskRequest* request,
         }
 
         ErrorCode error_code = response_ptr->error_code();
-        LOG(INFO)
+        LOG_EVERY_MS(INFO, 30000)
                 << "fetch task call back, "
                 << "update_time: " << response_ptr->update_time() << ", "
                 << "status: " << proto::Status_Name(error_code.status());
@@ -541,7 +561,7 @@ void AppWorkerImpl::FetchTaskCallback(const FetchTaskRequest* request,
         // ignore expired action
         if (error_code.status() == update_status_
                 && response_ptr->update_time() == update_time_) {
-            LOG(WARNING)
+            LOG_EVERY_MS(WARNING, 30000)
                     << "ignore expire action, current "
                     << "update_time: " << update_time_ << ", "
                     << "update_status: " << proto::Status_Name(update_status_);
@@ -553,7 +573,7 @@ void AppWorkerImpl::FetchTaskCallback(const FetchTaskRequest* request,
         }
 
         if (response_ptr->update_time() == update_time_) {
-            LOG(INFO) << "update_time not updated";
+            VLOG(10) << "update_time not updated";
 
             switch (error_code.status()) {
             case proto::kRebuild: {
@@ -0,0 +1,350 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "health_prober.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <sstream>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+#include <timer.h>
+
+DECLARE_int32(task_manager_task_check_command_timeout);
+
+namespace baidu {
+namespace galaxy {
+
+static const int kMaxEvents = 64;
+static const int kWaitInterval = 100;
+static const size_t kMaxResponseSize = 4096;
+
+ProbeStat::ProbeStat() :
+        succeeded(0),
+        failed(0) {
+}
+
+void ProbeStat::Add(int64_t latency_us, bool ok) {
+    latency.Add(latency_us);
+    ok ? succeeded++ : failed++;
+}
+
+std::string ProbeStat::ToString() const {
+    std::stringstream ss;
+    ss << "succeeded:" << succeeded << " failed:" << failed << " " << latency.ToString();
+    return ss.str();
+}
+
+HealthProber::HealthProber() :
+        mutex_(),
+        epfd_(epoll_create1(EPOLL_CLOEXEC)),
+        running_(true),
+        loop_pool_(1) {
+    if (epfd_ < 0) {
+        LOG(WARNING) << "create epoll fd fail, err: " << strerror(errno);
+        running_ = false;
+        return;
+    }
+    loop_pool_.AddTask(boost::bind(&HealthProber::Loop, this));
+}
+
+HealthProber::~HealthProber() {
+    {
+        MutexLock lock(&mutex_);
+        running_ = false;
+    }
+    loop_pool_.Stop(true);
+
+    std::map<int, Probe*>::iterator it = probes_.begin();
+    for (; it != probes_.end(); ++it) {
+        close(it->first);
+        delete it->second;
+    }
+    probes_.clear();
+
+    if (epfd_ >= 0) {
+        close(epfd_);
+    }
+}
+
+int HealthProber::Start(const std::string& task_id,
+                        const proto::HealthProbe& probe,
+                        int32_t port) {
+    Clear(task_id);
+    MutexLock lock(&mutex_);
+
+    if (!running_) {
+        return -1;
+    }
+
+    int64_t now = common::timer::get_micros();
+    int64_t timeout = probe.timeout() > 0 ? probe.timeout() :
+                      FLAGS_task_manager_task_check_command_timeout * 1000;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG(WARNING) << "create probe socket fail, task: " << task_id
+                     << ", err: " << strerror(errno);
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    if (0 != connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr))
+            && EINPROGRESS != errno) {
+        LOG(INFO) << "probe of task: " << task_id << " connect port "
+                  << port << " fail, err: " << strerror(errno);
+        close(fd);
+        states_[task_id] = kProbeFailed;
+        stats_[task_id].Add(common::timer::get_micros() - now, false);
+        return 0;
+    }
+
+    Probe* p = new Probe();
+    p->task_id = task_id;
+    p->type = probe.type();
+    p->fd = fd;
+    p->phase = kPhaseConnecting;
+    p->sent = 0;
+    p->start_time = now;
+    p->deadline = now + timeout * 1000;
+
+    if (proto::kProbeHttp == probe.type()) {
+        std::string path = probe.path().empty() ? "/" : probe.path();
+        p->request = "GET " + path + " HTTP/1.0\r\n"
+                     "Host: 127.0.0.1:" + boost::lexical_cast<std::string>(port) + "\r\n"
+                     "User-Agent: galaxy-appworker\r\n"
+                     "Connection: close\r\n\r\n";
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLOUT;
+    ev.data.fd = fd;
+
+    if (0 != epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev)) {
+        LOG(WARNING) << "add probe fd to epoll fail, task: " << task_id
+                     << ", err: " << strerror(errno);
+        close(fd);
+        delete p;
+        return -1;
+    }
+
+    probes_[fd] = p;
+    task_fds_[task_id] = fd;
+    states_[task_id] = kProbeRunning;
+    return 0;
+}
+
+int HealthProber::Query(const std::string& task_id, ProbeState& state) {
+    MutexLock lock(&mutex_);
+    std::map<std::string, ProbeState>::iterator it = states_.find(task_id);
+
+    if (it == states_.end()) {
+        return -1;
+    }
+
+    state = it->second;
+    return 0;
+}
+
+void HealthProber::Clear(const std::string& task_id) {
+    MutexLock lock(&mutex_);
+    std::map<std::string, int>::iterator it = task_fds_.find(task_id);
+
+    if (it != task_fds_.end()) {
+        std::map<int, Probe*>::iterator p_it = probes_.find(it->second);
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, it->second, NULL);
+        close(it->second);
+        if (p_it != probes_.end()) {
+            delete p_it->second;
+            probes_.erase(p_it);
+        }
+        task_fds_.erase(it);
+    }
+
+    states_.erase(task_id);
+}
+
+void HealthProber::Remove(const std::string& task_id) {
+    Clear(task_id);
+    MutexLock lock(&mutex_);
+    stats_.erase(task_id);
+}
+
+int HealthProber::GetStat(const std::string& task_id, ProbeStat& stat) {
+    MutexLock lock(&mutex_);
+    std::map<std::string, ProbeStat>::iterator it = stats_.find(task_id);
+
+    if (it == stats_.end()) {
+        return -1;
+    }
+
+    stat = it->second;
+    return 0;
+}
+
+void HealthProber::Loop() {
+    struct epoll_event events[kMaxEvents];
+
+    while (true) {
+        int n = epoll_wait(epfd_, events, kMaxEvents, kWaitInterval);
+        if (n < 0 && EINTR != errno) {
+            LOG(WARNING) << "epoll wait fail, err: " << strerror(errno);
+        }
+
+        MutexLock lock(&mutex_);
+        if (!running_) {
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            // the probe may be cleared while waiting
+            std::map<int, Probe*>::iterator it = probes_.find(events[i].data.fd);
+            if (it != probes_.end()) {
+                HandleEvent(it->second, events[i].events);
+            }
+        }
+
+        int64_t now = common::timer::get_micros();
+        std::vector<Probe*> expired;
+        std::map<int, Probe*>::iterator it = probes_.begin();
+        for (; it != probes_.end(); ++it) {
+            if (it->second->deadline < now) {
+                expired.push_back(it->second);
+            }
+        }
+
+        for (size_t i = 0; i < expired.size(); i++) {
+            LOG(INFO) << "probe of task: " << expired[i]->task_id << " timeout";
+            Finish(expired[i], false);
+        }
+    }
+}
+
+void HealthProber::HandleEvent(Probe* probe, uint32_t events) {
+    mutex_.AssertHeld();
+
+    if (kPhaseConnecting == probe->phase) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (0 != getsockopt(probe->fd, SOL_SOCKET, SO_ERROR, &err, &len) || 0 != err
+                || (events & (EPOLLERR | EPOLLHUP))) {
+            Finish(probe, false);
+            return;
+        }
+
+        if (proto::kProbeHttp != probe->type) {
+            Finish(probe, true);
+            return;
+        }
+
+        probe->phase = kPhaseSending;
+    }
+
+    if (kPhaseSending == probe->phase) {
+        if (!Send(probe)) {
+            Finish(probe, false);
+            return;
+        }
+
+        if (probe->sent == probe->request.size()) {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.fd = probe->fd;
+            epoll_ctl(epfd_, EPOLL_CTL_MOD, probe->fd, &ev);
+            probe->phase = kPhaseReceiving;
+        }
+        return;
+    }
+
+    int ret = Receive(probe);
+    if (0 != ret) {
+        Finish(probe, ret > 0);
+    }
+}
+
+bool HealthProber::Send(Probe* probe) {
+    while (probe->sent < probe->request.size()) {
+        ssize_t n = write(probe->fd,
+                          probe->request.data() + probe->sent,
+                          probe->request.size() - probe->sent);
+        if (n < 0) {
+            return EAGAIN == errno || EINTR == errno;
+        }
+        probe->sent += n;
+    }
+    return true;
+}
+
+int HealthProber::Receive(Probe* probe) {
+    char buf[1024];
+    bool eof = false;
+
+    while (probe->response.size() < kMaxResponseSize) {
+        ssize_t n = read(probe->fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (EAGAIN == errno || EINTR == errno) {
+                break;
+            }
+            return -1;
+        }
+        if (0 == n) {
+            eof = true;
+            break;
+        }
+        probe->response.append(buf, n);
+    }
+
+    // only the status line matters, eg: HTTP/1.1 200 OK
+    std::string::size_type end = probe->response.find("\r\n");
+    if (std::string::npos == end) {
+        return (eof || probe->response.size() >= kMaxResponseSize) ? -1 : 0;
+    }
+
+    std::string::size_type pos = probe->response.find(' ');
+    if (0 != probe->response.compare(0, 5, "HTTP/") || pos >= end) {
+        return -1;
+    }
+
+    int code = atoi(probe->response.c_str() + pos + 1);
+    return (code >= 200 && code < 400) ? 1 : -1;
+}
+
+void HealthProber::Finish(Probe* probe, bool ok) {
+    mutex_.AssertHeld();
+    int64_t latency = common::timer::get_micros() - probe->start_time;
+    epoll_ctl(epfd_, EPOLL_CTL_DEL, probe->fd, NULL);
+    close(probe->fd);
+
+    ProbeStat& stat = stats_[probe->task_id];
+    stat.Add(latency, ok);
+    states_[probe->task_id] = ok ? kProbeSucceeded : kProbeFailed;
+    LOG(INFO) << "probe of task: " << probe->task_id
+              << (ok ? " succeeded" : " failed") << " in " << latency / 1000
+              << "ms, " << stat.ToString();
+
+    task_fds_.erase(probe->task_id);
+    probes_.erase(probe->fd);
+    delete probe;
+}
+
+}   // ending namespace galaxy
+}   // ending namespace baidu
@@ -0,0 +1,99 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BAIDU_GALAXY_HEALTH_PROBER_H
+#define BAIDU_GALAXY_HEALTH_PROBER_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include <mutex.h>
+#include <thread_pool.h>
+
+#include "protocol/galaxy.pb.h"
+#include "latency_histogram.h"
+
+namespace baidu {
+namespace galaxy {
+
+enum ProbeState {
+    kProbeRunning = 1,
+    kProbeSucceeded = 2,
+    kProbeFailed = 3,
+};
+
+// results and latency of the finished probes of a task
+struct ProbeStat {
+    ProbeStat();
+    void Add(int64_t latency_us, bool ok);
+    std::string ToString() const;
+
+    LatencyHistogram latency;
+    int64_t succeeded;
+    int64_t failed;
+};
+
+// Runs tcp-connect and http-get checks on one epoll thread instead of
+// forking a check command per task. Probes are keyed by task id, one
+// probe of a task is in flight at a time.
+class HealthProber {
+public:
+    HealthProber();
+    ~HealthProber();
+
+    int Start(const std::string& task_id,
+              const proto::HealthProbe& probe,
+              int32_t port);
+    int Query(const std::string& task_id, ProbeState& state);
+    // stops the probe in flight, stats of the task are kept for its next probes
+    void Clear(const std::string& task_id);
+    // stops the probe in flight and drops the stats, for tasks gone for good
+    void Remove(const std::string& task_id);
+    int GetStat(const std::string& task_id, ProbeStat& stat);
+
+private:
+    enum Phase {
+        kPhaseConnecting = 1,
+        kPhaseSending = 2,
+        kPhaseReceiving = 3,
+    };
+
+    struct Probe {
+        std::string task_id;
+        proto::ProbeType type;
+        int fd;
+        Phase phase;
+        std::string request;
+        size_t sent;
+        std::string response;
+        int64_t start_time;
+        int64_t deadline;
+    };
+
+    void Loop();
+    void HandleEvent(Probe* probe, uint32_t events);
+    bool Send(Probe* probe);
+    // -1 for failed, 0 for waiting more, 1 for succeeded
+    int Receive(Probe* probe);
+    void Finish(Probe* probe, bool ok);
+
+private:
+    Mutex mutex_;
+    int epfd_;
+    bool running_;
+    // key: fd
+    std::map<int, Probe*> probes_;
+    // key: task id
+    std::map<std::string, int> task_fds_;
+    std::map<std::string, ProbeState> states_;
+    std::map<std::string, ProbeStat> stats_;
+    ThreadPool loop_pool_;
+};
+
+}   // ending namespace galaxy
+}   // ending namespace baidu
+
+#endif  // BAIDU_GALAXY_HEALTH_PROBER_H
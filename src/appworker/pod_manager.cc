@@ -848,6 +848,9 @@ void PodManager::LoopCheckPodService() {
     MutexLock lock(&mutex_);
     LOG(INFO) << "loop check pod service";
     std::vector<ServiceInfo>::iterator it = pod_.services.begin();
+    // one snapshot of listening ports serves all services of this round
+    net::PortSet ports;
+    bool ports_loaded = false;
 
     for (; it != pod_.services.end(); ++it) {
         int32_t port = boost::lexical_cast<int32_t>(it->port());
@@ -860,7 +863,14 @@ void PodManager::LoopCheckPodService() {
                 it->set_status(proto::kOk);
             }
         } else {
-            if (net::IsPortOpen(port)) {
+            if (!ports_loaded) {
+                if (!net::ListeningPorts(&ports)) {
+                    LOG(WARNING) << "list listening ports failed";
+                }
+                ports_loaded = true;
+            }
+
+            if (ports.find(port) != ports.end()) {
                 it->set_status(proto::kOk);
             } else {
                 it->set_status(proto::kError);
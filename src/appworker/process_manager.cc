@@ -120,7 +120,11 @@ int ProcessManager::CreateProcess(const ProcessEnv& env,
         std::vector<std::string>::const_iterator c_it = env.cgroup_paths.begin();
 
         for (; c_it != env.cgroup_paths.end(); ++c_it) {
+            // cgroup v2 has no tasks file
             std::string path = *c_it + "/tasks";
+            if (0 != ::access(path.c_str(), F_OK)) {
+                path = *c_it + "/cgroup.procs";
+            }
             std::string content = boost::lexical_cast<std::string>(my_pid);
             bool ok = file::Write(path, content);
 
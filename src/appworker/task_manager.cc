@@ -410,6 +410,10 @@ int TaskManager::CleanTask(const std::string& task_id) {
 int TaskManager::ClearTasks() {
     MutexLock lock(&mutex_);
     LOG(INFO) << "clear all tasks";
+    std::map<std::string, Task*>::iterator it = tasks_.begin();
+    for (; it != tasks_.end(); ++it) {
+        health_prober_.Remove(it->first);
+    }
     tasks_.clear();
 
     process_manager_.ClearProcesses();
@@ -759,9 +763,23 @@ int TaskManager::StartTaskHealthCheck(const std::string& task_id) {
         return -1;
     }
 
-    LOG(INFO) << "start create health check process for task: " << task_id;
     Task* task = it->second;
 
+    if (task->desc.has_exe_package()
+            && task->desc.exe_package().has_health_probe()) {
+        int32_t port = 0;
+
+        if (0 != ProbePort(task, port)) {
+            LOG(WARNING) << "health probe port invalid, task: " << task_id;
+            return -1;
+        }
+
+        LOG(INFO) << "start health probe for task: " << task_id << ", port: " << port;
+        return health_prober_.Start(task_id, task->desc.exe_package().health_probe(), port);
+    }
+
+    LOG(INFO) << "start create health check process for task: " << task_id;
+
     if (task->desc.has_exe_package()
             && task->desc.exe_package().has_health_cmd()
             && task->desc.exe_package().health_cmd() != "") {
@@ -796,6 +814,26 @@ int TaskManager::CheckTaskHealth(const std::string& task_id, Task& task) {
 
     LOG(INFO) << "check health task, task: " << task_id;
 
+    if (it->second->desc.has_exe_package()
+            && it->second->desc.exe_package().has_health_probe()) {
+        ProbeState state = kProbeFailed;
+
+        if (0 != health_prober_.Query(task_id, state)) {
+            LOG(WARNING) << "query health probe of task: " << task_id << " fail";
+            return -1;
+        }
+
+        if (kProbeRunning == state) {
+            task.status = proto::kTaskRunning;
+        } else if (kProbeSucceeded == state) {
+            task.status = proto::kTaskFinished;
+        } else {
+            task.status = proto::kTaskFailed;
+        }
+
+        return 0;
+    }
+
     if (!it->second->desc.has_exe_package()
             || !it->second->desc.exe_package().has_health_cmd()
             || it->second->desc.exe_package().health_cmd() == "") {
@@ -839,6 +877,25 @@ int TaskManager::ClearTaskHealthCheck(const std::string& task_id) {
     LOG(INFO) << "clear task health check, task: " << task_id;
     std::string process_id = task_id + "_check";
     process_manager_.KillProcess(process_id);
+    health_prober_.Clear(task_id);
+
+    return 0;
+}
+
+int TaskManager::ProbePort(const Task* task, int32_t& port) {
+    const std::string& name = task->desc.exe_package().health_probe().port();
+    std::map<std::string, std::string>::const_iterator it = task->env.ports.find(name);
+    const std::string& value = it == task->env.ports.end() ? name : it->second;
+
+    try {
+        port = boost::lexical_cast<int32_t>(value);
+    } catch (boost::bad_lexical_cast& e) {
+        return -1;
+    }
+
+    if (port <= 0 || port > 65535) {
+        return -1;
+    }
 
     return 0;
 }
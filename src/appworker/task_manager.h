@@ -15,6 +15,7 @@
 #include "protocol/galaxy.pb.h"
 #include "protocol/appworker.pb.h"
 #include "process_manager.h"
+#include "health_prober.h"
 
 namespace baidu {
 namespace galaxy {
@@ -78,11 +79,13 @@ public:
 
 private:
     int DoStartTask(const std::string& task_id);
+    int ProbePort(const Task* task, int32_t& port);
 
 private:
     Mutex mutex_;
     std::map<std::string, Task*> tasks_;
     ProcessManager process_manager_;
+    HealthProber health_prober_;
     ThreadPool background_pool_;
 };
 
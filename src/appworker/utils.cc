@@ -15,9 +15,15 @@
 #include <linux/kdev_t.h>
 #include <set>
 #include <fstream>
+#include <sstream>
+#include <stdlib.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -911,58 +917,133 @@ std::string Md5Sum6(std::string dat) {
 
 namespace net {
 
-template <typename ElemT>
-struct HexTo {
-    ElemT value;
-    operator ElemT() const {return value;}
-    friend std::istream& operator>>(std::istream& in, HexTo& out) {
-        in >> std::hex >> out.value;
-        return in;
+static bool DumpSockDiag(uint8_t family,
+                         uint8_t protocol,
+                         uint32_t states,
+                         PortSet* ports) {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.nlh.nlmsg_len = sizeof(msg);
+    msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    msg.req.sdiag_family = family;
+    msg.req.sdiag_protocol = protocol;
+    msg.req.idiag_states = states;
+
+    struct sockaddr_nl nladdr;
+    memset(&nladdr, 0, sizeof(nladdr));
+    nladdr.nl_family = AF_NETLINK;
+
+    if (sendto(fd, &msg, sizeof(msg), 0,
+               reinterpret_cast<struct sockaddr*>(&nladdr),
+               sizeof(nladdr)) < 0) {
+        close(fd);
+        return false;
     }
-};
 
-bool IsPortInProcFile(const int32_t& port, const std::string& file_name) {
     bool ret = false;
+    bool done = false;
+    char buf[32768];
+    while (!done) {
+        ssize_t len = recv(fd, buf, sizeof(buf), 0);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            break;
+        }
+
+        struct nlmsghdr* h = reinterpret_cast<struct nlmsghdr*>(buf);
+        for (; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+            if (h->nlmsg_type == NLMSG_DONE) {
+                ret = true;
+                done = true;
+                break;
+            }
+            if (h->nlmsg_type == NLMSG_ERROR) {
+                // old kernels reject udp or ipv6 dumps, the caller falls back
+                done = true;
+                break;
+            }
+            struct inet_diag_msg* r = reinterpret_cast<struct inet_diag_msg*>(NLMSG_DATA(h));
+            ports->insert(ntohs(r->id.idiag_sport));
+        }
+    }
+
+    close(fd);
+    return ret;
+}
+
+// columns: sl local_address rem_address st ..., local_address is ADDR:PORT in hex
+static bool ReadProcNet(const std::string& file_name,
+                        bool listen_only,
+                        PortSet* ports) {
     std::ifstream net_file(file_name.c_str());
     if (!net_file) {
-        return ret;
+        return false;
     }
 
     std::string line;
-    std::vector<std::string> parts;
+    getline(net_file, line); // header
     while (getline(net_file, line)) {
-        boost::split(parts,
-                     line,
-                     boost::is_any_of(": "),
-                     boost::token_compress_on);
-        if (parts.size() > 3) {
-            try {
-                if (boost::lexical_cast<HexTo<int32_t> >(parts[3]) == port) {
-                    ret = true;
-                    break;
-                }
-            } catch (boost::bad_lexical_cast& e) {
-            }
+        std::istringstream in(line);
+        std::string sl;
+        std::string local;
+        std::string remote;
+        std::string st;
+        if (!(in >> sl >> local >> remote >> st)) {
+            continue;
+        }
+        if (listen_only && strtol(st.c_str(), NULL, 16) != TCP_LISTEN) {
+            continue;
         }
+        std::string::size_type pos = local.rfind(':');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        ports->insert(static_cast<int32_t>(strtol(local.c_str() + pos + 1, NULL, 16)));
     }
 
-    return ret;
+    return true;
 }
 
-bool IsPortOpen(int32_t port) {
-    bool ret = false;
-    std::string proc_net_tcp = "/proc/net/tcp";
-    std::string proc_net_udp = "/proc/net/udp";
+bool ListeningPorts(PortSet* ports) {
+    ports->clear();
+    const uint8_t families[] = {AF_INET, AF_INET6};
+    bool netlink_ok = true;
 
-    if (IsPortInProcFile(port, proc_net_tcp)) {
-        ret = true;
-    } else {
-        ret = IsPortInProcFile(port, proc_net_udp);
+    for (size_t i = 0; i < sizeof(families) / sizeof(families[0]) && netlink_ok; i++) {
+        netlink_ok = DumpSockDiag(families[i], IPPROTO_TCP, 1 << TCP_LISTEN, ports)
+                     && DumpSockDiag(families[i], IPPROTO_UDP, 0xffffffff, ports);
     }
 
+    if (netlink_ok) {
+        return true;
+    }
+
+    ports->clear();
+    bool ret = ReadProcNet("/proc/net/tcp", true, ports);
+    ret = ReadProcNet("/proc/net/udp", false, ports) && ret;
+    // missing when ipv6 is disabled
+    ReadProcNet("/proc/net/tcp6", true, ports);
+    ReadProcNet("/proc/net/udp6", false, ports);
     return ret;
 }
 
+bool IsPortOpen(int32_t port) {
+    PortSet ports;
+    ListeningPorts(&ports);
+    return ports.find(port) != ports.end();
+}
+
 } // ending namespace net
 
 } // ending namespace galaxy
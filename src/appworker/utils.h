@@ -11,6 +11,7 @@
 #include <vector>
 
 #include <boost/function.hpp>
+#include <boost/unordered_set.hpp>
 
 namespace baidu {
 namespace galaxy {
@@ -79,6 +80,12 @@ std::string Md5Sum6(const void* dat, size_t len);
 
 namespace net {
 
+typedef boost::unordered_set<int32_t> PortSet;
+
+// local ports of listening tcp and bound udp sockets, ipv4 and ipv6, taken in
+// one NETLINK_SOCK_DIAG dump per family and protocol; falls back to parsing
+// /proc/net once when sock_diag is not supported
+bool ListeningPorts(PortSet* ports);
 bool IsPortOpen(int32_t port);
 
 } // ending namespace net
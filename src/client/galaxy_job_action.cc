@@ -1107,6 +1107,7 @@ bool JobAction::GenerateJson(const std::string& jobid) {
         rapidjson::Value cpu(rapidjson::kObjectType);
         cpu.AddMember("millicores", sdk_task.cpu.milli_core, allocator);
         cpu.AddMember("excess", sdk_task.cpu.excess, allocator);
+        cpu.AddMember("exclusive", sdk_task.cpu.exclusive, allocator);
 
         rapidjson::Value mem(rapidjson::kObjectType);
         obj_str.SetString(StringUnit(sdk_task.memory.size).c_str(), allocator);
@@ -1127,6 +1128,12 @@ bool JobAction::GenerateJson(const std::string& jobid) {
 
         rapidjson::Value blkio(rapidjson::kObjectType);
         blkio.AddMember("weight", sdk_task.blkio.weight, allocator);
+        if (sdk_task.blkio.read_bps_limit > 0) {
+            blkio.AddMember("read_bps_limit", sdk_task.blkio.read_bps_limit, allocator);
+        }
+        if (sdk_task.blkio.write_bps_limit > 0) {
+            blkio.AddMember("write_bps_limit", sdk_task.blkio.write_bps_limit, allocator);
+        }
 
         rapidjson::Value ports(rapidjson::kArrayType);
         for (uint32_t j = 0; j < sdk_task.ports.size(); ++j) {
@@ -1167,6 +1174,29 @@ bool JobAction::GenerateJson(const std::string& jobid) {
             exec_package.AddMember("health_cmd", "", allocator);
         }
 
+        if (sdk_task.exe_package.health_probe.type != ::baidu::galaxy::sdk::kProbeNone) {
+            const ::baidu::galaxy::sdk::HealthProbe& sdk_probe = sdk_task.exe_package.health_probe;
+            rapidjson::Value health_probe(rapidjson::kObjectType);
+            if (sdk_probe.type == ::baidu::galaxy::sdk::kProbeHttp) {
+                health_probe.AddMember("type", "kProbeHttp", allocator);
+            } else {
+                health_probe.AddMember("type", "kProbeTcp", allocator);
+            }
+
+            obj_str.SetString(sdk_probe.port.c_str(), allocator);
+            health_probe.AddMember("port", obj_str, allocator);
+
+            if (!sdk_probe.path.empty()) {
+                obj_str.SetString(sdk_probe.path.c_str(), allocator);
+                health_probe.AddMember("path", obj_str, allocator);
+            }
+
+            if (sdk_probe.timeout > 0) {
+                health_probe.AddMember("timeout", sdk_probe.timeout, allocator);
+            }
+            exec_package.AddMember("health_probe", health_probe, allocator);
+        }
+
         exec_package.AddMember("package", package, allocator);
 
         rapidjson::Value data_packages(rapidjson::kArrayType);
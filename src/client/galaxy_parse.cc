@@ -43,6 +43,83 @@ int ParseDeploy(const rapidjson::Value& deploy_json, ::baidu::galaxy::sdk::Deplo
     }
     deploy->max_per_host = deploy_json["max_per_host"].GetInt();
 
+    //deploy config:max_surge, max_unavailable
+    if (deploy_json.HasMember("max_surge")) {
+        if (deploy_json["max_surge"].GetInt() < 0) {
+            fprintf(stderr, "max_surge in deploy must not be less than 0\n");
+            return -1;
+        }
+        deploy->max_surge = deploy_json["max_surge"].GetInt();
+    }
+
+    if (deploy_json.HasMember("max_unavailable")) {
+        if (deploy_json["max_unavailable"].GetInt() < 0) {
+            fprintf(stderr, "max_unavailable in deploy must not be less than 0\n");
+            return -1;
+        }
+        deploy->max_unavailable = deploy_json["max_unavailable"].GetInt();
+    }
+
+    //deploy config:spreads, eg: "rack:2,switch:4"
+    if (deploy_json.HasMember("spreads")) {
+        std::string str_spreads = deploy_json["spreads"].GetString();
+        std::vector<std::string> spreads;
+        ::baidu::common::SplitString(str_spreads, ",", &spreads);
+        for (size_t i = 0; i < spreads.size(); ++i) {
+            std::vector<std::string> kv;
+            ::baidu::common::SplitString(spreads[i], ":", &kv);
+            if (kv.size() != 2 || atoi(kv[1].c_str()) <= 0) {
+                fprintf(stderr, "spread %s in deploy must be domain:max_per_domain\n", spreads[i].c_str());
+                return -1;
+            }
+            ::baidu::galaxy::sdk::TopologySpread spread;
+            spread.domain = kv[0];
+            boost::trim(spread.domain);
+            spread.max_per_domain = atoi(kv[1].c_str());
+            deploy->spreads.push_back(spread);
+        }
+    }
+
+    //deploy config:anti_affinities, eg: "job_a,job_b:rack"
+    if (deploy_json.HasMember("anti_affinities")) {
+        std::string str_antis = deploy_json["anti_affinities"].GetString();
+        std::vector<std::string> antis;
+        ::baidu::common::SplitString(str_antis, ",", &antis);
+        for (size_t i = 0; i < antis.size(); ++i) {
+            std::vector<std::string> kv;
+            ::baidu::common::SplitString(antis[i], ":", &kv);
+            if (kv.size() < 1 || kv.size() > 2) {
+                fprintf(stderr, "anti affinity %s in deploy must be group[:domain]\n", antis[i].c_str());
+                return -1;
+            }
+            ::baidu::galaxy::sdk::AntiAffinity anti;
+            anti.container_group_id = kv[0];
+            boost::trim(anti.container_group_id);
+            if (kv.size() == 2) {
+                anti.domain = kv[1];
+                boost::trim(anti.domain);
+            }
+            deploy->anti_affinities.push_back(anti);
+        }
+    }
+
+    //deploy config:gang, gang_min, gang_timeout
+    if (deploy_json.HasMember("gang")) {
+        deploy->gang = deploy_json["gang"].GetBool();
+    }
+
+    if (deploy_json.HasMember("gang_min")) {
+        if (deploy_json["gang_min"].GetInt() < 0) {
+            fprintf(stderr, "gang_min in deploy must not be less than 0\n");
+            return -1;
+        }
+        deploy->gang_min = deploy_json["gang_min"].GetInt();
+    }
+
+    if (deploy_json.HasMember("gang_timeout")) {
+        deploy->gang_timeout = deploy_json["gang_timeout"].GetInt();
+    }
+
     //deploy config:tag
     if (deploy_json.HasMember("tag")) {
         deploy->tag = deploy_json["tag"].GetString();
@@ -181,6 +258,12 @@ int ParseCpu(const rapidjson::Value& cpu_json, ::baidu::galaxy::sdk::CpuRequired
         cpu->excess = cpu_json["excess"].GetBool();
     }
 
+    if (!cpu_json.HasMember("exclusive")) {
+        cpu->exclusive = false;
+    } else {
+        cpu->exclusive = cpu_json["exclusive"].GetBool();
+    }
+
     return 0;
 
 }
@@ -256,6 +339,39 @@ int ParseImagePackage(const rapidjson::Value& image_json, ::baidu::galaxy::sdk::
         boost::trim(image->health_cmd);
     }
 
+    if (image_json.HasMember("health_probe")) {
+        const rapidjson::Value& probe_json = image_json["health_probe"];
+        ::baidu::galaxy::sdk::HealthProbe& probe = image->health_probe;
+        std::string type;
+        if (probe_json.HasMember("type")) {
+            type = probe_json["type"].GetString();
+        }
+        if (type.compare("kProbeTcp") == 0) {
+            probe.type = ::baidu::galaxy::sdk::kProbeTcp;
+        } else if (type.compare("kProbeHttp") == 0) {
+            probe.type = ::baidu::galaxy::sdk::kProbeHttp;
+        } else {
+            fprintf(stderr, "type of health_probe must be [kProbeTcp,kProbeHttp]\n");
+            return -1;
+        }
+
+        if (!probe_json.HasMember("port")) {
+            fprintf(stderr, "port is required in health_probe\n");
+            return -1;
+        }
+        probe.port = probe_json["port"].GetString();
+        boost::trim(probe.port);
+
+        if (probe_json.HasMember("path")) {
+            probe.path = probe_json["path"].GetString();
+            boost::trim(probe.path);
+        }
+
+        if (probe_json.HasMember("timeout")) {
+            probe.timeout = probe_json["timeout"].GetInt();
+        }
+    }
+
     if (!image_json.HasMember("package")) {
         fprintf(stderr, "package is required in exec_package\n");
         return -1;
@@ -408,6 +524,12 @@ int ParseBlkio(const rapidjson::Value& blkio_json, ::baidu::galaxy::sdk::BlkioRe
         return -1;
     }
     blkio->weight = blkio_json["weight"].GetInt();
+    if (blkio_json.HasMember("read_bps_limit")) {
+        blkio->read_bps_limit = blkio_json["read_bps_limit"].GetInt64();
+    }
+    if (blkio_json.HasMember("write_bps_limit")) {
+        blkio->write_bps_limit = blkio_json["write_bps_limit"].GetInt64();
+    }
     return 0;
 }
 
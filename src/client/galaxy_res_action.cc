@@ -75,6 +75,8 @@ bool ResAction::CreateContainerGroup(const std::string& json_file, const std::st
     request.desc.version = job.version;
     request.desc.volum_jobs.assign(job.volum_jobs.begin(), job.volum_jobs.end()); //attemp new
     request.desc.max_per_host = job.deploy.max_per_host;
+    request.desc.spreads.assign(job.deploy.spreads.begin(), job.deploy.spreads.end());
+    request.desc.anti_affinities.assign(job.deploy.anti_affinities.begin(), job.deploy.anti_affinities.end());
     request.desc.workspace_volum = job.pod.workspace_volum;
     request.desc.data_volums.assign(job.pod.data_volums.begin(), job.pod.data_volums.end());
     //request.desc.cmd_line = "sh appworker.sh";
@@ -147,7 +149,11 @@ bool ResAction::UpdateContainerGroup(const std::string& json_file, const std::st
     request.replica = job.deploy.replica;
     request.id = id;
     request.interval = job.deploy.interval;
+    request.max_surge = job.deploy.max_surge;
+    request.max_unavailable = job.deploy.max_unavailable;
     request.desc.max_per_host = job.deploy.max_per_host;
+    request.desc.spreads.assign(job.deploy.spreads.begin(), job.deploy.spreads.end());
+    request.desc.anti_affinities.assign(job.deploy.anti_affinities.begin(), job.deploy.anti_affinities.end());
     //request.name = job.name;
     request.desc.priority = job.type;
     request.desc.run_user = user_.user;
@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
 #include "src/appworker/utils.h"
 
 TEST(TestUtils, Md5File) {
@@ -16,6 +18,29 @@ TEST(TestUtils, IsPortOpen) {
     EXPECT_TRUE(ret);
 }
 
+TEST(TestUtils, ListeningPorts) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    ASSERT_EQ(0, bind(fd, (struct sockaddr*)&addr, sizeof(addr)));
+    ASSERT_EQ(0, listen(fd, 1));
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(0, getsockname(fd, (struct sockaddr*)&addr, &len));
+
+    baidu::galaxy::net::PortSet ports;
+    EXPECT_TRUE(baidu::galaxy::net::ListeningPorts(&ports));
+    EXPECT_TRUE(ports.find(ntohs(addr.sin_port)) != ports.end());
+    close(fd);
+
+    ports.clear();
+    baidu::galaxy::net::ListeningPorts(&ports);
+    EXPECT_TRUE(ports.find(ntohs(addr.sin_port)) == ports.end());
+}
+
 int main(int argc, char** argv) {
     testing::InitGoogleTest(&argc, argv);
     // Runs all tests using Google Test.
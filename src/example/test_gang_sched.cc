@@ -0,0 +1,138 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <gflags/gflags.h>
+#include <unistd.h>
+#include <map>
+#include <set>
+#include <vector>
+#include "src/resman/scheduler.h"
+
+DECLARE_int64(sched_interval);
+DECLARE_int64(gang_sched_interval);
+
+using baidu::galaxy::sched::Agent;
+using baidu::galaxy::sched::DevicePath;
+using baidu::galaxy::sched::Scheduler;
+using baidu::galaxy::sched::VolumInfo;
+namespace proto = baidu::galaxy::proto;
+
+static proto::ContainerDescription NewDesc(int64_t millicore, int64_t memory) {
+    proto::ContainerDescription desc;
+    desc.add_pool_names("test");
+    desc.mutable_workspace_volum()->set_size(100);
+    desc.mutable_workspace_volum()->set_medium(proto::kDisk);
+    desc.mutable_workspace_volum()->set_dest_path("/home/work");
+    proto::Cgroup* cgroup = desc.add_cgroups();
+    cgroup->mutable_cpu()->set_milli_core(millicore);
+    cgroup->mutable_memory()->set_size(memory);
+    return desc;
+}
+
+static proto::ContainerDescription NewGangDesc(int64_t millicore, int gang_timeout) {
+    proto::ContainerDescription desc = NewDesc(millicore, 1024);
+    desc.set_gang(true);
+    desc.set_gang_timeout(gang_timeout);
+    return desc;
+}
+
+static Agent::Ptr NewAgent(const std::string& endpoint, int64_t millicore, int64_t memory) {
+    std::map<DevicePath, VolumInfo> volums;
+    volums["/home"].medium = proto::kDisk;
+    volums["/home"].size = 1L << 30;
+    return Agent::Ptr(new Agent(endpoint, millicore, memory, volums,
+                                std::set<std::string>(), "test"));
+}
+
+static int CountStatus(Scheduler& scheduler, const std::string& id,
+                       proto::ContainerStatus status,
+                       std::vector<proto::ResourceError>* res_errs = NULL) {
+    std::vector<proto::ContainerStatistics> containers;
+    scheduler.ShowContainerGroup(id, containers);
+    int count = 0;
+    for (size_t i = 0; i < containers.size(); i++) {
+        if (containers[i].status() == status) {
+            count++;
+            if (res_errs != NULL) {
+                res_errs->push_back(containers[i].last_res_err());
+            }
+        }
+    }
+    return count;
+}
+
+static bool WaitStatus(Scheduler& scheduler, const std::string& id,
+                       proto::ContainerStatus status, int count, int timeout_ms) {
+    for (int i = 0; i < timeout_ms / 10; i++) {
+        if (CountStatus(scheduler, id, status) == count) {
+            return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+// the periodic sweep is far away, gangs are placed by GangSchedule only
+class TestGangSched : public testing::Test {
+protected:
+    virtual void SetUp() {
+        FLAGS_sched_interval = 3600 * 1000;
+        FLAGS_gang_sched_interval = 10;
+        scheduler_.Start();
+    }
+    virtual void TearDown() {
+        scheduler_.Stop();
+    }
+    Scheduler scheduler_;
+};
+
+TEST_F(TestGangSched, QuorumMetCommits) {
+    scheduler_.AddAgent(NewAgent("agent1:8221", 2000, 8192), proto::AgentInfo());
+    scheduler_.AddAgent(NewAgent("agent2:8221", 2000, 8192), proto::AgentInfo());
+    std::string id = scheduler_.Submit("gang", NewGangDesc(1000, 60), 3,
+                                       proto::kJobService, "alice");
+    EXPECT_TRUE(WaitStatus(scheduler_, id, proto::kContainerAllocating, 3, 2000));
+    EXPECT_EQ(0, CountStatus(scheduler_, id, proto::kContainerPending));
+}
+
+TEST_F(TestGangSched, QuorumUnmetReleases) {
+    scheduler_.AddAgent(NewAgent("agent1:8221", 2000, 8192), proto::AgentInfo());
+    std::string gang = scheduler_.Submit("gang", NewGangDesc(1000, 60), 3,
+                                         proto::kJobService, "alice");
+    usleep(200000);
+    std::vector<proto::ResourceError> res_errs;
+    EXPECT_EQ(3, CountStatus(scheduler_, gang, proto::kContainerPending, &res_errs));
+    int unmet = 0;
+    for (size_t i = 0; i < res_errs.size(); i++) {
+        if (res_errs[i] == proto::kGangQuorumUnmet) {
+            unmet++;
+        }
+    }
+    EXPECT_EQ(2, unmet);
+
+    // nothing is left reserved on the agent
+    std::string job = scheduler_.Submit("job", NewDesc(1000, 1024), 2,
+                                        proto::kJobService, "alice");
+    EXPECT_TRUE(WaitStatus(scheduler_, job, proto::kContainerAllocating, 2, 2000));
+}
+
+TEST_F(TestGangSched, PartialGangReleasedAfterTimeout) {
+    scheduler_.AddAgent(NewAgent("agent1:8221", 1000, 8192), proto::AgentInfo());
+    scheduler_.AddAgent(NewAgent("agent2:8221", 1000, 8192), proto::AgentInfo());
+    std::string id = scheduler_.Submit("gang", NewGangDesc(1000, 1), 2,
+                                       proto::kJobService, "alice");
+    ASSERT_TRUE(WaitStatus(scheduler_, id, proto::kContainerAllocating, 2, 2000));
+
+    // the lost member finds no room, the one left waits for the timeout
+    scheduler_.RemoveAgent("agent2:8221");
+    EXPECT_EQ(1, CountStatus(scheduler_, id, proto::kContainerAllocating));
+    EXPECT_TRUE(WaitStatus(scheduler_, id, proto::kContainerPending, 2, 5000));
+    EXPECT_EQ(0, CountStatus(scheduler_, id, proto::kContainerAllocating));
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
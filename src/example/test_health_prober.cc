@@ -0,0 +1,122 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <unistd.h>
+#include <timer.h>
+#include "src/appworker/health_prober.h"
+
+using baidu::galaxy::HealthProber;
+using baidu::galaxy::ProbeStat;
+using baidu::galaxy::ProbeState;
+namespace proto = baidu::galaxy::proto;
+
+// a loopback listener which accepts into its backlog and never answers
+static int Listen(int32_t& port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (0 != bind(fd, (struct sockaddr*)&addr, sizeof(addr))
+            || 0 != listen(fd, 8)
+            || 0 != getsockname(fd, (struct sockaddr*)&addr, &len)) {
+        close(fd);
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static ProbeState WaitDone(HealthProber& prober, const std::string& task_id) {
+    ProbeState state = baidu::galaxy::kProbeRunning;
+    for (int i = 0; i < 500; i++) {
+        if (0 != prober.Query(task_id, state) || baidu::galaxy::kProbeRunning != state) {
+            break;
+        }
+        usleep(10000);
+    }
+    return state;
+}
+
+TEST(TestHealthProber, TcpSucceeded) {
+    int32_t port = 0;
+    int fd = Listen(port);
+    ASSERT_GE(fd, 0);
+
+    HealthProber prober;
+    proto::HealthProbe probe;
+    probe.set_type(proto::kProbeTcp);
+    probe.set_timeout(1000);
+    ASSERT_EQ(0, prober.Start("task_0", probe, port));
+    EXPECT_EQ(baidu::galaxy::kProbeSucceeded, WaitDone(prober, "task_0"));
+
+    ProbeStat stat;
+    ASSERT_EQ(0, prober.GetStat("task_0", stat));
+    EXPECT_EQ(1, stat.succeeded);
+    EXPECT_EQ(0, stat.failed);
+    EXPECT_EQ(1, stat.latency.Count());
+    close(fd);
+}
+
+TEST(TestHealthProber, HttpTimeout) {
+    int32_t port = 0;
+    int fd = Listen(port);
+    ASSERT_GE(fd, 0);
+
+    HealthProber prober;
+    proto::HealthProbe probe;
+    probe.set_type(proto::kProbeHttp);
+    probe.set_timeout(200);
+    int64_t start = baidu::common::timer::get_micros();
+    ASSERT_EQ(0, prober.Start("task_0", probe, port));
+    EXPECT_EQ(baidu::galaxy::kProbeFailed, WaitDone(prober, "task_0"));
+    EXPECT_GE(baidu::common::timer::get_micros() - start, 200000);
+
+    ProbeStat stat;
+    ASSERT_EQ(0, prober.GetStat("task_0", stat));
+    EXPECT_EQ(0, stat.succeeded);
+    EXPECT_EQ(1, stat.failed);
+    EXPECT_EQ(1, stat.latency.Count());
+    close(fd);
+}
+
+TEST(TestHealthProber, StatKeptUntilRemoved) {
+    int32_t port = 0;
+    int fd = Listen(port);
+    ASSERT_GE(fd, 0);
+
+    HealthProber prober;
+    proto::HealthProbe probe;
+    probe.set_type(proto::kProbeTcp);
+    probe.set_timeout(1000);
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(0, prober.Start("task_0", probe, port));
+        WaitDone(prober, "task_0");
+    }
+
+    ProbeStat stat;
+    prober.Clear("task_0");
+    ASSERT_EQ(0, prober.GetStat("task_0", stat));
+    EXPECT_EQ(2, stat.latency.Count());
+
+    prober.Remove("task_0");
+    EXPECT_EQ(-1, prober.GetStat("task_0", stat));
+    ProbeState state;
+    EXPECT_EQ(-1, prober.Query("task_0", state));
+    close(fd);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <gflags/gflags.h>
+#include <unistd.h>
+#include <map>
+#include <set>
+#include <vector>
+#include "src/resman/scheduler.h"
+
+DECLARE_int64(sched_interval);
+
+using baidu::galaxy::sched::Agent;
+using baidu::galaxy::sched::DevicePath;
+using baidu::galaxy::sched::Scheduler;
+using baidu::galaxy::sched::VolumInfo;
+namespace proto = baidu::galaxy::proto;
+
+static proto::ContainerDescription NewDesc(int64_t millicore, int64_t memory) {
+    proto::ContainerDescription desc;
+    desc.add_pool_names("test");
+    desc.mutable_workspace_volum()->set_size(100);
+    desc.mutable_workspace_volum()->set_medium(proto::kDisk);
+    desc.mutable_workspace_volum()->set_dest_path("/home/work");
+    proto::Cgroup* cgroup = desc.add_cgroups();
+    cgroup->mutable_cpu()->set_milli_core(millicore);
+    cgroup->mutable_memory()->set_size(memory);
+    return desc;
+}
+
+static Agent::Ptr NewAgent(const std::string& endpoint, int64_t millicore, int64_t memory,
+                           const std::string& pool_name = "test") {
+    std::map<DevicePath, VolumInfo> volums;
+    volums["/home"].medium = proto::kDisk;
+    volums["/home"].size = 1L << 30;
+    return Agent::Ptr(new Agent(endpoint, millicore, memory, volums,
+                                std::set<std::string>(), pool_name));
+}
+
+static int CountStatus(Scheduler& scheduler, const std::string& id,
+                       proto::ContainerStatus status,
+                       std::vector<std::string>* container_ids = NULL) {
+    std::vector<proto::ContainerStatistics> containers;
+    scheduler.ShowContainerGroup(id, containers);
+    int count = 0;
+    for (size_t i = 0; i < containers.size(); i++) {
+        if (containers[i].status() == status) {
+            count++;
+            if (container_ids != NULL) {
+                container_ids->push_back(containers[i].id());
+            }
+        }
+    }
+    return count;
+}
+
+// the periodic sweep is far away, only events can place the containers
+static bool WaitAllocating(Scheduler& scheduler, const std::string& id, int count) {
+    for (int i = 0; i < 200; i++) {
+        if (CountStatus(scheduler, id, proto::kContainerAllocating) == count) {
+            return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+class TestSchedEvents : public testing::Test {
+protected:
+    virtual void SetUp() {
+        FLAGS_sched_interval = 3600 * 1000;
+        scheduler_.Start();
+    }
+    virtual void TearDown() {
+        scheduler_.Stop();
+    }
+    Scheduler scheduler_;
+};
+
+TEST_F(TestSchedEvents, NewAgentTakesPending) {
+    std::string id = scheduler_.Submit("job", NewDesc(1000, 1024), 2,
+                                       proto::kJobService, "alice");
+    EXPECT_EQ(2, CountStatus(scheduler_, id, proto::kContainerPending));
+    scheduler_.AddAgent(NewAgent("agent1:8221", 4000, 8192), proto::AgentInfo());
+    EXPECT_TRUE(WaitAllocating(scheduler_, id, 2));
+}
+
+TEST_F(TestSchedEvents, SubmitPlacedAtOnce) {
+    scheduler_.AddAgent(NewAgent("agent1:8221", 4000, 8192), proto::AgentInfo());
+    std::string id = scheduler_.Submit("job", NewDesc(1000, 1024), 3,
+                                       proto::kJobService, "alice");
+    EXPECT_TRUE(WaitAllocating(scheduler_, id, 3));
+}
+
+TEST_F(TestSchedEvents, FreedCapacityGoesToPending) {
+    scheduler_.AddAgent(NewAgent("agent1:8221", 1000, 8192), proto::AgentInfo());
+    std::string first = scheduler_.Submit("first", NewDesc(1000, 1024), 1,
+                                          proto::kJobService, "alice");
+    ASSERT_TRUE(WaitAllocating(scheduler_, first, 1));
+    std::string second = scheduler_.Submit("second", NewDesc(1000, 1024), 1,
+                                           proto::kJobService, "alice");
+    usleep(50000);
+    EXPECT_EQ(1, CountStatus(scheduler_, second, proto::kContainerPending));
+
+    std::vector<std::string> container_ids;
+    CountStatus(scheduler_, first, proto::kContainerAllocating, &container_ids);
+    ASSERT_EQ(1u, container_ids.size());
+    EXPECT_TRUE(scheduler_.ChangeStatus(first, container_ids[0], proto::kContainerTerminated));
+    EXPECT_TRUE(WaitAllocating(scheduler_, second, 1));
+}
+
+TEST_F(TestSchedEvents, PoolsKeptApart) {
+    scheduler_.AddAgent(NewAgent("agent1:8221", 4000, 8192, "online"), proto::AgentInfo());
+    std::string id = scheduler_.Submit("job", NewDesc(1000, 1024), 1,
+                                       proto::kJobBatch, "alice");
+    usleep(50000);
+    EXPECT_EQ(1, CountStatus(scheduler_, id, proto::kContainerPending));
+    scheduler_.SetPool("agent1:8221", "test");
+    EXPECT_TRUE(WaitAllocating(scheduler_, id, 1));
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
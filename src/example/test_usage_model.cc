@@ -0,0 +1,75 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <gflags/gflags.h>
+#include "src/resman/usage_model.h"
+
+DECLARE_double(reserved_percent);
+DECLARE_double(usage_ewma_alpha);
+DECLARE_int32(usage_window);
+DECLARE_int32(usage_percentile);
+
+using baidu::galaxy::sched::UsageModel;
+
+class UsageModelTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        FLAGS_reserved_percent = 1.0;
+        FLAGS_usage_ewma_alpha = 0.5;
+        FLAGS_usage_window = 4;
+        FLAGS_usage_percentile = 100;
+    }
+};
+
+TEST_F(UsageModelTest, ReserveAllBeforeReports) {
+    UsageModel model;
+    EXPECT_EQ(0, model.Predict());
+    EXPECT_EQ(1000, model.Reserve(1000));
+    model.Add(100);
+    EXPECT_EQ(100, model.Reserve(1000));
+}
+
+TEST_F(UsageModelTest, EwmaFollowsTrend) {
+    FLAGS_usage_percentile = 0;
+    UsageModel model;
+    model.Add(100);
+    model.Add(300);
+    EXPECT_EQ(200, model.Predict());
+    model.Add(300);
+    EXPECT_EQ(250, model.Predict());
+}
+
+TEST_F(UsageModelTest, SpikeKeptInWindow) {
+    UsageModel model;
+    model.Add(900);
+    for (int i = 0; i < 3; i++) {
+        model.Add(100);
+        EXPECT_EQ(900, model.Predict());
+    }
+    model.Add(100);
+    EXPECT_LT(model.Predict(), 900);
+}
+
+TEST_F(UsageModelTest, ReserveCappedAtNeed) {
+    FLAGS_reserved_percent = 2.0;
+    UsageModel model;
+    model.Add(300);
+    EXPECT_EQ(600, model.Reserve(1000));
+    model.Add(800);
+    EXPECT_EQ(1000, model.Reserve(1000));
+}
+
+TEST_F(UsageModelTest, ClearForgetsReports) {
+    UsageModel model;
+    model.Add(100);
+    model.Clear();
+    EXPECT_EQ(0, model.Samples());
+    EXPECT_EQ(1000, model.Reserve(1000));
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
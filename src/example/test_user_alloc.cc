@@ -0,0 +1,93 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "src/resman/scheduler.h"
+
+using baidu::galaxy::sched::Scheduler;
+namespace proto = baidu::galaxy::proto;
+
+static proto::ContainerDescription NewDesc(int64_t millicore, int64_t memory) {
+    proto::ContainerDescription desc;
+    desc.add_pool_names("test");
+    desc.mutable_workspace_volum()->set_size(100);
+    desc.mutable_workspace_volum()->set_medium(proto::kDisk);
+    proto::Cgroup* cgroup = desc.add_cgroups();
+    cgroup->mutable_cpu()->set_milli_core(millicore);
+    cgroup->mutable_memory()->set_size(memory);
+    return desc;
+}
+
+static void ExpectAlloc(Scheduler& scheduler, const std::string& user,
+                        int64_t millicore, int64_t memory, int64_t replica) {
+    proto::Quota alloc;
+    scheduler.ShowUserAlloc(user, alloc);
+    EXPECT_EQ(millicore, alloc.millicore());
+    EXPECT_EQ(memory, alloc.memory());
+    EXPECT_EQ(replica, alloc.replica());
+    std::string diff;
+    EXPECT_TRUE(scheduler.CheckUserAllocs(diff)) << diff;
+}
+
+TEST(TestUserAlloc, SubmitAndScale) {
+    Scheduler scheduler;
+    std::string id = scheduler.Submit("job", NewDesc(1000, 1024), 3,
+                                      proto::kJobService, "alice");
+    ExpectAlloc(scheduler, "alice", 3000, 3072, 3);
+    ExpectAlloc(scheduler, "bob", 0, 0, 0);
+
+    EXPECT_TRUE(scheduler.ChangeReplica(id, 1));
+    ExpectAlloc(scheduler, "alice", 1000, 1024, 1);
+
+    EXPECT_TRUE(scheduler.ChangeReplica(id, 5));
+    ExpectAlloc(scheduler, "alice", 5000, 5120, 5);
+}
+
+TEST(TestUserAlloc, BestEffortOnlyChargesReplica) {
+    Scheduler scheduler;
+    scheduler.Submit("service", NewDesc(1000, 1024), 2, proto::kJobService, "alice");
+    scheduler.Submit("best_effort", NewDesc(1000, 1024), 4, proto::kJobBestEffort, "alice");
+    ExpectAlloc(scheduler, "alice", 2000, 2048, 6);
+}
+
+TEST(TestUserAlloc, UpdateRecharges) {
+    Scheduler scheduler;
+    std::string id = scheduler.Submit("job", NewDesc(1000, 1024), 2,
+                                      proto::kJobService, "alice");
+    std::string version;
+    EXPECT_TRUE(scheduler.Update(id, NewDesc(2000, 1024), 0, 0, 1, version));
+    ExpectAlloc(scheduler, "alice", 4000, 2048, 2);
+}
+
+TEST(TestUserAlloc, KillReleases) {
+    Scheduler scheduler;
+    std::string id = scheduler.Submit("job", NewDesc(1000, 1024), 2,
+                                      proto::kJobService, "alice");
+    scheduler.Submit("job", NewDesc(500, 512), 2, proto::kJobService, "bob");
+    EXPECT_TRUE(scheduler.Kill(id));
+    ExpectAlloc(scheduler, "alice", 0, 0, 0);
+    ExpectAlloc(scheduler, "bob", 1000, 1024, 2);
+}
+
+TEST(TestUserAlloc, StatusChanges) {
+    Scheduler scheduler;
+    std::string id = scheduler.Submit("job", NewDesc(1000, 1024), 2,
+                                      proto::kJobService, "alice");
+    std::vector<proto::ContainerStatistics> containers;
+    EXPECT_TRUE(scheduler.ShowContainerGroup(id, containers));
+    ASSERT_EQ(2u, containers.size());
+
+    scheduler.ChangeStatus(id, containers[0].id(), proto::kContainerAllocating);
+    scheduler.ChangeStatus(id, containers[1].id(), proto::kContainerReady);
+    ExpectAlloc(scheduler, "alice", 2000, 2048, 2);
+
+    scheduler.ChangeStatus(id, containers[1].id(), proto::kContainerDestroying);
+    ExpectAlloc(scheduler, "alice", 1000, 1024, 1);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -10,23 +10,75 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <math.h>
+#include <algorithm>
+#include <iterator>
 #include "private_sdk.h"
 
 namespace baidu {
 namespace galaxy {
 
 CurlThreadPool* CurlThreadPool::instance_ = NULL;
+pthread_once_t CurlThreadPool::once_ = PTHREAD_ONCE_INIT;
+
+void CurlThreadPool::Init() {
+	instance_ = new CurlThreadPool();
+}
+
+CurlThreadPool* CurlThreadPool::GetInstance() {
+	pthread_once(&once_, &CurlThreadPool::Init);
+	return instance_;
+}
+
+static const std::string kAppMasterPath = "/appmaster";
+
+PrivateSubscribeSdk::PrivateSubscribeSdk (const std::string& service_name,
+								int update_interval,
+								int timeout_interval) {
+	service_name_.assign(service_name);
+	update_interval_ = update_interval;
+	timeout_interval_ = timeout_interval;
+	init_ = false;
+	stop_ = false;
+	version_ = -1;
+	add_func_ = NULL;
+	del_func_ = NULL;
+	chg_func_ = NULL;	
+	nexus_ = NULL;
+	appmaster_stub_ = NULL;
+}
 
 PrivateSubscribeSdk::PrivateSubscribeSdk (const std::string& service_name,
+								const std::string& nexus_servers,
+								const std::string& nexus_root,
 								int update_interval,
 								int timeout_interval) {
 	service_name_.assign(service_name);
 	update_interval_ = update_interval;
 	timeout_interval_ = timeout_interval;
 	init_ = false;
+	stop_ = false;
+	version_ = -1;
 	add_func_ = NULL;
 	del_func_ = NULL;
 	chg_func_ = NULL;	
+	nexus_ = new ::galaxy::ins::sdk::InsSDK(nexus_servers);
+	appmaster_key_ = nexus_root + kAppMasterPath;
+	appmaster_stub_ = NULL;
+}
+
+PrivateSubscribeSdk::~PrivateSubscribeSdk() {
+	{
+		MutexLock lock(&mutex_);
+		stop_ = true;
+	}
+	worker_.Stop(true);
+	delete appmaster_stub_;
+	delete nexus_;
+}
+
+void PrivateSubscribeSdk::RegistHandler(HandleFunc* func) {
+	chg_func_ = *func;
+	return;
 }
 
 void PrivateSubscribeSdk::RegistAddHandler(HandleFunc func) {
@@ -53,16 +105,122 @@ void PrivateSubscribeSdk::GetServiceList(std::vector<std::string>* addr_list) {
 	return;
 }
 
-void PrivateSubscribeSdk::ReloadService() {
-    return;
+bool PrivateSubscribeSdk::UpdateAppMasterStub() {
+	::galaxy::ins::sdk::SDKError err;
+	std::string endpoint;
+	if (!nexus_->Get(appmaster_key_, &endpoint, &err)) {
+		LOG(WARNING) << "get appmaster endpoint from nexus failed: "
+		             << ::galaxy::ins::sdk::InsSDK::StatusToString(err);
+		return false;
+	}
+	delete appmaster_stub_;
+	appmaster_stub_ = NULL;
+	return rpc_client_.GetStub(endpoint, &appmaster_stub_);
+}
+
+bool PrivateSubscribeSdk::ReloadService(int wait) {
+	if (NULL == nexus_) {
+		return false;
+	}
+	if (NULL == appmaster_stub_ && !UpdateAppMasterStub()) {
+		return false;
+	}
+	::baidu::galaxy::proto::SubscribeServiceRequest request;
+	::baidu::galaxy::proto::SubscribeServiceResponse response;
+	request.set_service_name(service_name_);
+	request.set_version(version_);
+	request.set_timeout(wait);
+	bool ok = rpc_client_.SendRequest(appmaster_stub_,
+	                                  &::baidu::galaxy::proto::AppMaster_Stub::SubscribeService,
+	                                  &request, &response,
+	                                  (wait + timeout_interval_) / 1000 + 1, 1);
+	if (!ok || response.error_code().status() != ::baidu::galaxy::proto::kOk) {
+		LOG(WARNING) << "subscribe service " << service_name_ << " failed";
+		// appmaster may have moved
+		delete appmaster_stub_;
+		appmaster_stub_ = NULL;
+		return false;
+	}
+	ApplyChanges(response);
+	return true;
+}
+
+void PrivateSubscribeSdk::ApplyChanges(const ::baidu::galaxy::proto::SubscribeServiceResponse& response) {
+	std::vector<std::string> added;
+	std::vector<std::string> deleted;
+	std::vector<std::string> all;
+	{
+		MutexLock lock(&mutex_);
+		if (response.full()) {
+			std::map<std::string, std::string> fresh;
+			for (int i = 0; i < response.deltas_size(); i++) {
+				const ServiceInfo& service = response.deltas(i).service();
+				fresh[response.deltas(i).podid()] = service.ip() + ":" + service.port();
+			}
+			instances_.swap(fresh);
+		} else {
+			for (int i = 0; i < response.deltas_size(); i++) {
+				const ::baidu::galaxy::proto::ServiceDelta& delta = response.deltas(i);
+				if (delta.deleted()) {
+					instances_.erase(delta.podid());
+				} else {
+					instances_[delta.podid()] = delta.service().ip() + ":" + delta.service().port();
+				}
+			}
+		}
+
+		std::set<std::string> addrs;
+		std::map<std::string, std::string>::iterator it = instances_.begin();
+		for (; it != instances_.end(); it++) {
+			addrs.insert(it->second);
+		}
+		std::set_difference(addrs.begin(), addrs.end(),
+		                    addr_list_.begin(), addr_list_.end(),
+		                    std::back_inserter(added));
+		std::set_difference(addr_list_.begin(), addr_list_.end(),
+		                    addrs.begin(), addrs.end(),
+		                    std::back_inserter(deleted));
+		addr_list_.swap(addrs);
+		all.assign(addr_list_.begin(), addr_list_.end());
+		version_ = response.version();
+	}
+
+	if (!added.empty() && add_func_) {
+		add_func_(added);
+	}
+	if (!deleted.empty() && del_func_) {
+		del_func_(deleted);
+	}
+	if (response.full() && chg_func_) {
+		chg_func_(all);
+	}
+	return;
+}
+
+void PrivateSubscribeSdk::WatchService() {
+	{
+		MutexLock lock(&mutex_);
+		if (stop_) {
+			return;
+		}
+	}
+	if (ReloadService(update_interval_)) {
+		worker_.AddTask(boost::bind(&PrivateSubscribeSdk::WatchService, this));
+	} else {
+		worker_.DelayTask(timeout_interval_, boost::bind(&PrivateSubscribeSdk::WatchService, this));
+	}
 }
 
 void PrivateSubscribeSdk::Init() {
 	if (init_) {
 		return;
 	}
-	ReloadService();
+	// the first one gets all instances without waiting
+	ReloadService(0);
 	init_ = true;
+	if (NULL != nexus_) {
+		worker_.AddTask(boost::bind(&PrivateSubscribeSdk::WatchService, this));
+	}
 	return;
 }
 
@@ -7,24 +7,41 @@
 
 #include <vector>
 #include <set>
+#include <map>
 #include <string>
+#include <pthread.h>
 #include <boost/function.hpp>
 #include <thread_pool.h>
+#include "ins_sdk.h"
 #include "naming/sdk.h"
+#include "protocol/appmaster.pb.h"
+#include "rpc/rpc_client.h"
 
 namespace baidu {
 namespace galaxy {
+// Keeps the healthy ip:port of a service by subscribing to appmaster,
+// which answers each subscribe with the changes after the version held here.
+// Add and del handlers get the addresses that came and went, the refresh
+// handler gets the whole list when appmaster sends it over again.
 class PrivateSubscribeSdk : public SubscribeSdk {
 public:
 	PrivateSubscribeSdk(const std::string& service_name,
 					int update_interval = 10000,
 					int timeout_interval = 1000);
-    ~PrivateSubscribeSdk() {};
+	// update_interval is how long a subscribe waits on appmaster for changes
+	PrivateSubscribeSdk(const std::string& service_name,
+					const std::string& nexus_servers,
+					const std::string& nexus_root,
+					int update_interval = 10000,
+					int timeout_interval = 1000);
+    ~PrivateSubscribeSdk();
 
     void Init();
 
     void GetServiceList(std::vector<std::string>* addr_list);
 
+    void RegistHandler(HandleFunc* func);
+
     void RegistAddHandler(HandleFunc func); 
 
     void RegistDelHandler(HandleFunc func);
@@ -32,35 +49,44 @@ public:
     void RegistRefreshHandler(HandleFunc func);
 
 private:
-	void ReloadService();
+	bool ReloadService(int wait);
+	void WatchService();
+	bool UpdateAppMasterStub();
+	void ApplyChanges(const ::baidu::galaxy::proto::SubscribeServiceResponse& response);
 	ThreadPool worker_;
     Mutex mutex_;
     std::string service_name_;
     std::set<std::string> addr_list_;
+    // key: podid, value: ip:port
+    std::map<std::string, std::string> instances_;
+    int64_t version_;
     int update_interval_;
     int timeout_interval_;
     bool init_;
+    bool stop_;
     HandleFunc add_func_;
     HandleFunc del_func_;
     HandleFunc chg_func_;
+    ::galaxy::ins::sdk::InsSDK* nexus_;
+    std::string appmaster_key_;
+    RpcClient rpc_client_;
+    ::baidu::galaxy::proto::AppMaster_Stub* appmaster_stub_;
 };
 
 
 class CurlThreadPool {
 public:
-	static CurlThreadPool* GetInstance() {
-		if (instance_ == NULL) {
-			instance_ = new CurlThreadPool();
-		}
-		return instance_;
-	}
+	// created once, safe to call from concurrent job builders
+	static CurlThreadPool* GetInstance();
 	ThreadPool* GetThreadPool() {
 		return &worker_;
 	}
 private:
 	CurlThreadPool() {}
+	static void Init();
 	ThreadPool worker_;
 	static CurlThreadPool* instance_;
+	static pthread_once_t once_;
 };
 
 
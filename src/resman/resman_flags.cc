@@ -2,15 +2,25 @@
 
 DEFINE_string(resman_port, "1645", "resman listen port");
 DEFINE_int64(sched_interval, 50, "scheduling interval (ms)");
+DEFINE_int64(gang_sched_interval, 1000, "interval of placing gang container groups (ms)");
+DEFINE_bool(sched_on_events, true, "place pending containers right after the events freeing or asking for resources, besides the periodic sweep");
 DEFINE_int64(container_group_gc_check_interval, 30000, "container group gc check interval (ms)");
+DEFINE_int64(rolling_update_check_interval, 1000, "interval of moving the rolling updates on (ms)");
 DEFINE_string(nexus_root, "/galaxy3", "root prefix on nexus");
 DEFINE_string(nexus_addr, "", "nexus server list");
 DEFINE_int32(agent_timeout, 30 , "timeout of agent, in seconds");
 DEFINE_int32(agent_query_interval , 5, "query interval of agent, in seconds");
 DEFINE_int32(container_group_max_replica, 100000, "max replica allowed for one group");
 DEFINE_double(safe_mode_percent, 0.85, "when agent alive percent bigger than this, leave safe mode");
+DEFINE_bool(hot_standby, false, "keep meta and agent states warm while waiting for the resman lock");
+DEFINE_int32(standby_sync_interval, 2000, "interval of syncing meta changes from nexus in hot standby (ms)");
 DEFINE_bool(check_container_version, false, "by default, AM will handle that");
 DEFINE_int32(max_batch_pods, 12, "max batch pods per agent");
 
 DEFINE_int32(overassign_level, 2, "overassign level: {0, 1, 2, 3}");
 DEFINE_double(reserved_percent, 2.0, "resource reserved percent");
+DEFINE_double(usage_ewma_alpha, 1.0, "weight of the latest report in the usage trend of a container");
+DEFINE_int32(usage_window, 1, "reports of a container kept for its usage percentile");
+DEFINE_int32(usage_percentile, 100, "percentile of the recent usage a container is planned for, besides the trend");
+DEFINE_double(reserved_cpu_pressure, 0.0, "reserve the whole cpu required when cpu some avg10 of the container or its host exceeds it, 0 disables");
+DEFINE_double(reserved_memory_pressure, 0.0, "reserve the whole memory required when memory some avg10 of the container or its host exceeds it, 0 disables");
@@ -21,6 +21,8 @@ DECLARE_int32(agent_timeout);
 DECLARE_int32(agent_query_interval);
 DECLARE_int32(container_group_max_replica);
 DECLARE_double(safe_mode_percent);
+DECLARE_bool(hot_standby);
+DECLARE_int32(standby_sync_interval);
 
 const std::string sAgentPrefix = "/agent";
 const std::string sUserPrefix = "/user";
@@ -42,6 +44,7 @@ namespace galaxy {
 ResManImpl::ResManImpl() : scheduler_(new sched::Scheduler()),
                            safe_mode_(true),
                            force_safe_mode_(false),
+                           standby_(false),
                            start_time_(0) {
     nexus_ = new InsSDK(FLAGS_nexus_addr);
 }
@@ -49,6 +52,9 @@ ResManImpl::ResManImpl() : scheduler_(new sched::Scheduler()),
 ResManImpl::~ResManImpl() {
     delete scheduler_;
     delete nexus_;
+    for (size_t i = 0; i < response_pool_.size(); i++) {
+        delete response_pool_[i];
+    }
 }
 
 bool ResManImpl::Init() {
@@ -164,6 +170,204 @@ void ResManImpl::OnLockChange(std::string lock_session_id) {
     }
 }
 
+void ResManImpl::StartStandby() {
+    MutexLock lock(&mu_);
+    standby_ = true;
+    std::map<std::string, proto::AgentMeta>::const_iterator it;
+    for (it = agents_.begin(); it != agents_.end(); it++) {
+        TrackAgent(it->first);
+    }
+    LOG(INFO) << "enter hot standby, tracking " << agents_.size() << " agents";
+    query_pool_.DelayTask(FLAGS_standby_sync_interval,
+        boost::bind(&ResManImpl::SyncStandby, this)
+    );
+}
+
+void ResManImpl::SyncStandby() {
+    {
+        MutexLock lock(&mu_);
+        if (!standby_) {
+            return;
+        }
+    }
+    SyncFromNexus();
+    query_pool_.DelayTask(FLAGS_standby_sync_interval,
+        boost::bind(&ResManImpl::SyncStandby, this)
+    );
+}
+
+void ResManImpl::TakeOver() {
+    {
+        MutexLock lock(&mu_);
+        if (!standby_) {
+            return;
+        }
+    }
+    // catch up with the changes made since the last sync before serving
+    if (!SyncFromNexus()) {
+        LOG(WARNING) << "final sync before taking over failed";
+    }
+    bool leave_safe_mode_event = false;
+    {
+        MutexLock lock(&mu_);
+        standby_ = false;
+        size_t warm_agents = 0;
+        std::map<std::string, AgentStat>::const_iterator it;
+        for (it = agent_stats_.begin(); it != agent_stats_.end(); it++) {
+            if (it->second.status == proto::kAgentAlive
+                && agents_.find(it->first) != agents_.end()) {
+                warm_agents++;
+            }
+        }
+        LOG(INFO) << "take over with " << warm_agents << " of "
+                  << agents_.size() << " agents warm";
+        // agent states are as fresh as a cold start would wait for,
+        // so there is no need to sit in safe mode for agent_timeout
+        if (!force_safe_mode_ &&
+            safe_mode_ &&
+            warm_agents > (double)agents_.size() * FLAGS_safe_mode_percent) {
+            LOG(INFO) << "leave safe mode";
+            safe_mode_ = false;
+            leave_safe_mode_event = true;
+        }
+    }
+    if (leave_safe_mode_event) {
+        scheduler_->Start();
+    }
+}
+
+void ResManImpl::TrackAgent(const std::string& endpoint) {
+    mu_.AssertHeld();
+    if (agent_stats_.find(endpoint) != agent_stats_.end()) {
+        return;
+    }
+    AgentStat& agent = agent_stats_[endpoint];
+    agent.last_heartbeat_time = common::timer::now_time();
+    query_pool_.AddTask(
+        boost::bind(&ResManImpl::QueryAgent, this, endpoint, true)
+    );
+}
+
+bool ResManImpl::SyncFromNexus() {
+    MutexLock sync_lock(&sync_mu_);
+    std::map<std::string, proto::AgentMeta> agents;
+    std::set<std::string> agents_removed;
+    if (!DiffObjects(sAgentPrefix, agents, agents_removed)) {
+        LOG(WARNING) << "fail to sync agent meta";
+        return false;
+    }
+    {
+        MutexLock lock(&mu_);
+        std::map<std::string, proto::AgentMeta>::const_iterator it;
+        for (it = agents.begin(); it != agents.end(); it++) {
+            const std::string& endpoint = it->first;
+            const proto::AgentMeta& agent_meta = it->second;
+            std::map<std::string, proto::AgentMeta>::iterator old_it = agents_.find(endpoint);
+            if (old_it != agents_.end()) {
+                const std::string old_pool = old_it->second.pool();
+                if (old_pool != agent_meta.pool()) {
+                    pools_[old_pool].erase(endpoint);
+                    scheduler_->SetPool(endpoint, agent_meta.pool());
+                }
+            }
+            agents_[endpoint] = agent_meta;
+            pools_[agent_meta.pool()].insert(endpoint);
+            if (standby_) {
+                TrackAgent(endpoint);
+            }
+        }
+        std::set<std::string>::const_iterator rm_it;
+        for (rm_it = agents_removed.begin(); rm_it != agents_removed.end(); rm_it++) {
+            const std::string& endpoint = *rm_it;
+            std::map<std::string, proto::AgentMeta>::iterator old_it = agents_.find(endpoint);
+            if (old_it == agents_.end()) {
+                continue;
+            }
+            pools_[old_it->second.pool()].erase(endpoint);
+            agents_.erase(old_it);
+            agent_stats_.erase(endpoint);
+            const std::set<std::string>& tags = agent_tags_[endpoint];
+            std::set<std::string>::const_iterator tag_it;
+            for (tag_it = tags.begin(); tag_it != tags.end(); tag_it++) {
+                tags_[*tag_it].erase(endpoint);
+            }
+            agent_tags_.erase(endpoint);
+            scheduler_->RemoveAgent(endpoint);
+        }
+    }
+
+    std::map<std::string, proto::TagMeta> tags;
+    std::set<std::string> tags_removed;
+    if (!DiffObjects(sTagPrefix, tags, tags_removed)) {
+        LOG(WARNING) << "fail to sync tags meta";
+        return false;
+    }
+    {
+        MutexLock lock(&mu_);
+        std::map<std::string, proto::TagMeta>::const_iterator it;
+        for (it = tags.begin(); it != tags.end(); it++) {
+            const proto::TagMeta& tag_meta = it->second;
+            std::set<std::string> endpoints(tag_meta.endpoints().begin(),
+                                            tag_meta.endpoints().end());
+            SetTagMembers(it->first, endpoints);
+        }
+        std::set<std::string>::const_iterator rm_it;
+        for (rm_it = tags_removed.begin(); rm_it != tags_removed.end(); rm_it++) {
+            SetTagMembers(*rm_it, std::set<std::string>());
+            tags_.erase(*rm_it);
+        }
+    }
+
+    std::map<std::string, proto::UserMeta> users;
+    std::set<std::string> users_removed;
+    if (!DiffObjects(sUserPrefix, users, users_removed)) {
+        LOG(WARNING) << "fail to sync user meta";
+        return false;
+    }
+    if (!users.empty() || !users_removed.empty()) {
+        MutexLock lock(&mu_);
+        std::map<std::string, proto::UserMeta>::const_iterator it;
+        for (it = users.begin(); it != users.end(); it++) {
+            users_[it->first] = it->second;
+        }
+        std::set<std::string>::const_iterator rm_it;
+        for (rm_it = users_removed.begin(); rm_it != users_removed.end(); rm_it++) {
+            users_.erase(*rm_it);
+        }
+        users_can_create_.clear();
+        users_can_remove_.clear();
+        users_can_update_.clear();
+        users_can_list_.clear();
+        ReloadUsersAuth();
+    }
+
+    std::map<std::string, proto::ContainerGroupMeta> container_groups;
+    std::set<std::string> container_groups_removed;
+    if (!DiffObjects(sContainerGroupPrefix, container_groups, container_groups_removed)) {
+        LOG(WARNING) << "fail to sync container groups meta";
+        return false;
+    }
+    {
+        MutexLock lock(&mu_);
+        std::map<std::string, proto::ContainerGroupMeta>::const_iterator it;
+        for (it = container_groups.begin(); it != container_groups.end(); it++) {
+            container_groups_[it->first] = it->second;
+            scheduler_->Reload(it->second);
+        }
+        std::set<std::string>::const_iterator rm_it;
+        for (rm_it = container_groups_removed.begin();
+             rm_it != container_groups_removed.end(); rm_it++) {
+            container_groups_.erase(*rm_it);
+            scheduler_->Kill(*rm_it);
+        }
+    }
+    VLOG(10) << "synced from nexus, changed agents:" << agents.size()
+             << ", tags:" << tags.size()
+             << ", users:" << users.size()
+             << ", container groups:" << container_groups.size();
+    return true;
+}
+
 void ResManImpl::EnterSafeMode(::google::protobuf::RpcController* controller,
                                const ::baidu::galaxy::proto::EnterSafeModeRequest* request,
                                ::baidu::galaxy::proto::EnterSafeModeResponse* response,
@@ -321,8 +525,9 @@ void ResManImpl::QueryAgent(const std::string& agent_endpoint, bool is_first_que
                            agent_endpoint, is_first_query,
                            _1, _2, _3, _4);
     proto::QueryRequest* request = new proto::QueryRequest();
-    request->set_full_report(is_first_query);
-    proto::QueryResponse* response = new proto::QueryResponse();
+    // a standby rebuilds the agent from every report, so it always asks for all
+    request->set_full_report(is_first_query || standby_);
+    proto::QueryResponse* response = NewQueryResponse();
     rpc_client_.AsyncRequest(stub, &proto::Agent_Stub::Query,
                              request, response, callback, 5, 1);
     VLOG(10) << "send query command to:" << agent_endpoint;
@@ -334,7 +539,8 @@ void ResManImpl::QueryAgentCallback(std::string agent_endpoint,
                                     proto::QueryResponse* response,
                                     bool rpc_fail, int err) {
     boost::scoped_ptr<const proto::QueryRequest> request_guard(request);
-    boost::scoped_ptr<proto::QueryResponse> response_guard(response);
+    boost::shared_ptr<proto::QueryResponse> response_guard(response,
+        boost::bind(&ResManImpl::FreeQueryResponse, this, _1));
     if (response->code().status() != proto::kOk || rpc_fail) {
         LOG(WARNING) << "failed to query on: " << agent_endpoint
                      << " err: " << err << ", rpc_fail:" << rpc_fail;
@@ -343,7 +549,12 @@ void ResManImpl::QueryAgentCallback(std::string agent_endpoint,
         );
         return;
     }
-    if (is_first_query) {
+    bool standby = false;
+    {
+        MutexLock lock(&mu_);
+        standby = standby_;
+    }
+    if (is_first_query || standby) {
         MutexLock lock(&mu_);
         std::map<std::string, proto::AgentMeta>::iterator agent_it 
             = agents_.find(agent_endpoint);
@@ -353,6 +564,7 @@ void ResManImpl::QueryAgentCallback(std::string agent_endpoint,
         }
         proto::AgentMeta& agent_meta = agent_it->second;
         const proto::AgentInfo& agent_info = response->agent_info();
+        // the shared cores only, dedicated cores are counted per numa node
         int64_t cpu = agent_info.cpu_resource().total();
         int64_t memory = agent_info.memory_resource().total();
         std::map<sched::DevicePath, sched::VolumInfo> volums;
@@ -370,11 +582,21 @@ void ResManImpl::QueryAgentCallback(std::string agent_endpoint,
                                                  volums,
                                                  tags,
                                                  pool_name));
+        std::map<int32_t, int32_t> numa_cores;
+        for (int i = 0; i < agent_info.numa_nodes_size(); i++) {
+            const proto::NumaNodeResource& numa = agent_info.numa_nodes(i);
+            numa_cores[numa.node()] = numa.total_cores();
+        }
+        agent->SetNumaCores(numa_cores);
         scheduler_->RemoveAgent(agent_endpoint);
         scheduler_->AddAgent(agent, agent_info);
-        LOG(INFO) << "TRACE BEGIN, first query result from:" << agent_endpoint
-                  << "\n" << agent_info.DebugString()
-                  << "\nTRACE END";
+        if (is_first_query) {
+            LOG(INFO) << "first query result from:" << agent_endpoint
+                      << ", containers: " << agent_info.container_info_size();
+            VLOG(10) << "TRACE BEGIN, first query result from:" << agent_endpoint
+                     << "\n" << agent_info.DebugString()
+                     << "\nTRACE END";
+        }
         is_first_query = false;
     } else {
         VLOG(10) << "TRACE BEGIN, query result from: " << agent_endpoint
@@ -392,8 +614,14 @@ void ResManImpl::QueryAgentCallback(std::string agent_endpoint,
             LOG(INFO) << "this agent may be removed, no need to query again";
             return;
         }
-        agent_stats_[agent_endpoint].info = response->agent_info();
-        if (!force_safe_mode_ &&
+        AgentStat& agent_stat = agent_stats_[agent_endpoint];
+        // the old info goes back to the pool with the response
+        agent_stat.info.Swap(response->mutable_agent_info());
+        if (standby) {
+            // no heartbeat reaches a standby, a successful query stands for it
+            agent_stat.status = proto::kAgentAlive;
+            agent_stat.last_heartbeat_time = common::timer::now_time();
+        } else if (!force_safe_mode_ &&
             safe_mode_ &&
             agent_stats_.size() > (double)agents_.size() * FLAGS_safe_mode_percent) {
             int64_t running_time = (common::timer::get_micros() - start_time_) / 1000000;
@@ -414,6 +642,23 @@ void ResManImpl::QueryAgentCallback(std::string agent_endpoint,
     );
 }
 
+proto::QueryResponse* ResManImpl::NewQueryResponse() {
+    MutexLock lock(&response_pool_mu_);
+    if (response_pool_.empty()) {
+        return new proto::QueryResponse();
+    }
+    proto::QueryResponse* response = response_pool_.back();
+    response_pool_.pop_back();
+    return response;
+}
+
+void ResManImpl::FreeQueryResponse(proto::QueryResponse* response) {
+    // Clear keeps the allocated sub messages for the next parse
+    response->Clear();
+    MutexLock lock(&response_pool_mu_);
+    response_pool_.push_back(response);
+}
+
 void ResManImpl::SendCommandsToAgent(const std::string& agent_endpoint,
                                      const std::vector<sched::AgentCommand>& commands) {
     std::vector<sched::AgentCommand>::const_iterator it;
@@ -659,6 +904,8 @@ void ResManImpl::UpdateContainerGroup(::google::protobuf::RpcController* control
     std::string old_version = old_meta.desc().version();
     new_meta = old_meta; //copy
     new_meta.set_update_interval(request->interval());
+    new_meta.set_max_surge(request->max_surge());
+    new_meta.set_max_unavailable(request->max_unavailable());
     new_meta.mutable_desc()->CopyFrom(request->desc());
     new_meta.set_update_time(common::timer::get_micros());
     if (new_meta.replica() != request->replica()) {
@@ -682,6 +929,8 @@ void ResManImpl::UpdateContainerGroup(::google::protobuf::RpcController* control
     bool version_changed = scheduler_->Update(new_meta.id(),
                                               new_meta.desc(),
                                               new_meta.update_interval(),
+                                              new_meta.max_surge(),
+                                              new_meta.max_unavailable(),
                                               new_version);
     if (version_changed) {
         LOG(INFO) << "container version changed: " << new_version;
@@ -759,11 +1008,75 @@ void ResManImpl::ShowContainerGroup(::google::protobuf::RpcController* controlle
     for (size_t i = 0; i < containers.size(); i++) {
         response->add_containers()->CopyFrom(containers[i]);
     }
+    scheduler_->ShowUpdateProgress(request->id(), *response->mutable_update_progress());
     response->mutable_error_code()->set_status(proto::kOk);
     VLOG(16) << "show containers:" << response->DebugString();
     done->Run();   
 }
 
+void ResManImpl::PauseUpdate(::google::protobuf::RpcController* controller,
+                             const ::baidu::galaxy::proto::PauseUpdateRequest* request,
+                             ::baidu::galaxy::proto::PauseUpdateResponse* response,
+                             ::google::protobuf::Closure* done) {
+    CHECK_USER()
+    SetUpdatePaused(request->user().user(), request->id(), true,
+                    response->mutable_error_code());
+    done->Run();
+}
+
+void ResManImpl::ResumeUpdate(::google::protobuf::RpcController* controller,
+                              const ::baidu::galaxy::proto::ResumeUpdateRequest* request,
+                              ::baidu::galaxy::proto::ResumeUpdateResponse* response,
+                              ::google::protobuf::Closure* done) {
+    CHECK_USER()
+    SetUpdatePaused(request->user().user(), request->id(), false,
+                    response->mutable_error_code());
+    done->Run();
+}
+
+void ResManImpl::SetUpdatePaused(const std::string& user,
+                                 const std::string& container_group_id,
+                                 bool paused,
+                                 proto::ErrorCode* err) {
+    LOG(INFO) << "user:" << user << (paused ? " pause" : " resume")
+              << " update of container group: " << container_group_id;
+    proto::ContainerGroupMeta meta;
+    {
+        MutexLock lock(&mu_);
+        std::map<std::string, proto::ContainerGroupMeta>::iterator it;
+        it = container_groups_.find(container_group_id);
+        if (it == container_groups_.end()) {
+            err->set_status(proto::kJobNotFound);
+            err->set_reason("no such group");
+            return;
+        }
+        meta = it->second;
+    }
+    std::string invalid_pool;
+    if (!CheckUserAuth(meta.desc(), user, users_can_update_, invalid_pool)) {
+        err->set_status(proto::kUpdateContainerGroupFail);
+        err->set_reason("no update permission on pool: " + invalid_pool);
+        return;
+    }
+    if (meta.user_name() != user) {
+        err->set_status(proto::kUpdateContainerGroupFail);
+        err->set_reason("user mismatch:" + meta.user_name() + " , " + user);
+        return;
+    }
+    meta.set_update_paused(paused);
+    if (!SaveObject(sContainerGroupPrefix + "/" + meta.id(), meta)) {
+        err->set_status(proto::kUpdateContainerGroupFail);
+        err->set_reason("fail to save container group meta in nexus");
+        return;
+    }
+    {
+        MutexLock lock(&mu_);
+        container_groups_[meta.id()] = meta;
+    }
+    scheduler_->PauseUpdate(meta.id(), paused);
+    err->set_status(proto::kOk);
+}
+
 void ResManImpl::AddAgent(::google::protobuf::RpcController* controller,
                           const ::baidu::galaxy::proto::AddAgentRequest* request,
                           ::baidu::galaxy::proto::AddAgentResponse* response,
@@ -937,37 +1250,43 @@ void ResManImpl::CreateTag(::google::protobuf::RpcController* controller,
         err->set_reason("fail to save tag to nexus");
     } else {
         MutexLock lock(&mu_);
-        std::set<std::string>& tag_old = tags_[tag];
-        std::set<std::string>::iterator it_old = tag_old.begin();
-        std::set<std::string>::iterator it_new = tag_new.begin();
-        while (it_old != tag_old.end() && it_new != tag_new.end()) {
-            if (*it_old < *it_new) {
-                agent_tags_[*it_old].erase(tag);
-                scheduler_->RemoveTag(*it_old, tag);
-                it_old++;
-            } else if (*it_old == *it_new) {
-                it_old++;
-                it_new++;
-            } else {
-                agent_tags_[*it_new].insert(tag);
-                scheduler_->AddTag(*it_new, tag);
-                it_new++;
-            }
-        }
-        while (it_old != tag_old.end()) {
+        SetTagMembers(tag, tag_new);
+    }
+    response->mutable_error_code()->set_status(proto::kOk);
+    done->Run();
+}
+
+void ResManImpl::SetTagMembers(const std::string& tag,
+                               const std::set<std::string>& tag_new) {
+    mu_.AssertHeld();
+    std::set<std::string>& tag_old = tags_[tag];
+    std::set<std::string>::iterator it_old = tag_old.begin();
+    std::set<std::string>::const_iterator it_new = tag_new.begin();
+    while (it_old != tag_old.end() && it_new != tag_new.end()) {
+        if (*it_old < *it_new) {
             agent_tags_[*it_old].erase(tag);
             scheduler_->RemoveTag(*it_old, tag);
             it_old++;
-        }
-        while (it_new != tag_new.end()) {
+        } else if (*it_old == *it_new) {
+            it_old++;
+            it_new++;
+        } else {
             agent_tags_[*it_new].insert(tag);
             scheduler_->AddTag(*it_new, tag);
             it_new++;
         }
-        tag_old = tag_new;
     }
-    response->mutable_error_code()->set_status(proto::kOk);
-    done->Run();
+    while (it_old != tag_old.end()) {
+        agent_tags_[*it_old].erase(tag);
+        scheduler_->RemoveTag(*it_old, tag);
+        it_old++;
+    }
+    while (it_new != tag_new.end()) {
+        agent_tags_[*it_new].insert(tag);
+        scheduler_->AddTag(*it_new, tag);
+        it_new++;
+    }
+    tag_old = tag_new;
 }
 
 void ResManImpl::ListTags(::google::protobuf::RpcController* controller,
@@ -1420,11 +1739,60 @@ bool ResManImpl::LoadObjects(const std::string& prefix,
             LOG(WARNING) << "parse protobuf object fail ";
             return false;
         }
+        if (FLAGS_hot_standby) {
+            nexus_snapshot_[prefix][key] = raw_obj_buf;
+        }
         result->Next();
     }
     return result->Error() == ::galaxy::ins::sdk::kOK;
 }
 
+template <class ProtoClass>
+bool ResManImpl::DiffObjects(const std::string& prefix,
+                             std::map<std::string, ProtoClass>& changed,
+                             std::set<std::string>& removed) {
+    std::string full_prefix = FLAGS_nexus_root + prefix;
+    ::galaxy::ins::sdk::ScanResult* result
+        = nexus_->Scan(full_prefix + "/", full_prefix + "/\xff");
+    boost::scoped_ptr< ::galaxy::ins::sdk::ScanResult > result_guard(result);
+    size_t prefix_len = full_prefix.size() + 1;
+    std::map<std::string, std::string>& snapshot = nexus_snapshot_[prefix];
+    std::map<std::string, std::string> changed_raw;
+    std::set<std::string> seen;
+    while (!result->Done()) {
+        const std::string& full_key = result->Key();
+        const std::string& raw_obj_buf = result->Value();
+        std::string key = full_key.substr(prefix_len);
+        seen.insert(key);
+        std::map<std::string, std::string>::const_iterator it = snapshot.find(key);
+        if (it == snapshot.end() || it->second != raw_obj_buf) {
+            if (!changed[key].ParseFromString(raw_obj_buf)) {
+                LOG(WARNING) << "parse protobuf object fail ";
+                return false;
+            }
+            changed_raw[key] = raw_obj_buf;
+        }
+        result->Next();
+    }
+    if (result->Error() != ::galaxy::ins::sdk::kOK) {
+        return false;
+    }
+    // only remember what the caller is going to apply
+    std::map<std::string, std::string>::iterator it = snapshot.begin();
+    while (it != snapshot.end()) {
+        if (seen.find(it->first) == seen.end()) {
+            removed.insert(it->first);
+            snapshot.erase(it++);
+        } else {
+            it++;
+        }
+    }
+    for (it = changed_raw.begin(); it != changed_raw.end(); it++) {
+        snapshot[it->first].swap(it->second);
+    }
+    return true;
+}
+
 void ResManImpl::CreateContainerCallback(std::string agent_endpoint,
                                          const proto::CreateContainerRequest* request,
                                          proto::CreateContainerResponse* response,
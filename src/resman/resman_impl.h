@@ -25,6 +25,7 @@ struct AgentStat {
     proto::AgentStatus status;
     proto::AgentInfo info;
     int32_t last_heartbeat_time; //timestamp in seconds
+    AgentStat() : status(proto::kAgentUnknown), last_heartbeat_time(0) {}
 };
 
 class ResManImpl : public baidu::galaxy::proto::ResMan {
@@ -33,6 +34,10 @@ public:
     ~ResManImpl();
     bool Init();
     bool RegisterOnNexus(const std::string& endpoint);
+    // hot standby: follow meta changes on nexus and query agents
+    // while waiting for the lock, so that taking over needs no cold start
+    void StartStandby();
+    void TakeOver();
     void EnterSafeMode(::google::protobuf::RpcController* controller,
                        const ::baidu::galaxy::proto::EnterSafeModeRequest* request,
                        ::baidu::galaxy::proto::EnterSafeModeResponse* response,
@@ -69,6 +74,14 @@ public:
                          const ::baidu::galaxy::proto::ShowContainerGroupRequest* request,
                          ::baidu::galaxy::proto::ShowContainerGroupResponse* response,
                          ::google::protobuf::Closure* done);
+    void PauseUpdate(::google::protobuf::RpcController* controller,
+                         const ::baidu::galaxy::proto::PauseUpdateRequest* request,
+                         ::baidu::galaxy::proto::PauseUpdateResponse* response,
+                         ::google::protobuf::Closure* done);
+    void ResumeUpdate(::google::protobuf::RpcController* controller,
+                         const ::baidu::galaxy::proto::ResumeUpdateRequest* request,
+                         ::baidu::galaxy::proto::ResumeUpdateResponse* response,
+                         ::google::protobuf::Closure* done);
     void AddAgent(::google::protobuf::RpcController* controller,
                          const ::baidu::galaxy::proto::AddAgentRequest* request,
                          ::baidu::galaxy::proto::AddAgentResponse* response,
@@ -171,6 +184,10 @@ private:
                                  bool fail, int err);
     void SendCommandsToAgent(const std::string& agent_endpoint,
                              const std::vector<sched::AgentCommand>& commands);
+    // query responses are recycled, so that parsing a report reuses the
+    // messages of an earlier one instead of allocating them again
+    proto::QueryResponse* NewQueryResponse();
+    void FreeQueryResponse(proto::QueryResponse* response);
     template <class ProtoClass> 
     bool SaveObject(const std::string& key,
                     const ProtoClass& obj);
@@ -179,7 +196,17 @@ private:
     bool LoadObjects(const std::string& prefix,
                      std::map<std::string, ProtoClass>& objs);
 
+    // scan prefix and report objects changed or removed since last load
+    template <class ProtoClass>
+    bool DiffObjects(const std::string& prefix,
+                     std::map<std::string, ProtoClass>& changed,
+                     std::set<std::string>& removed);
+
     bool RemoveObject(const std::string& key);
+    void SyncStandby();
+    bool SyncFromNexus();
+    void TrackAgent(const std::string& endpoint);
+    void SetTagMembers(const std::string& tag, const std::set<std::string>& endpoints);
     static void OnRMLockChange(const ::galaxy::ins::sdk::WatchParam& param,
                                ::galaxy::ins::sdk::SDKError err);
     void OnLockChange(std::string lock_session_id);
@@ -200,6 +227,10 @@ private:
                           const proto::ContainerGroupMeta& old_meta,
                           const proto::ContainerGroupMeta& new_meta,
                           std::string& fail_reason);
+    void SetUpdatePaused(const std::string& user,
+                         const std::string& container_group_id,
+                         bool paused,
+                         proto::ErrorCode* err);
 
     sched::Scheduler* scheduler_;
     InsSDK* nexus_;
@@ -217,7 +248,13 @@ private:
     Mutex mu_;
     bool safe_mode_;
     bool force_safe_mode_;
+    bool standby_;
+    Mutex sync_mu_;
+    // prefix -> key -> raw value last applied, kept in hot standby only
+    std::map<std::string, std::map<std::string, std::string> > nexus_snapshot_;
     ThreadPool query_pool_;
+    Mutex response_pool_mu_;
+    std::vector<proto::QueryResponse*> response_pool_;
     RpcClient rpc_client_;
     int64_t start_time_;
 };
@@ -16,6 +16,7 @@
 #include "util.h"
 
 DECLARE_string(resman_port);
+DECLARE_bool(hot_standby);
 
 static volatile bool s_quit = false;
 static void SignalIntHandler(int /*sig*/){
@@ -33,11 +34,15 @@ int main(int argc, char* argv[]) {
         exit(-1);
     }
     std::string rm_endpoint = ::baidu::common::util::GetLocalHostName() + ":" +FLAGS_resman_port;
+    if (FLAGS_hot_standby) {
+        resman->StartStandby();
+    }
     bool nexus_ok = resman->RegisterOnNexus(rm_endpoint);
     if (!nexus_ok) {
         LOG(WARNING) << "fail to register RM on nexus";
         exit(-1);
     }
+    resman->TakeOver();
     sofa::pbrpc::RpcServerOptions options;
     sofa::pbrpc::RpcServer rpc_server(options);
     if (!rpc_server.RegisterService(static_cast<baidu::galaxy::proto::ResMan*>(resman))) {
@@ -15,12 +15,18 @@
 #include <glog/logging.h>
 #include <gflags/gflags.h>
 #include "timer.h"
+#include "log_utils.h"
 
 DECLARE_int64(sched_interval);
 DECLARE_int64(container_group_gc_check_interval);
+DECLARE_int64(rolling_update_check_interval);
+DECLARE_int64(gang_sched_interval);
+DECLARE_bool(sched_on_events);
 DECLARE_bool(check_container_version);
 DECLARE_int32(max_batch_pods);
 DECLARE_double(reserved_percent);
+DECLARE_double(reserved_cpu_pressure);
+DECLARE_double(reserved_memory_pressure);
 
 namespace baidu {
 namespace galaxy {
@@ -29,6 +35,49 @@ namespace sched {
 const int sMaxPort = 9999;
 const int sMinPort = 1026;
 const std::string kDynamicPort = "dynamic";
+static const int64_t kLatencyReportInterval = 60000000L;
+// a gang missing its quorum waits up to 2^5 - 1 passes before it tries again
+static const int kMaxGangBackoffShift = 5;
+
+static bool ContainerIdLess(const proto::ContainerStatistics& a,
+                            const proto::ContainerStatistics& b) {
+    return a.id() < b.id();
+}
+
+// a calm container reserves its predicted usage scaled by reserved_percent,
+// a stalled one, or any one on a stalled host, keeps all it required so that
+// no more best effort work is put there
+static int64_t ReservedOf(const UsageModel& usage, int64_t need,
+                          double pressure, double host_pressure,
+                          double threshold) {
+    if (threshold > 0.0 && std::max(pressure, host_pressure) > threshold) {
+        return need;
+    }
+    return usage.Reserve(need);
+}
+
+// both take the usage of the report into the model of the container first
+static int64_t CpuReserved(Container* container,
+                           const proto::ContainerInfo& container_info,
+                           const proto::AgentInfo& agent_info,
+                           int64_t need) {
+    container->cpu_usage.Add(container_info.cpu_used());
+    return ReservedOf(container->cpu_usage, need,
+                      container_info.pressure().cpu_some().avg10(),
+                      agent_info.pressure().cpu_some().avg10(),
+                      FLAGS_reserved_cpu_pressure);
+}
+
+static int64_t MemoryReserved(Container* container,
+                              const proto::ContainerInfo& container_info,
+                              const proto::AgentInfo& agent_info,
+                              int64_t need) {
+    container->memory_usage.Add(container_info.memory_used());
+    return ReservedOf(container->memory_usage, need,
+                      container_info.pressure().memory_some().avg10(),
+                      agent_info.pressure().memory_some().avg10(),
+                      FLAGS_reserved_memory_pressure);
+}
 
 Agent::Agent(const AgentEndpoint& endpoint,
             int64_t cpu,
@@ -49,15 +98,73 @@ Agent::Agent(const AgentEndpoint& endpoint,
     memory_deep_reserved_ = 0;
     volum_total_ = volums;
     port_total_ = sMaxPort - sMinPort + 1;
-    tags_ = tags;
     pool_name_ = pool_name;
     batch_container_count_ = 0;
+    ledger_version_ = 0;
+    domain_counts_ = NULL;
+    group_handles_ = NULL;
+    SetTags(tags);
+}
+
+void Agent::SetTags(const std::set<std::string>& tags) {
+    //move the containers to the new labels
+    BOOST_FOREACH(const ContainerMap::value_type& pair, containers_) {
+        CountDomains(pair.second->group_handle, -1);
+    }
+    tags_ = tags;
+    topology_.clear();
+    BOOST_FOREACH(const std::string& tag, tags_) {
+        size_t idx = tag.find(":");
+        if (idx != std::string::npos && idx > 0 && idx + 1 < tag.size()) {
+            topology_[tag.substr(0, idx)] = tag;
+        }
+    }
+    BOOST_FOREACH(const ContainerMap::value_type& pair, containers_) {
+        CountDomains(pair.second->group_handle, 1);
+    }
+}
+
+void Agent::CountDomains(GroupHandle group_handle, int delta) {
+    if (domain_counts_ == NULL) {
+        return;
+    }
+    std::map<std::string, std::string>::const_iterator it;
+    for (it = topology_.begin(); it != topology_.end(); it++) {
+        GroupCounts& counts = (*domain_counts_)[it->second];
+        int& count = counts[group_handle];
+        count += delta;
+        if (count <= 0) {
+            counts.erase(group_handle);
+            if (counts.empty()) {
+                domain_counts_->erase(it->second);
+            }
+        }
+    }
+}
+
+int Agent::DomainCount(const std::string& label, GroupHandle group_handle) {
+    if (domain_counts_ == NULL || group_handle == 0) {
+        return 0;
+    }
+    DomainCounts::const_iterator it = domain_counts_->find(label);
+    if (it == domain_counts_->end()) {
+        return 0;
+    }
+    GroupCounts::const_iterator jt = it->second.find(group_handle);
+    return jt == it->second.end() ? 0 : jt->second;
 }
 
-ContainerGroupId Agent::ExtractGroupId(const ContainerId& container_id) {
-    size_t idx = container_id.rfind(".");
-    assert(idx != std::string::npos);
-    return container_id.substr(0, idx);
+GroupHandle Agent::FindGroupHandle(const ContainerGroupId& container_group_id) {
+    if (group_handles_ == NULL) {
+        return 0;
+    }
+    GroupHandles::const_iterator it = group_handles_->find(container_group_id);
+    return it == group_handles_->end() ? 0 : it->second;
+}
+
+GroupHandle Agent::GroupOf(const ContainerId& container_id) {
+    ContainerMap::const_iterator it = containers_.find(container_id);
+    return it == containers_.end() ? 0 : it->second->group_handle;
 }
 
 void Agent::SetAssignment(int64_t cpu_assigned,
@@ -66,7 +173,12 @@ void Agent::SetAssignment(int64_t cpu_assigned,
                           int64_t memory_deep_assigned,
                           const std::map<DevicePath, VolumInfo>& volum_assigned,
                           const std::set<std::string> port_assigned,
-                          const std::map<ContainerId, Container::Ptr>& containers) {
+                          const ContainerMap& containers) {
+    MutexLock lock(&mu_);
+    ledger_version_++;
+    BOOST_FOREACH(const ContainerMap::value_type& pair, containers_) {
+        CountDomains(pair.second->group_handle, -1);
+    }
     cpu_assigned_ = cpu_assigned;
     cpu_deep_assigned_ = cpu_deep_assigned;
     memory_assigned_ = memory_assigned;
@@ -79,12 +191,13 @@ void Agent::SetAssignment(int64_t cpu_assigned,
 
     BOOST_FOREACH(const ContainerMap::value_type& pair, containers) {
         const Container::Ptr& container = pair.second;
-        container_counts_[container->container_group_id] += 1;
+        container_counts_[container->group_handle] += 1;
+        CountDomains(container->group_handle, 1);
         container->allocated_agent = endpoint_;
         VLOG(10) << "agent: " << endpoint_ << " has container: " << container->id
                  << " with type: " << proto::ContainerType_Name(container->require->container_type);
         if (container->require->container_type == proto::kVolumContainer) {
-            volum_jobs_free_[container->container_group_id].insert(container->id);
+            volum_jobs_free_[container->group_handle].insert(container->id);
             VLOG(10) << "free volum container: " << container->id << " of: "
                      << container->container_group_id << " on agent:"
                      << endpoint_;
@@ -94,12 +207,23 @@ void Agent::SetAssignment(int64_t cpu_assigned,
         }
     }
 
+    numa_cores_assigned_.clear();
+    BOOST_FOREACH(const ContainerMap::value_type& pair, containers) {
+        const Container::Ptr& container = pair.second;
+        if (container->allocated_numa_node >= 0) {
+            numa_cores_assigned_[container->allocated_numa_node]
+                += container->require->ExclusiveCoresNeed();
+        }
+    }
+
     BOOST_FOREACH(const ContainerMap::value_type& pair, containers) {
         const Container::Ptr& container = pair.second;
         for (size_t i = 0; i < container->allocated_volum_containers.size(); i++) {
             const ContainerId& volum_container_id = container->allocated_volum_containers[i];
-            const ContainerGroupId& volum_job_id = ExtractGroupId(volum_container_id);
-            volum_jobs_free_[volum_job_id].erase(volum_container_id);
+            GroupHandle volum_job = GroupOf(volum_container_id);
+            if (volum_job != 0) {
+                volum_jobs_free_[volum_job].erase(volum_container_id);
+            }
         }
     }
 }
@@ -108,19 +232,48 @@ void Agent::SetReserved(int64_t cpu_reserved,
                         int64_t cpu_deep_reserved,
                         int64_t memory_reserved,
                         int64_t memory_deep_reserved) {
-    LOG(INFO)
+    LOG_EVERY_MS(INFO, 1000)
         << "# cpu_reserved: " << cpu_reserved
         << ", cpu_deep_reserved: " << cpu_deep_reserved
         << ", memory_reserved: " << memory_reserved
         << ", memory_deep_reserved: " << memory_deep_reserved;
+    MutexLock lock(&mu_);
+    ledger_version_++;
     cpu_reserved_ = cpu_reserved;
     cpu_deep_reserved_ = cpu_deep_reserved;
     memory_reserved_ = memory_reserved;
     memory_deep_reserved_ = memory_deep_reserved;
 }
 
+void Agent::SetNumaCores(const std::map<int32_t, int32_t>& numa_cores) {
+    MutexLock lock(&mu_);
+    ledger_version_++;
+    numa_cores_total_ = numa_cores;
+}
+
+bool Agent::SelectNumaNode(int32_t cores, int32_t& node) {
+    // best fit, keeps larger free sets for bigger requests
+    int32_t best_free = 0;
+    node = -1;
+    std::map<int32_t, int32_t>::const_iterator it;
+    for (it = numa_cores_total_.begin(); it != numa_cores_total_.end(); it++) {
+        std::map<int32_t, int32_t>::const_iterator jt = numa_cores_assigned_.find(it->first);
+        int32_t free_cores = it->second - (jt == numa_cores_assigned_.end() ? 0 : jt->second);
+        if (free_cores >= cores && (node < 0 || free_cores < best_free)) {
+            node = it->first;
+            best_free = free_cores;
+        }
+    }
+    return node >= 0;
+}
+
 bool Agent::TryPut(const Container* container, ResourceError& err) {
-    LOG(INFO)
+    return CheckPlacement(container, err)
+           && FitResources(container->require.get(), container->priority, err);
+}
+
+bool Agent::CheckPlacement(const Container* container, ResourceError& err) {
+    LOG_EVERY_MS(INFO, 1000)
         << "### TryPut, agent: " << endpoint_
         << ", container: " << container->id
         << ", cpu[a/r/da/dr]: "
@@ -139,8 +292,8 @@ bool Agent::TryPut(const Container* container, ResourceError& err) {
     }
 
     if (container->require->max_per_host > 0) {
-        ContainerGroupId container_group_id = container->container_group_id;
-        std::map<ContainerGroupId, int>::iterator it = container_counts_.find(container_group_id);
+        boost::unordered_map<GroupHandle, int>::iterator it =
+            container_counts_.find(container->group_handle);
         if (it != container_counts_.end()) {
             int cur_counts = it->second;
             if (cur_counts >= container->require->max_per_host) {
@@ -150,28 +303,78 @@ bool Agent::TryPut(const Container* container, ResourceError& err) {
         }
     }
 
-    if (container->priority != proto::kJobBestEffort) {
-        if (container->require->CpuNeed() + cpu_assigned_ > cpu_total_) {
+    for (size_t i = 0; i < container->require->spreads.size(); i++) {
+        const proto::TopologySpread& spread = container->require->spreads[i];
+        std::map<std::string, std::string>::const_iterator it = topology_.find(spread.domain());
+        if (it == topology_.end()) {
+            err = proto::kTagMismatch;
+            return false;
+        }
+        if (spread.max_per_domain() > 0
+            && DomainCount(it->second, container->group_handle) >= spread.max_per_domain()) {
+            err = proto::kTooManyPodsInDomain;
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < container->require->anti_affinities.size(); i++) {
+        const proto::AntiAffinity& anti = container->require->anti_affinities[i];
+        std::map<std::string, std::string>::const_iterator it = topology_.find(anti.domain());
+        GroupHandle anti_handle = FindGroupHandle(anti.container_group_id());
+        bool conflict = false;
+        if (anti_handle == 0) {
+            //no such group, nothing to keep away from
+        } else if (it != topology_.end()) {
+            conflict = DomainCount(it->second, anti_handle) > 0;
+        } else { //on the host only
+            conflict = container_counts_.find(anti_handle) != container_counts_.end();
+        }
+        if (conflict) {
+            err = proto::kAntiAffinityConflict;
+            return false;
+        }
+    }
+
+    std::vector<ContainerId> volum_containers;
+    if (!container->require->volum_jobs.empty()
+        && !SelectFreeVolumContainers(container->require->volum_jobs, volum_containers)) {
+        err = proto::kNoVolumContainer;
+        return false;
+    }
+
+    return true;
+}
+
+bool Agent::TryFit(const Requirement* require, int priority,
+                   ResourceError& err, int64_t& ledger_version) {
+    MutexLock lock(&mu_);
+    ledger_version = ledger_version_;
+    return FitResources(require, priority, err);
+}
+
+bool Agent::FitResources(const Requirement* require, int priority, ResourceError& err) {
+    if (priority != proto::kJobBestEffort) {
+        if (require->SharedCpuNeed() + cpu_assigned_ > cpu_total_) {
             err = proto::kNoCpu;
             return false;
         }
-        if (container->require->MemoryNeed() + memory_assigned_ > memory_total_) {
+        if (require->MemoryNeed() + memory_assigned_ > memory_total_) {
             err = proto::kNoMemory;
             return false;
         }
     } else {
-        if (cpu_reserved_ + cpu_deep_assigned_ + container->require->CpuNeed() > cpu_total_) {
+        if (cpu_reserved_ + cpu_deep_assigned_ + require->SharedCpuNeed() > cpu_total_) {
             err = proto::kNoCpu;
             return false;
         }
-        if (memory_reserved_ + memory_deep_assigned_ + container->require->MemoryNeed() > memory_total_) {
+        if (memory_reserved_ + memory_deep_assigned_ + require->MemoryNeed() > memory_total_) {
             err = proto::kNoMemory;
             return false;
         }
     }
 
     int64_t size_ramdisk = 0;
-    const std::vector<proto::VolumRequired>& volums = container->require->volums;
+    const std::vector<proto::VolumRequired>& volums = require->volums;
     std::vector<proto::VolumRequired> volums_no_ramdisk;
 
     BOOST_FOREACH(const proto::VolumRequired& v, volums) {
@@ -182,8 +385,8 @@ bool Agent::TryPut(const Container* container, ResourceError& err) {
         }
     }
 
-    if (container->priority != proto::kJobBestEffort) {
-        if (size_ramdisk + memory_assigned_ + container->require->MemoryNeed()> memory_total_) {
+    if (priority != proto::kJobBestEffort) {
+        if (size_ramdisk + memory_assigned_ + require->MemoryNeed()> memory_total_) {
             err = proto::kNoMemoryForTmpfs;
             return false;
         }
@@ -200,29 +403,29 @@ bool Agent::TryPut(const Container* container, ResourceError& err) {
         return false;
     }
 
-    if (container->require->ports.size() + port_assigned_.size()
+    if (require->ports.size() + port_assigned_.size()
         > port_total_) {
         err = proto::kNoPort;
         return false;
     }
 
-    const std::vector<proto::PortRequired> ports = container->require->ports;
+    const std::vector<proto::PortRequired> ports = require->ports;
     std::vector<std::string> ports_free;
     if (!SelectFreePorts(ports, ports_free)) {
         err = proto::kPortConflict;
         return false;
     }
 
-    std::vector<ContainerId> volum_containers;
-    if (!container->require->volum_jobs.empty()
-        && !SelectFreeVolumContainers(container->require->volum_jobs, volum_containers)) {
-        err = proto::kNoVolumContainer;
+    if (priority == proto::kJobBatch &&
+        batch_container_count_ > FLAGS_max_batch_pods) {
+        err = proto::kTooManyBatchPods;
         return false;
     }
 
-    if (container->priority == proto::kJobBatch &&
-        batch_container_count_ > FLAGS_max_batch_pods) {
-        err = proto::kTooManyBatchPods;
+    int32_t numa_node = -1;
+    int32_t exclusive_cores = require->ExclusiveCoresNeed();
+    if (exclusive_cores > 0 && !SelectNumaNode(exclusive_cores, numa_node)) {
+        err = proto::kNoNumaCores;
         return false;
     }
 
@@ -232,14 +435,16 @@ bool Agent::TryPut(const Container* container, ResourceError& err) {
 void Agent::Put(Container::Ptr container) {
     assert(container->status == kContainerPending);
     assert(container->allocated_agent.empty());
+    MutexLock lock(&mu_);
+    ledger_version_++;
     if (container->priority != proto::kJobBestEffort) {
         //cpu
-        cpu_assigned_ += container->require->CpuNeed();
+        cpu_assigned_ += container->require->SharedCpuNeed();
         assert(cpu_assigned_ <= cpu_total_);
         //memory
         memory_assigned_ += container->require->MemoryNeed();
     } else {
-        cpu_deep_assigned_ += container->require->CpuNeed();
+        cpu_deep_assigned_ += container->require->SharedCpuNeed();
         memory_deep_assigned_ += container->require->MemoryNeed();
     }
     int64_t size_ramdisk = 0;
@@ -284,10 +489,11 @@ void Agent::Put(Container::Ptr container) {
     container->allocated_agent = endpoint_;
     container->last_res_err = proto::kResOk;
     containers_[container->id] = container;
-    container_counts_[container->container_group_id] += 1;
+    container_counts_[container->group_handle] += 1;
+    CountDomains(container->group_handle, 1);
 
     if (container->require->container_type == proto::kVolumContainer) {
-        volum_jobs_free_[container->container_group_id].insert(container->id);
+        volum_jobs_free_[container->group_handle].insert(container->id);
     }
 
     std::vector<ContainerId> volum_containers;
@@ -295,17 +501,20 @@ void Agent::Put(Container::Ptr container) {
         && SelectFreeVolumContainers(container->require->volum_jobs, volum_containers)) {
         for (size_t i = 0; i < volum_containers.size(); i++) {
             const ContainerId& volum_container_id = volum_containers[i];
-            const ContainerGroupId& volum_job_id = ExtractGroupId(volum_container_id);
-            volum_jobs_free_[volum_job_id].erase(volum_container_id);
+            volum_jobs_free_[GroupOf(volum_container_id)].erase(volum_container_id);
             container->allocated_volum_containers.push_back(volum_container_id);
-            VLOG(10) << container->id << " use volum container: " << volum_container_id
-                     << " of job: " << volum_job_id;
+            VLOG(10) << container->id << " use volum container: " << volum_container_id;
         }
     }
 
     if (container->priority == proto::kJobBatch) {
         batch_container_count_ ++;
     }
+
+    int32_t exclusive_cores = container->require->ExclusiveCoresNeed();
+    if (exclusive_cores > 0 && SelectNumaNode(exclusive_cores, container->allocated_numa_node)) {
+        numa_cores_assigned_[container->allocated_numa_node] += exclusive_cores;
+    }
 }
 
 bool Agent::SelectFreePorts(const std::vector<proto::PortRequired>& ports_need,
@@ -394,19 +603,24 @@ bool Agent::SelectFreePorts(const std::vector<proto::PortRequired>& ports_need,
 
 bool Agent::SelectFreeVolumContainers(const std::vector<ContainerGroupId>& volum_jobs,
                                       std::vector<ContainerId>& volum_containers) {
-    std::map<ContainerGroupId, std::set<ContainerId> > volum_jobs_free
-         = volum_jobs_free_; //copy
+    //next free container of each job, a job listed twice takes two of them
+    typedef std::set<ContainerId>::const_iterator FreeIterator;
+    std::map<GroupHandle, FreeIterator> next_free;
     for (size_t i = 0; i < volum_jobs.size(); i++) {
-        const ContainerGroupId& container_group_id = volum_jobs[i];
-        if (volum_jobs_free.find(container_group_id) != volum_jobs_free.end()) {
-            if (!volum_jobs_free[container_group_id].empty()) {
-                const ContainerId volum_container = *volum_jobs_free[container_group_id].begin();
-                volum_containers.push_back(volum_container);
-                volum_jobs_free[container_group_id].erase(volum_container);
-            }
+        GroupHandle volum_job = FindGroupHandle(volum_jobs[i]);
+        boost::unordered_map<GroupHandle, std::set<ContainerId> >::const_iterator it =
+            volum_jobs_free_.find(volum_job);
+        if (volum_job == 0 || it == volum_jobs_free_.end()) {
+            return false;
+        }
+        FreeIterator& jt = next_free.insert(std::make_pair(volum_job, it->second.begin())).first->second;
+        if (jt == it->second.end()) {
+            return false;
         }
+        volum_containers.push_back(*jt);
+        ++jt;
     }
-    return volum_jobs.size() == volum_containers.size();
+    return true;
 }
 
 void Agent::Evict(Container::Ptr container) {
@@ -414,15 +628,17 @@ void Agent::Evict(Container::Ptr container) {
         LOG(WARNING) << "invalid evict, no such container:" << container->id;
         return;
     }
+    MutexLock lock(&mu_);
+    ledger_version_++;
     if (container->priority != proto::kJobBestEffort) {
         //cpu
-        cpu_assigned_ -= container->require->CpuNeed();
+        cpu_assigned_ -= container->require->SharedCpuNeed();
         assert(cpu_assigned_ >= 0);
         //memory
         memory_assigned_ -= container->require->MemoryNeed();
         assert(memory_assigned_ >= 0);
     } else {
-        cpu_deep_assigned_ -= container->require->CpuNeed();
+        cpu_deep_assigned_ -= container->require->SharedCpuNeed();
         memory_deep_assigned_ -= container->require->MemoryNeed();
         if (container->require->TmpfsNeed()) {
             memory_assigned_ -= container->require->TmpfsNeed();
@@ -452,25 +668,31 @@ void Agent::Evict(Container::Ptr container) {
     BOOST_FOREACH(const std::string& port, container->allocated_ports) {
         port_assigned_.erase(port);
     }
+    if (container->allocated_numa_node >= 0) {
+        numa_cores_assigned_[container->allocated_numa_node]
+            -= container->require->ExclusiveCoresNeed();
+        container->allocated_numa_node = -1;
+    }
     containers_.erase(container->id);
-    container_counts_[container->container_group_id] -= 1;
-    if (container_counts_[container->container_group_id] <= 0) {
-        container_counts_.erase(container->container_group_id);
+    GroupHandle group_handle = container->group_handle;
+    container_counts_[group_handle] -= 1;
+    CountDomains(group_handle, -1);
+    if (container_counts_[group_handle] <= 0) {
+        container_counts_.erase(group_handle);
     }
     if (container->require->container_type == proto::kVolumContainer) {
-        volum_jobs_free_[container->container_group_id].erase(container->id);
-        if (volum_jobs_free_[container->container_group_id].empty()) {
-            volum_jobs_free_.erase(container->container_group_id);
+        volum_jobs_free_[group_handle].erase(container->id);
+        if (volum_jobs_free_[group_handle].empty()) {
+            volum_jobs_free_.erase(group_handle);
         }
     }
     if (!container->allocated_volum_containers.empty()) {
         for (size_t i = 0; i < container->allocated_volum_containers.size(); i++) {
             const ContainerId& volum_container_id = container->allocated_volum_containers[i];
-            const ContainerGroupId& volum_job_id = ExtractGroupId(volum_container_id);
-            if (containers_.find(volum_container_id) != containers_.end()) {
-                volum_jobs_free_[volum_job_id].insert(volum_container_id);
-                VLOG(10) << container->id << " free volum container: " << volum_container_id
-                         << " of job: " << volum_job_id;
+            GroupHandle volum_job = GroupOf(volum_container_id);
+            if (volum_job != 0) {
+                volum_jobs_free_[volum_job].insert(volum_container_id);
+                VLOG(10) << container->id << " free volum container: " << volum_container_id;
             }
         }
         container->allocated_volum_containers.clear();
@@ -544,8 +766,13 @@ bool Agent::RecurSelectDevices(size_t i, const std::vector<proto::VolumRequired>
 }
 
 
-Scheduler::Scheduler() : stop_(true) {
+Scheduler::Scheduler() : dirty_scheduled_(false), last_latency_report_(0), stop_(true) {
     srand(time(NULL));
+    group_slots_.push_back(ContainerGroup::Ptr()); //handle 0 is for none
+    update_pool_.DelayTask(FLAGS_rolling_update_check_interval,
+                           boost::bind(&Scheduler::CheckUpdateRoutine, this));
+    sched_pool_.DelayTask(FLAGS_gang_sched_interval,
+                          boost::bind(&Scheduler::GangScheduleRoutine, this));
 }
 
 void Scheduler::SetRequirement(Requirement::Ptr require,
@@ -555,6 +782,12 @@ void Scheduler::SetRequirement(Requirement::Ptr require,
         require->pool_names.insert(container_desc.pool_names(j));
     }
     require->max_per_host = container_desc.max_per_host();
+    for (int j = 0; j < container_desc.spreads_size(); j++) {
+        require->spreads.push_back(container_desc.spreads(j));
+    }
+    for (int j = 0; j < container_desc.anti_affinities_size(); j++) {
+        require->anti_affinities.push_back(container_desc.anti_affinities(j));
+    }
     for (int j = 0; j < container_desc.cgroups_size(); j++) {
         const proto::Cgroup& cgroup = container_desc.cgroups(j);
         require->cpu.push_back(cgroup.cpu());
@@ -574,10 +807,15 @@ void Scheduler::SetRequirement(Requirement::Ptr require,
         require->volum_jobs.push_back(container_desc.volum_jobs(j));
     }
     require->container_type = container_desc.container_type();
+    require->gang = container_desc.gang();
+    require->gang_min = container_desc.gang_min();
+    require->gang_timeout = container_desc.gang_timeout();
 }
 
 void Scheduler::AddAgent(Agent::Ptr agent, const proto::AgentInfo& agent_info) {
     MutexLock locker(&mu_);
+    agent->domain_counts_ = &domain_counts_;
+    agent->group_handles_ = &group_handles_;
 
     int64_t cpu_assigned = 0;
     int64_t cpu_reserved = 0;
@@ -589,7 +827,7 @@ void Scheduler::AddAgent(Agent::Ptr agent, const proto::AgentInfo& agent_info) {
     int64_t memory_deep_reserved = 0;
     std::map<DevicePath, VolumInfo> volum_assigned;
     std::set<std::string> port_assigned;
-    std::map<ContainerId, Container::Ptr> containers;
+    ContainerMap containers;
 
     for (int i = 0; i < agent_info.container_info_size(); i++) {
         const proto::ContainerInfo& container_info = agent_info.container_info(i);
@@ -622,36 +860,31 @@ void Scheduler::AddAgent(Agent::Ptr agent, const proto::AgentInfo& agent_info) {
         container->allocated_ports.clear();
         container->allocated_volums.clear();
         container->allocated_volum_containers.clear();
+        container->allocated_numa_node = -1;
 
         Requirement::Ptr require(new Requirement());
         const proto::ContainerDescription& container_desc = container_info.container_desc();
         SetRequirement(require, container_desc);
         if (container_group->require->version == require->version) {
             require = container_group->require;
+        } else {
+            updating_groups_.insert(container_group->id);
         }
         container->id = container_info.id();
         container->container_group_id = container_info.group_id();
+        container->group_handle = container_group->handle;
         container->priority = container_desc.priority();
-        container->status = container_info.status();
         container->require = require;
         if (container->priority != proto::kJobBestEffort) {
-            cpu_assigned += require->CpuNeed();
-            cpu_reserved += std::min(
-                static_cast<int64_t>(container_info.cpu_used() * FLAGS_reserved_percent),
-                require->CpuNeed());
+            cpu_assigned += require->SharedCpuNeed();
+            cpu_reserved += CpuReserved(container.get(), container_info, agent_info, require->SharedCpuNeed());
             memory_assigned += require->MemoryNeed();
-            memory_reserved += std::min(
-                static_cast<int64_t>(container_info.memory_used() * FLAGS_reserved_percent),
-                require->MemoryNeed());
+            memory_reserved += MemoryReserved(container.get(), container_info, agent_info, require->MemoryNeed());
         } else {
-            cpu_deep_assigned += require->CpuNeed();
-            cpu_deep_reserved += std::min(
-                static_cast<int64_t>(container_info.cpu_used() * FLAGS_reserved_percent),
-                require->CpuNeed());
+            cpu_deep_assigned += require->SharedCpuNeed();
+            cpu_deep_reserved += CpuReserved(container.get(), container_info, agent_info, require->SharedCpuNeed());
             memory_deep_assigned += require->MemoryNeed();
-            memory_deep_reserved += std::min(
-                static_cast<int64_t>(container_info.memory_used() * FLAGS_reserved_percent),
-                require->MemoryNeed());
+            memory_deep_reserved += MemoryReserved(container.get(), container_info, agent_info, require->MemoryNeed());
         }
         for (int j = 0; j < container_desc.cgroups_size(); j++) {
             const proto::Cgroup& cgroup = container_desc.cgroups(j);
@@ -659,6 +892,9 @@ void Scheduler::AddAgent(Agent::Ptr agent, const proto::AgentInfo& agent_info) {
                 container->allocated_ports.push_back(cgroup.ports(k).real_port());
                 port_assigned.insert(cgroup.ports(k).real_port());
             }
+            if (cgroup.cpu().exclusive() && cgroup.cpu().has_numa_node()) {
+                container->allocated_numa_node = cgroup.cpu().numa_node();
+            }
         }
 
         VolumInfo workspace_volum;
@@ -704,9 +940,9 @@ void Scheduler::AddAgent(Agent::Ptr agent, const proto::AgentInfo& agent_info) {
             );
         }
         containers[container->id] = container;
-        container_groups_[container->container_group_id]->containers[container->id] = container;
+        container_group->containers[container->id] = container;
         container->allocated_agent = agent->endpoint_;
-        ChangeStatus(container, container->status);
+        ChangeStatus(container_group, container, container_info.status());
     }
     agent->SetAssignment(
         cpu_assigned, cpu_deep_assigned,
@@ -716,7 +952,13 @@ void Scheduler::AddAgent(Agent::Ptr agent, const proto::AgentInfo& agent_info) {
         containers);
     agent->SetReserved(cpu_reserved, cpu_deep_reserved,
                        memory_reserved, memory_deep_reserved);
+    std::map<AgentEndpoint, Agent::Ptr>::iterator it = agents_.find(agent->endpoint_);
+    if (it != agents_.end()) {
+        LeavePool(it->second);
+    }
     agents_[agent->endpoint_] = agent;
+    JoinPool(agent);
+    MarkAgentDirty(agent->endpoint_);
 }
 
 void Scheduler::RemoveAgent(const AgentEndpoint& endpoint) {
@@ -743,6 +985,7 @@ void Scheduler::RemoveAgent(const AgentEndpoint& endpoint) {
             }
         }
     }
+    LeavePool(agent);
     agents_.erase(endpoint);
 }
 
@@ -754,7 +997,10 @@ void Scheduler::AddTag(const AgentEndpoint& endpoint, const std::string& tag) {
         return;
     }
     Agent::Ptr agent = it->second;
-    agent->tags_.insert(tag);
+    std::set<std::string> tags = agent->tags_;
+    tags.insert(tag);
+    agent->SetTags(tags);
+    MarkAgentDirty(endpoint);
 }
 
 void Scheduler::RemoveTag(const AgentEndpoint& endpoint, const std::string& tag) {
@@ -765,7 +1011,10 @@ void Scheduler::RemoveTag(const AgentEndpoint& endpoint, const std::string& tag)
         return;
     }
     Agent::Ptr agent = it->second;
-    agent->tags_.erase(tag);
+    std::set<std::string> tags = agent->tags_;
+    tags.erase(tag);
+    agent->SetTags(tags);
+    MarkAgentDirty(endpoint);
 }
 
 void Scheduler::SetPool(const AgentEndpoint& endpoint, const std::string& pool_name) {
@@ -776,7 +1025,10 @@ void Scheduler::SetPool(const AgentEndpoint& endpoint, const std::string& pool_n
         return;
     }
     Agent::Ptr agent = it->second;
+    LeavePool(agent);
     agent->pool_name_ = pool_name;
+    JoinPool(agent);
+    MarkAgentDirty(endpoint);
 }
 
 ContainerGroupId Scheduler::GenerateContainerGroupId(const std::string& container_group_name) {
@@ -831,24 +1083,33 @@ ContainerGroupId Scheduler::Submit(const std::string& container_group_name,
     container_group->name = container_group_name;
     container_group->user_name = user_name;
     container_group->submit_time = common::timer::get_micros();
+    AddContainerGroup(container_group);
     for (int i = 0 ; i < replica; i++) {
         Container::Ptr container(new Container());
         container->container_group_id = container_group->id;
+        container->group_handle = container_group->handle;
         container->id = GenerateContainerId(container_group_id, i);
         container->require = req;
         container->priority = priority;
         container_group->containers[container->id] = container;
         ChangeStatus(container_group, container, kContainerPending);
     }
-    container_groups_[container_group_id] = container_group;
-    container_group_queue_.insert(container_group);
     return container_group->id;
 }
 
 void Scheduler::Reload(const proto::ContainerGroupMeta& container_group_meta) {
     MutexLock lock(&mu_);
     Requirement::Ptr req(new Requirement());
-    ContainerGroup::Ptr container_group(new ContainerGroup());
+    ContainerGroup::Ptr container_group;
+    std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator it
+        = container_groups_.find(container_group_meta.id());
+    if (it != container_groups_.end()) {
+        // reloaded again by a hot standby, keep the containers learned from agents
+        container_group = it->second;
+        Dequeue(container_group);
+    } else {
+        container_group.reset(new ContainerGroup());
+    }
     VLOG(10) << "reload desc:" << container_group_meta.desc().DebugString();
     SetRequirement(req, container_group_meta.desc());
     container_group->require = req;
@@ -856,6 +1117,9 @@ void Scheduler::Reload(const proto::ContainerGroupMeta& container_group_meta) {
     container_group->priority = container_group_meta.desc().priority();
     container_group->replica = container_group_meta.replica();
     container_group->update_interval = container_group_meta.update_interval();
+    container_group->max_surge = container_group_meta.max_surge();
+    container_group->max_unavailable = container_group_meta.max_unavailable();
+    container_group->update_paused = container_group_meta.update_paused();
     container_group->container_desc = container_group_meta.desc();
     container_group->name = container_group_meta.name();
     container_group->user_name = container_group_meta.user_name();
@@ -866,9 +1130,13 @@ void Scheduler::Reload(const proto::ContainerGroupMeta& container_group_meta) {
     } else {
         container_group->terminated = false;
     }
-
-    container_groups_[container_group->id] = container_group;
-    container_group_queue_.insert(container_group);
+    BOOST_FOREACH(const Container::Ptr& pending_container, container_group->states[kContainerPending]) {
+        pending_container->require = container_group->require;
+    }
+    ChargeUser(container_group);
+    AddContainerGroup(container_group);
+    // containers of an update in progress may come back from the agents
+    updating_groups_.insert(container_group->id);
 }
 
 bool Scheduler::Kill(const ContainerGroupId& container_group_id) {
@@ -904,8 +1172,8 @@ void Scheduler::CheckContainerGroupGC(ContainerGroup::Ptr container_group) {
         }
     }
     if (all_container_terminated) {
-        container_groups_.erase(container_group->id);
-        container_group_queue_.erase(container_group);
+        UnchargeUser(container_group);
+        RemoveContainerGroup(container_group);
         //after this, all containers wish to be deleted
     } else {
         gc_pool_.DelayTask(FLAGS_container_group_gc_check_interval,
@@ -932,6 +1200,10 @@ bool Scheduler::ChangeReplica(const ContainerGroupId& container_group_id, int re
     int current_replica = container_group->Replica();
     if (replica == current_replica) {
         LOG(INFO) << "replica not change, do nothing" ;
+    } else if (FLAGS_check_container_version
+               && replica == container_group->replica
+               && replica < current_replica) {
+        LOG(INFO) << "surge containers of the rolling update are left to the update engine";
     } else if (replica < current_replica) {
         ScaleDown(container_group, replica);
     } else {
@@ -945,9 +1217,8 @@ void Scheduler::ScaleDown(ContainerGroup::Ptr container_group, int replica) {
     mu_.AssertHeld();
     int delta = container_group->Replica() - replica;
     //remove from pending first
-    ContainerMap pending_containers = container_group->states[kContainerPending];
-    BOOST_FOREACH(ContainerMap::value_type& pair, pending_containers) {
-        Container::Ptr container = pair.second;
+    std::vector<Container::Ptr> pending_containers = container_group->states[kContainerPending].Items();
+    BOOST_FOREACH(Container::Ptr container, pending_containers) {
         ChangeStatus(container_group, container, kContainerTerminated);
         --delta;
         if (delta <= 0) {
@@ -957,10 +1228,9 @@ void Scheduler::ScaleDown(ContainerGroup::Ptr container_group, int replica) {
     ContainerStatus all_status[] = {kContainerAllocating, kContainerReady};
     for (size_t i = 0; i < (sizeof(all_status) / sizeof(all_status[0])) && delta > 0; i++) {
         ContainerStatus st = all_status[i];
-        ContainerMap working_containers = container_group->states[st];
-        BOOST_FOREACH(ContainerMap::value_type& pair, working_containers) {
-            Container::Ptr container = pair.second;
-            ChangeStatus(container, kContainerDestroying);
+        std::vector<Container::Ptr> working_containers = container_group->states[st].Items();
+        BOOST_FOREACH(Container::Ptr container, working_containers) {
+            ChangeStatus(container_group, container, kContainerDestroying);
             --delta;
             if (delta <= 0) {
                 break;
@@ -981,6 +1251,7 @@ void Scheduler::ScaleUp(ContainerGroup::Ptr container_group, int replica) {
         if (it == container_group->containers.end()) {
             container.reset(new Container());
             container->container_group_id = container_group->id;
+            container->group_handle = container_group->handle;
             container->id = container_id;
             container->require = container_group->require;
             container_group->containers[container_id] = container;
@@ -1016,13 +1287,11 @@ bool Scheduler::ChangeStatus(const ContainerGroupId& container_group_id,
 void Scheduler::ChangeStatus(Container::Ptr container,
                              ContainerStatus new_status) {
     mu_.AssertHeld();
-    ContainerGroupId container_group_id = container->container_group_id;
-    std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator it = container_groups_.find(container_group_id);
-    if (it == container_groups_.end()) {
-        LOG(WARNING) << "change status fail, no such container_group:" << container_group_id;
+    ContainerGroup::Ptr container_group = GroupOf(container);
+    if (!container_group) {
+        LOG(WARNING) << "change status fail, no such container_group:" << container->container_group_id;
         return;
     }
-    ContainerGroup::Ptr container_group = it->second;
     return ChangeStatus(container_group, container, new_status);
 }
 
@@ -1030,14 +1299,14 @@ void Scheduler::ChangeStatus(ContainerGroup::Ptr container_group,
                              Container::Ptr container,
                              ContainerStatus new_status) {
     mu_.AssertHeld();
-    ContainerId container_id = container->id;
-    if (container_group->containers.find(container_id) == container_group->containers.end()) {
+    const ContainerId& container_id = container->id;
+    if (container->group_handle != container_group->handle) {
         LOG(WARNING) << "change status fail, no such container id: " << container_id;
         return;
     }
     ContainerStatus old_status = container->status;
-    container_group->states[old_status].erase(container_id);
-    container_group->states[new_status][container_id] = container;
+    container_group->states[old_status].Remove(container);
+    container_group->states[new_status].Add(container);
     LOG(INFO) << "change status: " << container_id
               << " from: " << proto::ContainerStatus_Name(old_status)
               << " to:" << proto::ContainerStatus_Name(new_status);
@@ -1047,20 +1316,69 @@ void Scheduler::ChangeStatus(ContainerGroup::Ptr container_group,
         if (it != agents_.end()) {
             Agent::Ptr agent = it->second;
             agent->Evict(container);
+            MarkAgentDirty(agent->endpoint_);
         }
         container->allocated_volums.clear();
         container->allocated_ports.clear();
         container->allocated_volum_containers.clear();
         container->require = container_group->require;
         container->remote_info.Clear();
+        container->cpu_usage.Clear();
+        container->memory_usage.Clear();
         if (new_status == kContainerPending) {
             container->allocated_agent.erase();
+            container->pending_since = common::timer::get_micros();
+            MarkGroupDirty(container_group);
         }
     }
+    if (old_status == kContainerPending && new_status == kContainerAllocating
+            && container->pending_since > 0) {
+        pending_latency_.Add(common::timer::get_micros() - container->pending_since);
+    }
     container->status = new_status;
     if (new_status == kContainerReady) {
         container->last_res_err = proto::kResOk;
     }
+    ChargeUser(container_group);
+}
+
+UserAlloc Scheduler::GroupAlloc(ContainerGroup::Ptr container_group) {
+    UserAlloc alloc;
+    int64_t replica = container_group->Replica();
+    const Requirement::Ptr& require = container_group->require;
+    alloc.replica = replica;
+    if (container_group->priority != proto::kJobBestEffort) {
+        alloc.millicore = require->CpuNeed() * replica;
+        alloc.memory = require->MemoryNeed() * replica;
+    }
+    alloc.memory += require->TmpfsNeed() * replica;
+    alloc.disk = require->DiskNeed() * replica;
+    alloc.ssd = require->SsdNeed() * replica;
+    return alloc;
+}
+
+void Scheduler::ChargeUser(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    UserAlloc alloc = GroupAlloc(container_group);
+    if (alloc == container_group->alloc) {
+        return;
+    }
+    UserAlloc& user_alloc = user_allocs_[container_group->user_name];
+    user_alloc.Add(container_group->alloc, -1);
+    user_alloc.Add(alloc, 1);
+    container_group->alloc = alloc;
+}
+
+void Scheduler::UnchargeUser(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    std::map<std::string, UserAlloc>::iterator it = user_allocs_.find(container_group->user_name);
+    if (it != user_allocs_.end()) {
+        it->second.Add(container_group->alloc, -1);
+        if (it->second == UserAlloc()) {
+            user_allocs_.erase(it);
+        }
+    }
+    container_group->alloc = UserAlloc();
 }
 
 void Scheduler::CheckTagAndPool(Agent::Ptr agent) {
@@ -1082,6 +1400,9 @@ void Scheduler::Start() {
     {
         MutexLock lock(&mu_);
         stop_ = false;
+        if (!dirty_agents_.empty() || !dirty_groups_.empty()) {
+            WakeDirtyWorker(); //events while stopped
+        }
         std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator it;
         for (it = container_groups_.begin(); it != container_groups_.end(); it++) {
             replicas.push_back(std::make_pair(it->first, it->second->replica));
@@ -1099,8 +1420,11 @@ void Scheduler::Start() {
             Kill(group_id);
         }
     }
-    AgentEndpoint fake_endpoint = "";
-    ScheduleNextAgent(fake_endpoint);
+    MutexLock lock(&mu_);
+    std::map<std::string, SchedPool::Ptr>::iterator it;
+    for (it = pools_.begin(); it != pools_.end(); it++) {
+        StartPool(it->second);
+    }
 }
 
 void Scheduler::Stop() {
@@ -1130,94 +1454,621 @@ void Scheduler::CheckVersion(Agent::Ptr agent) {
     ContainerMap containers = agent->containers_;
     BOOST_FOREACH(ContainerMap::value_type& pair, containers) {
         Container::Ptr container = pair.second;
-        ContainerGroupId container_group_id = container->container_group_id;
-        std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator it = container_groups_.find(container_group_id);
-        if (it == container_groups_.end()) {
-            LOG(WARNING) << "check version exception, no such container_group, so evict it" << container_group_id;
+        ContainerGroup::Ptr container_group = GroupOf(container);
+        if (!container_group) {
+            LOG(WARNING) << "check version exception, no such container_group, so evict it"
+                         << container->container_group_id;
             agent->Evict(container);
+            MarkAgentDirty(agent->endpoint_);
             continue;
         }
-        ContainerGroup::Ptr container_group = it->second;
         if (container->require->version == container_group->require->version) {
             container->require = container_group->require;
-            continue;
         }
-        int32_t now = common::timer::now_time();
-        if (now - container_group->last_update_time < container_group->update_interval) {
-            continue;
+        //containers of old versions are replaced by RollingUpdate
+    }
+}
+
+void Scheduler::CheckUpdateRoutine() {
+    {
+        MutexLock lock(&mu_);
+        if (!stop_ && FLAGS_check_container_version) {
+            std::set<ContainerGroupId>::iterator it = updating_groups_.begin();
+            while (it != updating_groups_.end()) {
+                std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator jt
+                    = container_groups_.find(*it);
+                if (jt == container_groups_.end() || !RollingUpdate(jt->second)) {
+                    updating_groups_.erase(it++);
+                } else {
+                    it++;
+                }
+            }
         }
-        //update container require, and re-schedule it.
-        ChangeStatus(container, kContainerPending);
-        container->require = container_group->require;
+    }
+    update_pool_.DelayTask(FLAGS_rolling_update_check_interval,
+                           boost::bind(&Scheduler::CheckUpdateRoutine, this));
+}
+
+bool Scheduler::RollingUpdate(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    if (container_group->terminated) {
+        return false;
+    }
+    if (container_group->update_paused) {
+        return true;
+    }
+    std::vector<Container::Ptr> old_containers;
+    proto::UpdateProgress progress;
+    GetUpdateProgress(container_group, old_containers, progress);
+    if (old_containers.empty()) {
+        return false;
+    }
+    int replica = container_group->replica;
+    int max_surge = std::max(container_group->max_surge, 0);
+    int max_unavailable = std::max(container_group->max_unavailable, 0);
+    if (max_surge == 0 && max_unavailable == 0) {
+        max_unavailable = 1; //or the update never moves
+    }
+    int updated = progress.updated();
+    int total = updated + old_containers.size();
+    //start new containers first, the old ones keep serving meanwhile
+    int surge = 0;
+    while (total < replica + max_surge && updated < replica) {
+        AddSurgeContainer(container_group);
+        updated++;
+        total++;
+        surge++;
+    }
+    int32_t now = common::timer::now_time();
+    if (now - container_group->last_update_time < container_group->update_interval) {
+        return true;
+    }
+    //old containers are ordered not ready first, those cost no availability
+    int ready = container_group->states[kContainerReady].size();
+    int retired = 0;
+    for (size_t i = 0; i < old_containers.size(); i++) {
+        Container::Ptr container = old_containers[i];
+        bool available = (container->status == kContainerReady);
+        if (available && ready - 1 < replica - max_unavailable) {
+            break;
+        }
+        if (total > replica) {
+            //a new container has taken its place
+            if (container->status == kContainerPending) {
+                ChangeStatus(container_group, container, kContainerTerminated);
+            } else {
+                ChangeStatus(container_group, container, kContainerDestroying);
+            }
+            total--;
+        } else {
+            //update container require, and re-schedule it.
+            ChangeStatus(container_group, container, kContainerPending);
+        }
+        if (available) {
+            ready--;
+        }
+        retired++;
+    }
+    if (retired > 0) {
         container_group->last_update_time = now;
     }
+    if (surge > 0 || retired > 0) {
+        LOG(INFO) << "rolling update " << container_group->id
+                  << " to version: " << progress.version()
+                  << ", surge: " << surge << ", retired: " << retired
+                  << ", updated: " << progress.updated()
+                  << ", old: " << progress.old()
+                  << ", unavailable: " << progress.unavailable();
+    }
+    return true;
+}
+
+void Scheduler::GetUpdateProgress(ContainerGroup::Ptr container_group,
+                                  std::vector<Container::Ptr>& old_containers,
+                                  proto::UpdateProgress& progress) {
+    mu_.AssertHeld();
+    const std::string& version = container_group->require->version;
+    int updated = 0;
+    int updated_ready = 0;
+    ContainerStatus live_status[] = {kContainerPending, kContainerAllocating, kContainerReady};
+    for (size_t i = 0; i < (sizeof(live_status) / sizeof(live_status[0])); i++) {
+        ContainerStatus st = live_status[i];
+        BOOST_FOREACH(const Container::Ptr& container, container_group->states[st]) {
+            if (container->require->version == version) {
+                updated++;
+                if (st == kContainerReady) {
+                    updated_ready++;
+                }
+            } else {
+                old_containers.push_back(container);
+            }
+        }
+    }
+    int replica = container_group->replica;
+    int total = updated + old_containers.size();
+    int ready = container_group->states[kContainerReady].size();
+    progress.set_version(version);
+    progress.set_updated(updated);
+    progress.set_updated_ready(updated_ready);
+    progress.set_old(old_containers.size());
+    progress.set_surge(std::max(total - replica, 0));
+    progress.set_unavailable(std::max(replica - ready, 0));
+    progress.set_paused(container_group->update_paused);
+    progress.set_max_surge(container_group->max_surge);
+    progress.set_max_unavailable(container_group->max_unavailable);
+}
+
+void Scheduler::AddSurgeContainer(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    Container::Ptr container;
+    for (int i = 0; !container; i++) {
+        ContainerId container_id = GenerateContainerId(container_group->id, i);
+        ContainerMap::iterator it = container_group->containers.find(container_id);
+        if (it == container_group->containers.end()) {
+            container.reset(new Container());
+            container->container_group_id = container_group->id;
+            container->group_handle = container_group->handle;
+            container->id = container_id;
+            container->require = container_group->require;
+            container->priority = container_group->priority;
+            container_group->containers[container_id] = container;
+        } else if (it->second->status == kContainerTerminated) {
+            container = it->second;
+        }
+    }
+    ChangeStatus(container_group, container, kContainerPending);
+}
+
+bool Scheduler::PauseUpdate(const ContainerGroupId& container_group_id, bool paused) {
+    MutexLock locker(&mu_);
+    std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator it = container_groups_.find(container_group_id);
+    if (it == container_groups_.end()) {
+        LOG(WARNING) << "pause update fail, no such container_group: " << container_group_id;
+        return false;
+    }
+    it->second->update_paused = paused;
+    LOG(INFO) << "rolling update of " << container_group_id
+              << (paused ? " paused" : " resumed");
+    return true;
+}
+
+bool Scheduler::ShowUpdateProgress(const ContainerGroupId& container_group_id,
+                                   proto::UpdateProgress& progress) {
+    MutexLock locker(&mu_);
+    std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator it = container_groups_.find(container_group_id);
+    if (it == container_groups_.end()) {
+        return false;
+    }
+    std::vector<Container::Ptr> old_containers;
+    GetUpdateProgress(it->second, old_containers, progress);
+    return true;
 }
 
-void Scheduler::ScheduleNextAgent(AgentEndpoint pre_endpoint) {
-    VLOG(20) << "scheduling the agent after: " << pre_endpoint;
+void Scheduler::ScheduleNextAgent(SchedPool* pool, AgentEndpoint pre_endpoint) {
+    VLOG(20) << "scheduling the agent of pool " << pool->name << " after: " << pre_endpoint;
     Agent::Ptr agent;
     AgentEndpoint endpoint;
-    MutexLock lock(&mu_);
-    if (stop_ || agents_.empty()) {
+    std::vector<ContainerGroup::Ptr> groups;
+    {
+        MutexLock pool_lock(&pool->mu);
+        if (pool->agents.empty()) {
+            VLOG(16) << "no alive agents in pool: " << pool->name;
+            pool->sched_pool.DelayTask(FLAGS_sched_interval,
+                        boost::bind(&Scheduler::ScheduleNextAgent, this, pool, pre_endpoint));
+            return;
+        }
+        std::map<AgentEndpoint, Agent::Ptr>::iterator it;
+        it = pool->agents.upper_bound(pre_endpoint);
+        if (it == pool->agents.end()) {
+            // turn to the start
+            pool->sched_pool.AddTask(boost::bind(&Scheduler::ScheduleNextAgent, this, pool, ""));
+            return;
+        }
+        agent = it->second;
+        endpoint = it->first;
+        groups.assign(pool->queue.begin(), pool->queue.end());
+    }
+
+    //one pending container of each group of the pool is tried on the agent
+    std::vector<Container::Ptr> containers;
+    std::vector<Requirement::Ptr> requirements;
+    {
+        MutexLock lock(&mu_);
         if (stop_) {
             VLOG(16) << "no scheduling, because scheduler is stoped.";
+            pool->sched_pool.DelayTask(FLAGS_sched_interval,
+                        boost::bind(&Scheduler::ScheduleNextAgent, this, pool, pre_endpoint));
+            return;
+        }
+        std::map<AgentEndpoint, Agent::Ptr>::iterator it = agents_.find(endpoint);
+        if (it == agents_.end() || it->second != agent) {
+            //removed or replaced while waiting for the lock
+            pool->sched_pool.AddTask(boost::bind(&Scheduler::ScheduleNextAgent, this, pool, endpoint));
+            return;
+        }
+        if (FLAGS_check_container_version) {
+            CheckVersion(agent); //check containers version
+        }
+        CheckTagAndPool(agent); //may evict some containers
+        if (agent->pool_name_ != pool->name) {
+            //moved to another pool while waiting for the lock
+            pool->sched_pool.AddTask(boost::bind(&Scheduler::ScheduleNextAgent, this, pool, endpoint));
+            return;
         }
-        if (agents_.empty()) {
-            VLOG(16) << "no alive agents for scheduler.";
+        for (size_t i = 0; i < groups.size(); i++) {
+            ContainerGroup::Ptr container_group = groups[i];
+            if (container_group->states[kContainerPending].size() == 0) {
+                continue; // no pending pods
+            }
+            if (container_group->require->gang) {
+                continue; // placed as a whole by GangSchedule
+            }
+            const ContainerBucket& pending = container_group->states[kContainerPending];
+            if (container_group->sched_cursor >= pending.size()) {
+                container_group->sched_cursor = 0;
+            }
+            Container::Ptr container = pending[container_group->sched_cursor++];
+            containers.push_back(container);
+            requirements.push_back(container->require);
         }
-        sched_pool_.DelayTask(FLAGS_sched_interval,
-                    boost::bind(&Scheduler::ScheduleNextAgent, this, pre_endpoint));
+    }
+
+    //fits against the ledger of the agent, out of mu_
+    std::vector<ResourceError> res_errs(containers.size(), proto::kResOk);
+    std::vector<int64_t> ledger_versions(containers.size(), 0);
+    for (size_t i = 0; i < containers.size(); i++) {
+        agent->TryFit(requirements[i].get(), containers[i]->priority,
+                      res_errs[i], ledger_versions[i]);
+    }
+
+    {
+        MutexLock lock(&mu_);
+        std::map<AgentEndpoint, Agent::Ptr>::iterator it = agents_.find(endpoint);
+        bool same_agent = it != agents_.end() && it->second == agent
+                          && agent->pool_name_ == pool->name;
+        for (size_t i = 0; same_agent && i < containers.size(); i++) {
+            Container::Ptr container = containers[i];
+            if (container->status != kContainerPending
+                || !container->allocated_agent.empty()
+                || container->require != requirements[i]) {
+                continue; //changed while fitting
+            }
+            ResourceError res_err = res_errs[i];
+            //the fit holds while the ledger is unchanged, else check it again
+            bool fits = false;
+            if (res_err == proto::kResOk) {
+                fits = agent->ledger_version_ == ledger_versions[i]
+                       ? agent->CheckPlacement(container.get(), res_err)
+                       : agent->TryPut(container.get(), res_err);
+            }
+            if (fits) {
+                agent->Put(container);
+                ChangeStatus(container, kContainerAllocating);
+                continue;
+            }
+            SetResError(container, res_err);
+            VLOG(10) << "try put fail: " << container->id
+                     << " agent:" << endpoint
+                     << ", err:" << proto::ResourceError_Name(res_err);
+        }
+        ReportLatency();
+    }
+    //scheduling round for the next agent
+    pool->sched_pool.DelayTask(FLAGS_sched_interval,
+                    boost::bind(&Scheduler::ScheduleNextAgent, this, pool, endpoint));
+}
+
+SchedPool::Ptr Scheduler::GetPool(const std::string& pool_name) {
+    mu_.AssertHeld();
+    std::map<std::string, SchedPool::Ptr>::iterator it = pools_.find(pool_name);
+    if (it != pools_.end()) {
+        return it->second;
+    }
+    SchedPool::Ptr pool(new SchedPool());
+    pool->name = pool_name;
+    pools_[pool_name] = pool;
+    if (!stop_) {
+        StartPool(pool);
+    }
+    return pool;
+}
+
+void Scheduler::StartPool(SchedPool::Ptr pool) {
+    mu_.AssertHeld();
+    if (pool->started) {
         return;
     }
-    std::map<AgentEndpoint, Agent::Ptr>::iterator it;
-    it = agents_.upper_bound(pre_endpoint);
-    if (it != agents_.end()) {
-        agent = it->second;
-        endpoint = it->first;
-    } else {
-        // turn to the start
-        sched_pool_.AddTask(boost::bind(&Scheduler::ScheduleNextAgent, this, ""));
+    pool->started = true;
+    LOG(INFO) << "start scheduling pool: " << pool->name;
+    pool->sched_pool.DelayTask(FLAGS_sched_interval,
+                    boost::bind(&Scheduler::ScheduleNextAgent, this, pool.get(), ""));
+}
+
+void Scheduler::JoinPool(Agent::Ptr agent) {
+    mu_.AssertHeld();
+    SchedPool::Ptr pool = GetPool(agent->pool_name_);
+    MutexLock lock(&pool->mu);
+    pool->agents[agent->endpoint_] = agent;
+}
+
+void Scheduler::LeavePool(Agent::Ptr agent) {
+    mu_.AssertHeld();
+    std::map<std::string, SchedPool::Ptr>::iterator it = pools_.find(agent->pool_name_);
+    if (it != pools_.end()) {
+        MutexLock lock(&it->second->mu);
+        it->second->agents.erase(agent->endpoint_);
+    }
+}
+
+void Scheduler::Enqueue(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    container_group_queue_.insert(container_group);
+    container_group->queued_pools = container_group->require->pool_names;
+    BOOST_FOREACH(const std::string& pool_name, container_group->queued_pools) {
+        SchedPool::Ptr pool = GetPool(pool_name);
+        MutexLock lock(&pool->mu);
+        pool->queue.insert(container_group);
+    }
+}
+
+void Scheduler::Dequeue(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    container_group_queue_.erase(container_group);
+    BOOST_FOREACH(const std::string& pool_name, container_group->queued_pools) {
+        SchedPool::Ptr pool = pools_[pool_name];
+        MutexLock lock(&pool->mu);
+        pool->queue.erase(container_group);
+    }
+    container_group->queued_pools.clear();
+}
+
+void Scheduler::SetResError(Container::Ptr container, ResourceError res_err) {
+    if (container->last_res_err == proto::kResOk
+        || container->last_res_err == proto::kTagMismatch
+        || container->last_res_err == proto::kPoolMismatch
+        || container->last_res_err == proto::kTooManyPods
+        || container->last_res_err == proto::kTooManyPodsInDomain
+        || container->last_res_err == proto::kAntiAffinityConflict
+        || container->last_res_err == proto::kGangQuorumUnmet) {
+        container->last_res_err = res_err;
+    }
+}
+
+void Scheduler::MarkAgentDirty(const AgentEndpoint& endpoint) {
+    mu_.AssertHeld();
+    if (!FLAGS_sched_on_events) {
+        return;
+    }
+    dirty_agents_.insert(std::make_pair(endpoint, common::timer::get_micros()));
+    WakeDirtyWorker();
+}
+
+void Scheduler::MarkGroupDirty(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    if (!FLAGS_sched_on_events || container_group->require->gang) {
+        return; //gangs are placed as a whole by GangSchedule
+    }
+    dirty_groups_.insert(std::make_pair(container_group->handle, common::timer::get_micros()));
+    WakeDirtyWorker();
+}
+
+void Scheduler::WakeDirtyWorker() {
+    mu_.AssertHeld();
+    if (dirty_scheduled_ || stop_) {
         return;
     }
+    dirty_scheduled_ = true;
+    sched_pool_.AddTask(boost::bind(&Scheduler::ScheduleDirty, this));
+}
 
-    if (FLAGS_check_container_version) {
-        CheckVersion(agent); //check containers version
+void Scheduler::ScheduleDirty() {
+    MutexLock lock(&mu_);
+    dirty_scheduled_ = false;
+    if (stop_) {
+        return; //left to Start
+    }
+    std::map<AgentEndpoint, int64_t> dirty_agents;
+    std::map<GroupHandle, int64_t> dirty_groups;
+    dirty_agents.swap(dirty_agents_);
+    dirty_groups.swap(dirty_groups_);
+    int placed = 0;
+    //room made on an agent goes to the pending containers by priority
+    std::map<AgentEndpoint, int64_t>::iterator it;
+    for (it = dirty_agents.begin(); it != dirty_agents.end(); it++) {
+        std::map<AgentEndpoint, Agent::Ptr>::iterator agent_it = agents_.find(it->first);
+        if (agent_it == agents_.end()) {
+            continue;
+        }
+        const ContainerGroupQueue& queue = GetPool(agent_it->second->pool_name_)->queue;
+        ContainerGroupQueue::const_iterator jt;
+        for (jt = queue.begin(); jt != queue.end(); jt++) {
+            if (!(*jt)->require->gang) {
+                placed += PlaceOn(agent_it->second, *jt, it->second);
+            }
+        }
     }
-    CheckTagAndPool(agent); //may evict some containers
-    //for each container_group checking pending containers, try to put on...
-    std::set<ContainerGroup::Ptr, ContainerGroupQueueLess>::iterator jt;
-    for (jt = container_group_queue_.begin(); jt != container_group_queue_.end(); jt++) {
-        ContainerGroup::Ptr container_group = *jt;
-        if (container_group->states[kContainerPending].size() == 0) {
-            continue; // no pending pods
+    //new pending containers look for room on all agents
+    std::map<GroupHandle, int64_t>::iterator gt;
+    for (gt = dirty_groups.begin(); gt != dirty_groups.end(); gt++) {
+        ContainerGroup::Ptr container_group = group_slots_[gt->first];
+        if (!container_group || container_group->terminated) {
+            continue;
         }
-        ContainerId last_id = container_group->last_sched_container_id;
-        ContainerMap::iterator container_it =
-                container_group->states[kContainerPending].upper_bound(last_id);
-        if (container_it == container_group->states[kContainerPending].end()) {
-            container_it = container_group->states[kContainerPending].begin();
+        BOOST_FOREACH(const std::string& pool_name, container_group->queued_pools) {
+            const std::map<AgentEndpoint, Agent::Ptr>& agents = pools_[pool_name]->agents;
+            std::map<AgentEndpoint, Agent::Ptr>::const_iterator agent_it;
+            for (agent_it = agents.begin();
+                 agent_it != agents.end() && !container_group->states[kContainerPending].empty();
+                 agent_it++) {
+                placed += PlaceOn(agent_it->second, container_group, gt->second);
+            }
         }
-        Container::Ptr container = container_it->second;
-        container_group->last_sched_container_id = container->id;
+    }
+    VLOG(10) << "placed " << placed << " containers for events of "
+             << dirty_agents.size() << " agents and " << dirty_groups.size() << " groups";
+}
+
+int Scheduler::PlaceOn(Agent::Ptr agent, ContainerGroup::Ptr container_group, int64_t event_time) {
+    mu_.AssertHeld();
+    const ContainerBucket& pending = container_group->states[kContainerPending];
+    int placed = 0;
+    while (!pending.empty()) {
+        //the last one leaves the bucket without a swap
+        Container::Ptr container = pending[pending.size() - 1];
         ResourceError res_err;
         if (!agent->TryPut(container.get(), res_err)) {
-            if (container->last_res_err == proto::kResOk
-                || container->last_res_err == proto::kTagMismatch
-                || container->last_res_err == proto::kPoolMismatch
-                || container->last_res_err == proto::kTooManyPods) {
+            SetResError(container, res_err);
+            break; //the others share the requirement, no room for them either
+        }
+        agent->Put(container);
+        ChangeStatus(container_group, container, kContainerAllocating);
+        event_latency_.Add(common::timer::get_micros() - event_time);
+        placed++;
+    }
+    return placed;
+}
+
+void Scheduler::ReportLatency() {
+    mu_.AssertHeld();
+    int64_t now = common::timer::get_micros();
+    if (now - last_latency_report_ < kLatencyReportInterval) {
+        return;
+    }
+    last_latency_report_ = now;
+    if (event_latency_.Count() > 0 || pending_latency_.Count() > 0) {
+        LOG(INFO) << "event to placement latency, " << event_latency_.ToString();
+        LOG(INFO) << "pending to placement latency, " << pending_latency_.ToString();
+    }
+}
+
+void Scheduler::GangScheduleRoutine() {
+    {
+        MutexLock lock(&mu_);
+        if (!stop_) {
+            std::set<ContainerGroup::Ptr, ContainerGroupQueueLess>::iterator it;
+            for (it = container_group_queue_.begin(); it != container_group_queue_.end(); it++) {
+                if ((*it)->require->gang) {
+                    GangSchedule(*it);
+                }
+            }
+        }
+    }
+    sched_pool_.DelayTask(FLAGS_gang_sched_interval,
+                          boost::bind(&Scheduler::GangScheduleRoutine, this));
+}
+
+void Scheduler::GangSchedule(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    if (container_group->terminated || agents_.empty()) {
+        return;
+    }
+    Requirement::Ptr require = container_group->require;
+    int live = container_group->states[kContainerAllocating].size()
+               + container_group->states[kContainerReady].size();
+    int quorum = container_group->replica;
+    if (require->gang_min > 0 && require->gang_min < quorum) {
+        quorum = require->gang_min;
+    }
+    std::vector<Container::Ptr> pending_containers = container_group->states[kContainerPending].Items();
+    if (pending_containers.empty()) {
+        container_group->gang_wait_since = 0;
+        container_group->gang_failures = 0;
+        container_group->gang_skip = 0;
+        return;
+    }
+    if (container_group->gang_skip > 0) {
+        //backs off after missing the quorum, the reservations of a pass go
+        //to the ledgers the pool threads fit against
+        container_group->gang_skip--;
+    } else if (ReserveGang(container_group, pending_containers, live, quorum)) {
+        container_group->gang_wait_since = 0;
+        container_group->gang_failures = 0;
+        return;
+    } else {
+        container_group->gang_failures++;
+        container_group->gang_skip = (1 << std::min(container_group->gang_failures,
+                                                    kMaxGangBackoffShift)) - 1;
+    }
+
+    if (live == 0) {
+        container_group->gang_wait_since = 0;
+        return; //holds nothing while waiting
+    }
+    int32_t now = common::timer::now_time();
+    if (container_group->gang_wait_since == 0) {
+        container_group->gang_wait_since = now;
+    }
+    if (now - container_group->gang_wait_since < require->gang_timeout) {
+        return;
+    }
+    //a partial gang only wastes what it holds, place it again as a whole
+    LOG(WARNING) << "gang " << container_group->id << " stays below quorum "
+                 << quorum << " for " << require->gang_timeout
+                 << "s, release its " << live << " containers";
+    ContainerStatus live_status[] = {kContainerAllocating, kContainerReady};
+    for (size_t i = 0; i < (sizeof(live_status) / sizeof(live_status[0])); i++) {
+        std::vector<Container::Ptr> holding_containers = container_group->states[live_status[i]].Items();
+        BOOST_FOREACH(Container::Ptr container, holding_containers) {
+            ChangeStatus(container_group, container, kContainerPending);
+        }
+    }
+    container_group->gang_wait_since = 0;
+    container_group->gang_failures = 0;
+    container_group->gang_skip = 0;
+}
+
+bool Scheduler::ReserveGang(ContainerGroup::Ptr container_group,
+                            const std::vector<Container::Ptr>& pending_containers,
+                            int live, int quorum) {
+    mu_.AssertHeld();
+    //reserve agents for the pending containers in one pass, first fit
+    std::vector<Container::Ptr> reserved;
+    std::map<AgentEndpoint, Agent::Ptr>::iterator cursor = agents_.begin();
+    BOOST_FOREACH(Container::Ptr container, pending_containers) {
+        bool fit = false;
+        for (size_t i = 0; i < agents_.size() && !fit; i++) {
+            if (cursor == agents_.end()) {
+                cursor = agents_.begin();
+            }
+            Agent::Ptr agent = cursor->second;
+            ResourceError res_err;
+            if (agent->TryPut(container.get(), res_err)) {
+                agent->Put(container);
+                reserved.push_back(container);
+                fit = true;
+            } else {
                 container->last_res_err = res_err;
+                cursor++;
             }
-            VLOG(10) << "try put fail: " << container->id
-                     << " agent:" << endpoint
-                     << ", err:" << proto::ResourceError_Name(res_err);
-            continue; //no feasiable
         }
-        agent->Put(container);
-        ChangeStatus(container, kContainerAllocating);
+        if (!fit) {
+            break; //the others share the requirement, no room for them either
+        }
     }
-    //scheduling round for the next agent
-    sched_pool_.DelayTask(FLAGS_sched_interval,
-                    boost::bind(&Scheduler::ScheduleNextAgent, this, endpoint));
+
+    if (live + (int)reserved.size() >= quorum) {
+        for (size_t i = 0; i < reserved.size(); i++) {
+            ChangeStatus(container_group, reserved[i], kContainerAllocating);
+        }
+        if (!reserved.empty()) {
+            LOG(INFO) << "gang " << container_group->id << " placed "
+                      << reserved.size() << " containers, live: " << live
+                      << ", quorum: " << quorum;
+        }
+        return true;
+    }
+
+    //no room for the quorum, give the reservations back
+    for (size_t i = 0; i < reserved.size(); i++) {
+        Container::Ptr container = reserved[i];
+        agents_[container->allocated_agent]->Evict(container);
+        container->allocated_volums.clear();
+        container->allocated_ports.clear();
+        container->allocated_volum_containers.clear();
+        container->allocated_agent.erase();
+        container->last_res_err = proto::kGangQuorumUnmet;
+    }
+    return false;
 }
 
 bool Scheduler::ManualSchedule(const AgentEndpoint& endpoint,
@@ -1246,7 +2097,7 @@ bool Scheduler::ManualSchedule(const AgentEndpoint& endpoint,
         fail_reason = "no pending pods";
         return false;
     }
-    Container::Ptr container_manual = container_group->states[kContainerPending].begin()->second;
+    Container::Ptr container_manual = container_group->states[kContainerPending][0];
     if (!CheckTagAndPoolOnce(agent, container_manual)) {
         LOG(WARNING) << "manual scheduling fail, because of mismatching tag or pools";
         fail_reason = "tag or pool mismatching";
@@ -1291,6 +2142,8 @@ bool Scheduler::ManualSchedule(const AgentEndpoint& endpoint,
 bool Scheduler::Update(const ContainerGroupId& container_group_id,
                        const proto::ContainerDescription& container_desc,
                        int update_interval,
+                       int max_surge,
+                       int max_unavailable,
                        std::string& new_version) {
     MutexLock locker(&mu_);
     std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator it = container_groups_.find(container_group_id);
@@ -1299,6 +2152,9 @@ bool Scheduler::Update(const ContainerGroupId& container_group_id,
         return false;
     }
     ContainerGroup::Ptr container_group = it->second;
+    //budgets apply to the update in progress too
+    container_group->max_surge = max_surge;
+    container_group->max_unavailable = max_unavailable;
     Requirement::Ptr require(new Requirement());
     SetRequirement(require, container_desc);
     if (!RequireHasDiff(require.get(), container_group->require.get())) {
@@ -1309,14 +2165,17 @@ bool Scheduler::Update(const ContainerGroupId& container_group_id,
     require->version = new_version;
     container_group->update_interval = update_interval;
     container_group->last_update_time = common::timer::now_time();
+    Dequeue(container_group);
     container_group->require = require;
+    Enqueue(container_group); //the pools may change
     container_group->container_desc = container_desc;
     container_group->container_desc.set_version(new_version);
     container_group->update_time = common::timer::get_micros();
-    BOOST_FOREACH(ContainerMap::value_type& pair, container_group->states[kContainerPending]) {
-        Container::Ptr pending_container = pair.second;
+    BOOST_FOREACH(const Container::Ptr& pending_container, container_group->states[kContainerPending]) {
         pending_container->require = container_group->require;
     }
+    ChargeUser(container_group);
+    updating_groups_.insert(container_group->id);
     return true;
 }
 
@@ -1348,8 +2207,13 @@ void Scheduler::MakeCommand(const std::string& agent_endpoint,
     int64_t cpu_deep_reserved = 0;
     int64_t memory_reserved = 0;
     int64_t memory_deep_reserved = 0;
-    ContainerMap containers_local = agent->containers_;
-    std::map<ContainerId, ContainerStatus> remote_status;
+    ContainerMap& containers_local = agent->containers_;
+    // statuses below change containers_, so they are walked through a snapshot
+    report_containers_.clear();
+    BOOST_FOREACH(ContainerMap::value_type& pair, containers_local) {
+        pair.second->reported_status = ContainerStatus();
+        report_containers_.push_back(pair.second);
+    }
     for (int i = 0; i < agent_info.container_info_size(); i++) {
         const proto::ContainerInfo& container_remote = agent_info.container_info(i);
         ContainerMap::iterator it_local = containers_local.find(container_remote.id());
@@ -1364,22 +2228,19 @@ void Scheduler::MakeCommand(const std::string& agent_endpoint,
         }
 
         // get reserved
-        if (it_local->second->priority != proto::kJobBestEffort) {
-            cpu_reserved += std::min(
-                static_cast<int64_t>(container_remote.cpu_used() * FLAGS_reserved_percent),
-                it_local->second->require->CpuNeed());
-            memory_reserved += it_local->second->require->TmpfsNeed();
-            memory_reserved += std::min(
-                static_cast<int64_t>(container_remote.memory_used() * FLAGS_reserved_percent),
-                it_local->second->require->MemoryNeed());
+        Container* reported = it_local->second.get();
+        if (reported->priority != proto::kJobBestEffort) {
+            cpu_reserved += CpuReserved(reported, container_remote, agent_info,
+                                        reported->require->SharedCpuNeed());
+            memory_reserved += reported->require->TmpfsNeed();
+            memory_reserved += MemoryReserved(reported, container_remote, agent_info,
+                                              reported->require->MemoryNeed());
         } else {
-            cpu_deep_reserved += std::min(
-                static_cast<int64_t>(container_remote.cpu_used() * FLAGS_reserved_percent),
-                it_local->second->require->CpuNeed());
-            memory_reserved += it_local->second->require->TmpfsNeed();
-            memory_deep_reserved += std::min(
-                static_cast<int64_t>(container_remote.memory_used() * FLAGS_reserved_percent),
-                it_local->second->require->MemoryNeed());
+            cpu_deep_reserved += CpuReserved(reported, container_remote, agent_info,
+                                             reported->require->SharedCpuNeed());
+            memory_reserved += reported->require->TmpfsNeed();
+            memory_deep_reserved += MemoryReserved(reported, container_remote, agent_info,
+                                                   reported->require->MemoryNeed());
         }
 
         const std::string& local_version = it_local->second->require->version;
@@ -1393,8 +2254,8 @@ void Scheduler::MakeCommand(const std::string& agent_endpoint,
             commands.push_back(cmd);
             continue;
         }
-        remote_status[container_remote.id()] = container_remote.status();
         Container::Ptr container_local = it_local->second;
+        container_local->reported_status = container_remote.status();
         container_local->remote_info.set_cpu_used(container_remote.cpu_used());
         container_local->remote_info.set_memory_used(container_remote.memory_used());
         container_local->remote_info.mutable_volum_used()->CopyFrom(container_remote.volum_used());
@@ -1405,19 +2266,17 @@ void Scheduler::MakeCommand(const std::string& agent_endpoint,
     agent->SetReserved(cpu_reserved, cpu_deep_reserved,
                        memory_reserved, memory_deep_reserved);
 
-    BOOST_FOREACH(ContainerMap::value_type& pair, containers_local) {
-        Container::Ptr container_local = pair.second;
+    for (size_t i = 0; i < report_containers_.size(); i++) {
+        Container::Ptr container_local = report_containers_[i];
         AgentCommand cmd;
         cmd.container_id = container_local->id;
         cmd.container_group_id = container_local->container_group_id;
-        ContainerStatus remote_st;
-        remote_st = remote_status[container_local->id];
-        ContainerGroup::Ptr container_group;
-        if (container_groups_.find(container_local->container_group_id) != container_groups_.end()) {
-            container_group = container_groups_[container_local->container_group_id];
-        } else {
+        ContainerStatus remote_st = container_local->reported_status;
+        ContainerGroup::Ptr container_group = GroupOf(container_local);
+        if (!container_group) {
             LOG(WARNING) << "make commands exception, no such container group: " << container_local->container_group_id;
             agent->Evict(container_local);
+            MarkAgentDirty(agent->endpoint_);
             continue;
         }
         switch (container_local->status) {
@@ -1461,6 +2320,8 @@ void Scheduler::MakeCommand(const std::string& agent_endpoint,
                              << container_local->status;
         }
     }
+    // drop the references, the capacity stays for the next report
+    report_containers_.clear();
 }
 
 bool Scheduler::RequireHasDiff(const Requirement* v1, const Requirement* v2) {
@@ -1495,12 +2356,35 @@ bool Scheduler::RequireHasDiff(const Requirement* v1, const Requirement* v2) {
     if (v1->max_per_host != v2->max_per_host) {
         return true;
     }
+    if (v1->gang != v2->gang || v1->gang_min != v2->gang_min
+        || v1->gang_timeout != v2->gang_timeout) {
+        return true;
+    }
+    if (v1->spreads.size() != v2->spreads.size()
+        || v1->anti_affinities.size() != v2->anti_affinities.size()) {
+        return true;
+    }
+    for (size_t i = 0; i < v1->spreads.size(); i++) {
+        if (v1->spreads[i].domain() != v2->spreads[i].domain()
+            || v1->spreads[i].max_per_domain() != v2->spreads[i].max_per_domain()) {
+            return true;
+        }
+    }
+    for (size_t i = 0; i < v1->anti_affinities.size(); i++) {
+        if (v1->anti_affinities[i].container_group_id() != v2->anti_affinities[i].container_group_id()
+            || v1->anti_affinities[i].domain() != v2->anti_affinities[i].domain()) {
+            return true;
+        }
+    }
     if (v1->cpu.size() != v2->cpu.size()) {
         return true;
     }
     for (size_t i = 0; i < v1->cpu.size(); i++) {
         if (v1->cpu[i].milli_core() != v2->cpu[i].milli_core() ||
-            v1->cpu[i].excess() != v2->cpu[i].excess()) {
+            v1->cpu[i].excess() != v2->cpu[i].excess() ||
+            v1->cpu[i].exclusive() != v2->cpu[i].exclusive() ||
+            v1->cpu[i].has_numa_node() != v2->cpu[i].has_numa_node() ||
+            v1->cpu[i].numa_node() != v2->cpu[i].numa_node()) {
             return true;
         }
     }
@@ -1602,6 +2486,14 @@ void Scheduler::SetVolumsAndPorts(const Container::Ptr& container,
             );
         }
     }
+    if (container->allocated_numa_node >= 0) {
+        for (int i = 0; i < container_desc.cgroups_size(); i++) {
+            proto::CpuRequired* cpu = container_desc.mutable_cgroups(i)->mutable_cpu();
+            if (cpu->exclusive()) {
+                cpu->set_numa_node(container->allocated_numa_node);
+            }
+        }
+    }
     container_desc.clear_volum_containers();
     for (size_t i = 0; i < container->allocated_volum_containers.size(); i++) {
         *container_desc.add_volum_containers() = container->allocated_volum_containers[i];
@@ -1632,12 +2524,14 @@ bool Scheduler::ListContainerGroups(std::vector<proto::ContainerGroupStatistics>
         group_stat.set_submit_time(container_group->submit_time);
         group_stat.set_update_time(container_group->update_time);
         group_stat.set_container_type(container_group->require->container_type);
+        std::vector<Container::Ptr> old_containers;
+        GetUpdateProgress(container_group, old_containers, *group_stat.mutable_update_progress());
         if (container_group->terminated) {
             group_stat.set_status(proto::kContainerGroupTerminated);
         } else {
             group_stat.set_status(proto::kContainerGroupNormal);
         }
-        std::map<ContainerId, Container::Ptr>::iterator jt;
+        ContainerMap::iterator jt;
         for (jt = container_group->containers.begin();
              jt != container_group->containers.end(); jt++) {
             //sum up all containers
@@ -1697,6 +2591,7 @@ bool Scheduler::ShowContainerGroup(const ContainerGroupId& container_group_id,
 void Scheduler::GetContainersStatistics(const ContainerMap& containers_map,
                                         std::vector<proto::ContainerStatistics>& containers) {
     mu_.AssertHeld();
+    size_t first = containers.size();
     BOOST_FOREACH(const ContainerMap::value_type& pair, containers_map) {
         Container::Ptr container = pair.second;
         proto::ContainerStatistics container_stat;
@@ -1740,6 +2635,8 @@ void Scheduler::GetContainersStatistics(const ContainerMap& containers_map,
         container_stat.mutable_memory()->set_used(memory_used);
         containers.push_back(container_stat);
     }
+    //the map is hashed, list them by id
+    std::sort(containers.begin() + first, containers.end(), ContainerIdLess);
 }
 
 bool Scheduler::ShowAgent(const AgentEndpoint& endpoint,
@@ -1758,32 +2655,47 @@ bool Scheduler::ShowAgent(const AgentEndpoint& endpoint,
 
 void Scheduler::ShowUserAlloc(const std::string& user_name, proto::Quota& alloc) {
     MutexLock lock(&mu_);
+    UserAlloc user_alloc;
+    std::map<std::string, UserAlloc>::const_iterator it = user_allocs_.find(user_name);
+    if (it != user_allocs_.end()) {
+        user_alloc = it->second;
+    }
+    alloc.set_millicore(user_alloc.millicore);
+    alloc.set_memory(user_alloc.memory);
+    alloc.set_replica(user_alloc.replica);
+    alloc.set_disk(user_alloc.disk);
+    alloc.set_ssd(user_alloc.ssd);
+}
+
+bool Scheduler::CheckUserAllocs(std::string& diff) {
+    MutexLock lock(&mu_);
+    std::map<std::string, UserAlloc> scanned;
     std::map<ContainerGroupId, ContainerGroup::Ptr>::iterator it;
-    int64_t cpu_alloc = 0; //for one user
-    int64_t memory_alloc = 0;
-    int64_t ssd_alloc = 0;
-    int64_t disk_alloc = 0;
-    int64_t replica_alloc = 0;
     for (it = container_groups_.begin(); it != container_groups_.end(); it++) {
-        const ContainerGroup::Ptr& container_group = it->second;
-        if (container_group->user_name != user_name) {
-            continue;
-        }
-        int64_t replica = container_group->Replica();
-        replica_alloc +=  replica;
-        if (container_group->priority != proto::kJobBestEffort) {
-            cpu_alloc += container_group->require->CpuNeed() * replica;
-            memory_alloc += container_group->require->MemoryNeed() * replica;
-        }
-        memory_alloc += container_group->require->TmpfsNeed() * replica;
-        disk_alloc += container_group->require->DiskNeed() * replica;
-        ssd_alloc += container_group->require->SsdNeed() * replica;
+        scanned[it->second->user_name].Add(GroupAlloc(it->second), 1);
     }
-    alloc.set_millicore(cpu_alloc);
-    alloc.set_memory(memory_alloc);
-    alloc.set_replica(replica_alloc);
-    alloc.set_disk(disk_alloc);
-    alloc.set_ssd(ssd_alloc);
+    std::set<std::string> users;
+    std::map<std::string, UserAlloc>::iterator jt;
+    for (jt = scanned.begin(); jt != scanned.end(); jt++) {
+        users.insert(jt->first);
+    }
+    for (jt = user_allocs_.begin(); jt != user_allocs_.end(); jt++) {
+        users.insert(jt->first);
+    }
+    std::stringstream ss;
+    BOOST_FOREACH(const std::string& user, users) {
+        const UserAlloc& expect = scanned[user];
+        const UserAlloc& got = user_allocs_[user];
+        if (!(expect == got)) {
+            ss << user << " scanned[cpu/mem/disk/ssd/replica]: "
+               << expect.millicore << "," << expect.memory << "," << expect.disk
+               << "," << expect.ssd << "," << expect.replica
+               << " ledger: " << got.millicore << "," << got.memory << "," << got.disk
+               << "," << got.ssd << "," << got.replica << "; ";
+        }
+    }
+    diff = ss.str();
+    return diff.empty();
 }
 
 std::string Scheduler::GetNewVersion() {
@@ -1799,6 +2711,34 @@ std::string Scheduler::GetNewVersion() {
     return ss.str();
 }
 
+void Scheduler::AddContainerGroup(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    if (container_group->handle == 0) {
+        container_group->handle = group_slots_.size();
+        group_slots_.push_back(container_group);
+    }
+    group_handles_[container_group->id] = container_group->handle;
+    container_groups_[container_group->id] = container_group;
+    Enqueue(container_group);
+}
+
+void Scheduler::RemoveContainerGroup(ContainerGroup::Ptr container_group) {
+    mu_.AssertHeld();
+    group_handles_.erase(container_group->id);
+    group_slots_[container_group->handle].reset();
+    container_groups_.erase(container_group->id);
+    updating_groups_.erase(container_group->id);
+    Dequeue(container_group);
+}
+
+ContainerGroup::Ptr Scheduler::GroupOf(const Container::Ptr& container) {
+    mu_.AssertHeld();
+    if (container->group_handle >= group_slots_.size()) {
+        return ContainerGroup::Ptr();
+    }
+    return group_slots_[container->group_handle];
+}
+
 void Scheduler::MetaToQuota(const proto::ContainerGroupMeta& meta, proto::Quota& quota) {
     Requirement::Ptr require(new Requirement);
     SetRequirement(require, meta.desc());
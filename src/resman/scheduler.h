@@ -10,7 +10,10 @@
 #include <string>
 #include <utility>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include "src/protocol/galaxy.pb.h"
+#include "latency_histogram.h"
+#include "usage_model.h"
 #include "mutex.h"
 #include "thread_pool.h"
 
@@ -34,6 +37,11 @@ typedef std::string AgentEndpoint;
 typedef std::string ContainerGroupId;
 typedef std::string ContainerId;
 typedef std::string DevicePath;
+// dense number of a container group, handed out when the group is created
+// and never reused, 0 for none. Per agent counters are keyed by it and
+// group ids stay at the rpc boundary.
+typedef uint32_t GroupHandle;
+typedef boost::unordered_map<ContainerGroupId, GroupHandle> GroupHandles;
 
 enum AgentCommandAction {
     kCreateContainer = 0,
@@ -59,23 +67,40 @@ struct Requirement {
     std::vector<proto::TcpthrotRequired> tcp_throts;
     std::vector<proto::BlkioRequired> blkios;
     std::vector<std::string> volum_jobs;
+    std::vector<proto::TopologySpread> spreads;
+    std::vector<proto::AntiAffinity> anti_affinities;
     proto::ContainerType container_type;
-    Requirement() : max_per_host(0) , container_type(proto::kNormalContainer) {};
-    int64_t CpuNeed() {
+    bool gang;
+    int gang_min;
+    int gang_timeout;
+    Requirement() : max_per_host(0) , container_type(proto::kNormalContainer),
+                    gang(false), gang_min(0), gang_timeout(0) {};
+    int64_t CpuNeed() const {
         int64_t total = 0;
         for (size_t i = 0; i < cpu.size(); i++) {
             total += cpu[i].milli_core();
         }
         return total;
     }
-    int64_t MemoryNeed() {
+    // millicores planned against the shared cores, exclusive cgroups
+    // take whole cores of a numa node instead
+    int64_t SharedCpuNeed() const {
+        int64_t total = 0;
+        for (size_t i = 0; i < cpu.size(); i++) {
+            if (!cpu[i].exclusive()) {
+                total += cpu[i].milli_core();
+            }
+        }
+        return total;
+    }
+    int64_t MemoryNeed() const {
         int64_t total = 0;
         for (size_t i = 0; i < memory.size(); i++) {
             total += memory[i].size();
         }
         return total;
     }
-    int64_t DiskNeed() {
+    int64_t DiskNeed() const {
         int64_t total = 0;
         for (size_t i = 0; i < volums.size(); i++) {
             if (volums[i].medium() == proto::kDisk) {
@@ -84,7 +109,7 @@ struct Requirement {
         }
         return total;
     }
-    int64_t SsdNeed() {
+    int64_t SsdNeed() const {
         int64_t total = 0;
         for (size_t i = 0; i < volums.size(); i++) {
             if (volums[i].medium() == proto::kSsd) {
@@ -93,7 +118,17 @@ struct Requirement {
         }
         return total;
     }
-    int64_t TmpfsNeed() {
+    // whole cores of the exclusive cgroups, all taken from one numa node
+    int32_t ExclusiveCoresNeed() const {
+        int32_t total = 0;
+        for (size_t i = 0; i < cpu.size(); i++) {
+            if (cpu[i].exclusive()) {
+                total += (cpu[i].milli_core() + 999) / 1000;
+            }
+        }
+        return total;
+    }
+    int64_t TmpfsNeed() const {
         int64_t total = 0;
         for (size_t i = 0; i < volums.size(); i++) {
             if (volums[i].medium() == proto::kTmpfs) {
@@ -115,6 +150,7 @@ struct VolumInfo {
 struct Container {
     ContainerId id;
     ContainerGroupId container_group_id;
+    GroupHandle group_handle;
     int priority;
     proto::ContainerStatus status;
     Requirement::Ptr require;
@@ -124,7 +160,19 @@ struct Container {
     ResourceError last_res_err;
     proto::ContainerInfo remote_info;
     std::vector<ContainerId> allocated_volum_containers;
-    Container() : priority(proto::kJobService), status(kContainerPending), last_res_err(proto::kResOk) {}
+    int32_t allocated_numa_node;
+    // status in the latest report of its agent, 0 when it is not reported
+    ContainerStatus reported_status;
+    // index in the status bucket of its group, -1 when in none
+    int32_t bucket_slot;
+    // when it turned pending last time, in us
+    int64_t pending_since;
+    // usage in the reports since it was placed
+    UsageModel cpu_usage;
+    UsageModel memory_usage;
+    Container() : group_handle(0), priority(proto::kJobService), status(kContainerPending),
+                  last_res_err(proto::kResOk), allocated_numa_node(-1),
+                  reported_status(ContainerStatus()), bucket_slot(-1), pending_since(0) {}
     typedef boost::shared_ptr<Container> Ptr;
 };
 
@@ -134,15 +182,86 @@ struct ContainerPriorityLess{
     }
 };
 
-typedef std::map<ContainerId, Container::Ptr> ContainerMap;
+typedef boost::unordered_map<ContainerId, Container::Ptr> ContainerMap;
+
+// Containers of a group in one status. A container keeps its slot, so
+// moving it to another status swaps the last one into the hole, without a
+// lookup or an allocation. The order in a bucket is not kept.
+class ContainerBucket {
+public:
+    typedef std::vector<Container::Ptr>::const_iterator iterator;
+    typedef std::vector<Container::Ptr>::const_iterator const_iterator;
+    void Add(const Container::Ptr& container) {
+        container->bucket_slot = items_.size();
+        items_.push_back(container);
+    }
+    void Remove(const Container::Ptr& container) {
+        int32_t slot = container->bucket_slot;
+        if (slot < 0 || slot >= (int32_t)items_.size() || items_[slot] != container) {
+            return;
+        }
+        items_[slot] = items_.back();
+        items_[slot]->bucket_slot = slot;
+        items_.pop_back();
+        container->bucket_slot = -1;
+    }
+    size_t size() const {
+        return items_.size();
+    }
+    bool empty() const {
+        return items_.empty();
+    }
+    const Container::Ptr& operator[](size_t i) const {
+        return items_[i];
+    }
+    const_iterator begin() const {
+        return items_.begin();
+    }
+    const_iterator end() const {
+        return items_.end();
+    }
+    // copy it to walk the bucket while statuses change
+    const std::vector<Container::Ptr>& Items() const {
+        return items_;
+    }
+private:
+    std::vector<Container::Ptr> items_;
+};
+
+// resources charged to the quota of a user
+struct UserAlloc {
+    int64_t millicore;
+    int64_t memory;
+    int64_t disk;
+    int64_t ssd;
+    int64_t replica;
+    UserAlloc() : millicore(0), memory(0), disk(0), ssd(0), replica(0) {}
+    void Add(const UserAlloc& other, int sign) {
+        millicore += sign * other.millicore;
+        memory += sign * other.memory;
+        disk += sign * other.disk;
+        ssd += sign * other.ssd;
+        replica += sign * other.replica;
+    }
+    bool operator==(const UserAlloc& other) const {
+        return millicore == other.millicore && memory == other.memory
+               && disk == other.disk && ssd == other.ssd
+               && replica == other.replica;
+    }
+};
+
+typedef boost::unordered_map<GroupHandle, int> GroupCounts;
+// topology label, eg: rack:r12 -> containers of each group under the label
+typedef boost::unordered_map<std::string, GroupCounts> DomainCounts;
 
 struct ContainerGroup {
     ContainerGroupId id;
+    GroupHandle handle;
     Requirement::Ptr require;
     int priority; //lower one is important
     bool terminated;
-    std::map<ContainerId, Container::Ptr> containers;
-    std::map<ContainerId, Container::Ptr> states[8];
+    ContainerMap containers;
+    ContainerBucket states[8];
     int update_interval;
     int last_update_time;
     int replica;
@@ -151,14 +270,37 @@ struct ContainerGroup {
     proto::ContainerDescription container_desc;
     int64_t submit_time;
     int64_t update_time;
-    std::string last_sched_container_id;
-    ContainerGroup() : priority(kJobService),
+    // next pending slot to try, the round robin of ScheduleNextAgent
+    size_t sched_cursor;
+    // budgets of the rolling update, in containers
+    int max_surge;
+    int max_unavailable;
+    bool update_paused;
+    // since when a gang stays below its quorum, 0 for not waiting
+    int gang_wait_since;
+    // passes in a row the gang missed its quorum, and passes left to skip
+    // before it reserves again
+    int gang_failures;
+    int gang_skip;
+    // what the group is charged in the ledger of its user
+    UserAlloc alloc;
+    // pools whose queues hold the group
+    std::set<std::string> queued_pools;
+    ContainerGroup() : handle(0),
+                       priority(kJobService),
                        terminated(false),
                        update_interval(0),
                        last_update_time(0),
                        replica(0),
                        submit_time(0),
-                       update_time(0) {};
+                       update_time(0),
+                       sched_cursor(0),
+                       max_surge(0),
+                       max_unavailable(1),
+                       update_paused(false),
+                       gang_wait_since(0),
+                       gang_failures(0),
+                       gang_skip(0) {};
     int Replica() const {
         return states[kContainerPending].size()
                + states[kContainerAllocating].size()
@@ -182,16 +324,30 @@ public:
                        int64_t memory_deep_assigned,
                        const std::map<DevicePath, VolumInfo>& volum_assigned,
                        const std::set<std::string> port_assigned,
-                       const std::map<ContainerId, Container::Ptr>& containers);
+                       const ContainerMap& containers);
     void SetReserved(int64_t cpu_reserved,
                      int64_t cpu_deep_reserved,
                      int64_t memory_reserved,
                      int64_t memory_deep_reserved);
+    // numa node -> cores can be dedicated
+    void SetNumaCores(const std::map<int32_t, int32_t>& numa_cores);
     bool TryPut(const Container* container, ResourceError& err);
+    // the resource part of TryPut against the ledger only, callable
+    // without Scheduler::mu_. ledger_version tells the ledger it was done on
+    bool TryFit(const Requirement* require, int priority,
+                ResourceError& err, int64_t& ledger_version);
     void Put(Container::Ptr container);
     void Evict(Container::Ptr container);
+    // tags like domain:label are the topology labels of the agent
+    void SetTags(const std::set<std::string>& tags);
     typedef boost::shared_ptr<Agent> Ptr;
 private:
+    void CountDomains(GroupHandle group_handle, int delta);
+    int DomainCount(const std::string& label, GroupHandle group_handle);
+    // 0 for a group unknown to the scheduler
+    GroupHandle FindGroupHandle(const ContainerGroupId& container_group_id);
+    // group of a container on this agent, 0 when it is not here
+    GroupHandle GroupOf(const ContainerId& container_id);
     bool SelectDevices(const std::vector<proto::VolumRequired>& volums,
                        std::vector<DevicePath>& devices);
     bool RecurSelectDevices(size_t i, const std::vector<proto::VolumRequired>& volums,
@@ -202,7 +358,13 @@ private:
                          std::vector<std::string>& ports_free);
     bool SelectFreeVolumContainers(const std::vector<ContainerGroupId>& volum_jobs,
                                    std::vector<ContainerId>& volum_containers);
-    ContainerGroupId ExtractGroupId(const ContainerId& container_id);
+    bool SelectNumaNode(int32_t cores, int32_t& node);
+    // TryPut but the resources: tags, pools, spreads and volum jobs
+    bool CheckPlacement(const Container* container, ResourceError& err);
+    bool FitResources(const Requirement* require, int priority, ResourceError& err);
+    // the ledger below is written holding both Scheduler::mu_ and mu_,
+    // read holding either
+    Mutex mu_;
     AgentEndpoint endpoint_;
     std::set<std::string> tags_;
     std::string pool_name_;
@@ -220,10 +382,19 @@ private:
     std::map<DevicePath, VolumInfo> volum_assigned_;
     std::set<std::string> port_assigned_;
     size_t port_total_;
-    std::map<ContainerId, Container::Ptr> containers_;
-    std::map<ContainerGroupId, int> container_counts_;
-    std::map<ContainerGroupId, std::set<ContainerId> > volum_jobs_free_;
+    ContainerMap containers_;
+    boost::unordered_map<GroupHandle, int> container_counts_;
+    boost::unordered_map<GroupHandle, std::set<ContainerId> > volum_jobs_free_;
     int32_t batch_container_count_;
+    // bumped by every write to the ledger
+    int64_t ledger_version_;
+    std::map<int32_t, int32_t> numa_cores_total_;
+    std::map<int32_t, int32_t> numa_cores_assigned_;
+    // domain -> topology label of the agent
+    std::map<std::string, std::string> topology_;
+    // shared by all agents of the scheduler, NULL before being added
+    DomainCounts* domain_counts_;
+    const GroupHandles* group_handles_;
 };
 
 struct ContainerGroupQueueLess {
@@ -238,6 +409,26 @@ struct ContainerGroupQueueLess {
     }
 };
 
+typedef std::set<ContainerGroup::Ptr, ContainerGroupQueueLess> ContainerGroupQueue;
+
+// Agents of a pool and the groups asking for it. Every pool is swept by a
+// thread of its own, which fits the containers on an agent under the lock
+// of the agent, but picks and puts them under Scheduler::mu_. The pools so
+// interleave on mu_ rather than schedule in parallel, a pool full of pending
+// batch containers only stretches its own rounds.
+struct SchedPool {
+    std::string name;
+    // agents and queue are written holding both Scheduler::mu_ and mu,
+    // read holding either
+    Mutex mu;
+    std::map<AgentEndpoint, Agent::Ptr> agents;
+    ContainerGroupQueue queue;
+    bool started;
+    ThreadPool sched_pool;
+    SchedPool() : started(false), sched_pool(1) {}
+    typedef boost::shared_ptr<SchedPool> Ptr;
+};
+
 class Scheduler {
 public:
     explicit Scheduler();
@@ -261,10 +452,19 @@ public:
 
     // @update_interval :
     //      --- intervals between updateing two containers, in seconds
+    // @max_surge :
+    //      --- new containers can be started above the replica
+    // @max_unavailable :
+    //      --- ready containers can be missing below the replica
     bool Update(const ContainerGroupId& container_group_id,
                 const proto::ContainerDescription& container_desc,
                 int update_interval,
+                int max_surge,
+                int max_unavailable,
                 std::string& new_version);
+    bool PauseUpdate(const ContainerGroupId& container_group_id, bool paused);
+    bool ShowUpdateProgress(const ContainerGroupId& container_group_id,
+                            proto::UpdateProgress& progress);
     void AddTag(const AgentEndpoint& endpoint, const std::string& tag);
     void RemoveTag(const AgentEndpoint& endpoint, const std::string& tag);
     void SetPool(const AgentEndpoint& endpoint, const std::string& pool_name);
@@ -279,6 +479,8 @@ public:
     void GetContainersStatistics(const ContainerMap& containers_map,
                                  std::vector<proto::ContainerStatistics>& containers);
     void ShowUserAlloc(const std::string& user_name, proto::Quota& alloc);
+    // compares the ledger of users with a full scan of the container groups
+    bool CheckUserAllocs(std::string& diff);
     bool ChangeStatus(const ContainerGroupId& container_group_id,
                       const ContainerId& container_id,
                       ContainerStatus new_status);
@@ -296,9 +498,41 @@ private:
 
     ContainerGroupId GenerateContainerGroupId(const std::string& container_group_name);
     ContainerId GenerateContainerId(const ContainerGroupId& container_group_id, int offset);
-    void ScheduleNextAgent(AgentEndpoint pre_endpoint);
+    void ScheduleNextAgent(SchedPool* pool, AgentEndpoint pre_endpoint);
+    SchedPool::Ptr GetPool(const std::string& pool_name);
+    void StartPool(SchedPool::Ptr pool);
+    void JoinPool(Agent::Ptr agent);
+    void LeavePool(Agent::Ptr agent);
+    // the queue of the scheduler and those of the pools asked for
+    void Enqueue(ContainerGroup::Ptr container_group);
+    void Dequeue(ContainerGroup::Ptr container_group);
+    void SetResError(Container::Ptr container, ResourceError res_err);
+    // capacity of the agent changed, or the group has new pending containers
+    void MarkAgentDirty(const AgentEndpoint& endpoint);
+    void MarkGroupDirty(ContainerGroup::Ptr container_group);
+    void WakeDirtyWorker();
+    void ScheduleDirty();
+    // puts pending containers of the group on the agent until one does not fit
+    int PlaceOn(Agent::Ptr agent, ContainerGroup::Ptr container_group, int64_t event_time);
+    void ReportLatency();
     void CheckTagAndPool(Agent::Ptr agent);
     void CheckVersion(Agent::Ptr agent);
+    void CheckUpdateRoutine();
+    // false once the group has no old containers left, or is terminated
+    bool RollingUpdate(ContainerGroup::Ptr container_group);
+    void GetUpdateProgress(ContainerGroup::Ptr container_group,
+                           std::vector<Container::Ptr>& old_containers,
+                           proto::UpdateProgress& progress);
+    void AddSurgeContainer(ContainerGroup::Ptr container_group);
+    void ChargeUser(ContainerGroup::Ptr container_group);
+    void UnchargeUser(ContainerGroup::Ptr container_group);
+    UserAlloc GroupAlloc(ContainerGroup::Ptr container_group);
+    void GangScheduleRoutine();
+    void GangSchedule(ContainerGroup::Ptr container_group);
+    // false when the quorum is out of reach, its reservations given back
+    bool ReserveGang(ContainerGroup::Ptr container_group,
+                     const std::vector<Container::Ptr>& pending_containers,
+                     int live, int quorum);
     bool CheckTagAndPoolOnce(Agent::Ptr agent, Container::Ptr container);
     void CheckContainerGroupGC(ContainerGroup::Ptr container_group);
     bool RequireHasDiff(const Requirement* v1, const Requirement* v2);
@@ -307,12 +541,41 @@ private:
     void SetVolumsAndPorts(const Container::Ptr& container,
                            proto::ContainerDescription& container_desc);
     std::string GetNewVersion();
+    void AddContainerGroup(ContainerGroup::Ptr container_group);
+    void RemoveContainerGroup(ContainerGroup::Ptr container_group);
+    ContainerGroup::Ptr GroupOf(const Container::Ptr& container);
     std::map<AgentEndpoint, Agent::Ptr> agents_;
     std::map<ContainerGroupId, ContainerGroup::Ptr> container_groups_;
-    std::set<ContainerGroup::Ptr, ContainerGroupQueueLess> container_group_queue_;
+    // groups which may still have containers of old versions, the only ones
+    // CheckUpdateRoutine looks at
+    std::set<ContainerGroupId> updating_groups_;
+    ContainerGroupQueue container_group_queue_;
+    GroupHandles group_handles_;
+    // indexed by GroupHandle, NULL for collected groups
+    std::vector<ContainerGroup::Ptr> group_slots_;
+    DomainCounts domain_counts_;
+    // user name -> resources of the user's live containers, kept along with
+    // every status or requirement change, so quota checks do not scan groups
+    std::map<std::string, UserAlloc> user_allocs_;
     Mutex mu_;
+    // containers of the agent whose report is being handled, reused across
+    // reports to save the allocations, guarded by mu_
+    std::vector<Container::Ptr> report_containers_;
+    // touched by events since the last ScheduleDirty, valued by the time
+    // of the first event in us
+    std::map<AgentEndpoint, int64_t> dirty_agents_;
+    std::map<GroupHandle, int64_t> dirty_groups_;
+    bool dirty_scheduled_;
+    // event to placement of the containers placed by ScheduleDirty
+    LatencyHistogram event_latency_;
+    // pending to placement of all containers
+    LatencyHistogram pending_latency_;
+    int64_t last_latency_report_;
+    // created when an agent or a group names the pool first, never removed
+    std::map<std::string, SchedPool::Ptr> pools_;
     ThreadPool sched_pool_;
     ThreadPool gc_pool_;
+    ThreadPool update_pool_;
     bool stop_;
 };
 
@@ -0,0 +1,66 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "usage_model.h"
+
+#include <algorithm>
+#include <vector>
+#include <gflags/gflags.h>
+
+DECLARE_double(reserved_percent);
+DECLARE_double(usage_ewma_alpha);
+DECLARE_int32(usage_window);
+DECLARE_int32(usage_percentile);
+
+namespace baidu {
+namespace galaxy {
+namespace sched {
+
+UsageModel::UsageModel() : ewma_(0.0), samples_(0) {
+}
+
+void UsageModel::Add(int64_t used) {
+    double alpha = std::min(std::max(FLAGS_usage_ewma_alpha, 0.0), 1.0);
+    if (samples_ == 0) {
+        ewma_ = used;
+    } else {
+        ewma_ = alpha * used + (1.0 - alpha) * ewma_;
+    }
+    samples_++;
+    window_.push_back(used);
+    while ((int32_t)window_.size() > std::max(FLAGS_usage_window, 1)) {
+        window_.pop_front();
+    }
+}
+
+void UsageModel::Clear() {
+    ewma_ = 0.0;
+    window_.clear();
+    samples_ = 0;
+}
+
+int64_t UsageModel::Samples() const {
+    return samples_;
+}
+
+int64_t UsageModel::Predict() const {
+    if (window_.empty()) {
+        return 0;
+    }
+    int32_t percentile = std::min(std::max(FLAGS_usage_percentile, 0), 100);
+    std::vector<int64_t> sorted(window_.begin(), window_.end());
+    size_t rank = (sorted.size() - 1) * percentile / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return std::max(static_cast<int64_t>(ewma_ + 0.5), sorted[rank]);
+}
+
+int64_t UsageModel::Reserve(int64_t need) const {
+    if (samples_ == 0) {
+        return need;
+    }
+    return std::min(static_cast<int64_t>(Predict() * FLAGS_reserved_percent), need);
+}
+
+} //namespace sched
+} //namespace galaxy
+} //namespace baidu
@@ -0,0 +1,37 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+
+namespace baidu {
+namespace galaxy {
+namespace sched {
+
+// Recent usage of one resource of a container, fed by the reports of its
+// agent. The EWMA follows the trend, a high percentile of the last samples
+// keeps the spikes, and the reservation is planned for the larger one.
+class UsageModel {
+public:
+    UsageModel();
+    void Add(int64_t used);
+    void Clear();
+    int64_t Samples() const;
+    // 0 before the first sample
+    int64_t Predict() const;
+    // what a placed container holds back from best effort work, all it
+    // needs before anything is known about it
+    int64_t Reserve(int64_t need) const;
+
+private:
+    double ewma_;
+    std::deque<int64_t> window_;
+    int64_t samples_;
+};
+
+} //namespace sched
+} //namespace galaxy
+} //namespace baidu
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <assert.h>
+#include <algorithm>
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
 #include <glog/logging.h>
@@ -24,10 +25,18 @@ public:
         sofa::pbrpc::RpcClientOptions options;
         options.max_pending_buffer_size = 128;
         _rpc_client = new sofa::pbrpc::RpcClient(options);
+        _retry_backoff_ms = 1000;
+        _max_retry_backoff_ms = 1000;
     }
     ~RpcClient() {
         delete _rpc_client;
     }
+    // interval before the first retry of SendRequest, doubled on every
+    // further retry until max_backoff_ms
+    void SetRetryBackoff(int32_t backoff_ms, int32_t max_backoff_ms) {
+        _retry_backoff_ms = backoff_ms;
+        _max_retry_backoff_ms = max_backoff_ms < backoff_ms ? backoff_ms : max_backoff_ms;
+    }
     template <class T>
     bool GetStub(const std::string server, T** stub) {
         MutexLock lock(&_host_map_lock);
@@ -54,12 +63,14 @@ public:
         //  controller ڿƱεã趨ʱʱ䣨ҲԲãȱʡΪ10s
         sofa::pbrpc::RpcController controller;
         controller.SetTimeout(rpc_timeout * 1000L);
+        int64_t backoff_ms = _retry_backoff_ms;
         for (int32_t retry = 0; retry < retry_times; ++retry) {
             (stub->*func)(&controller, request, response, NULL);
             if (controller.Failed()) {
                 if (retry < retry_times - 1) {
-                    LOG(INFO) << "Send failed, retry ...";
-                    usleep(1000000);
+                    LOG(INFO) << "Send failed, retry after " << backoff_ms << "ms ...";
+                    usleep(backoff_ms * 1000);
+                    backoff_ms = std::min<int64_t>(backoff_ms * 2, _max_retry_backoff_ms);
                 } else {
                     LOG(WARNING) <<  "SendRequest fail: " << controller.ErrorText().c_str();
                 }
@@ -108,6 +119,8 @@ private:
     typedef std::map<std::string, sofa::pbrpc::RpcChannel*> HostMap;
     HostMap _host_map;
     Mutex _host_map_lock;
+    int32_t _retry_backoff_ms;
+    int32_t _max_retry_backoff_ms;
 };
 
 } // namespace galaxy
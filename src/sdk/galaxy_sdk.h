@@ -90,8 +90,14 @@ struct Volum {
 };
 
 struct CpuRequired {
+    CpuRequired() :
+        milli_core(0),
+        excess(false),
+        exclusive(false) {}
+
     int64_t milli_core;
     bool excess;
+    bool exclusive; // dedicated whole cores on one numa node
 };
 struct MemoryRequired {
     MemoryRequired() :
@@ -111,7 +117,14 @@ struct TcpthrotRequired {
     bool send_bps_excess;
 };
 struct BlkioRequired {
+    BlkioRequired() :
+        weight(0),
+        read_bps_limit(0),
+        write_bps_limit(0) {}
+
     int32_t weight;
+    int64_t read_bps_limit;
+    int64_t write_bps_limit;
 };
 struct PortRequired {
     std::string port_name;
@@ -178,6 +191,21 @@ struct Package {
     std::string dest_path;
     std::string version;
 };
+enum ProbeType {
+    kProbeNone = 0,
+    kProbeTcp = 1,
+    kProbeHttp = 2,
+};
+struct HealthProbe {
+    HealthProbe() :
+        type(kProbeNone),
+        timeout(0) {}
+
+    ProbeType type;
+    std::string port; //port name of the task or a port number
+    std::string path; //http only
+    int32_t timeout;  //ms
+};
 struct ImagePackage {
     ImagePackage() :
         stop_timeout(30) {}
@@ -187,18 +215,33 @@ struct ImagePackage {
     std::string stop_cmd;
     int32_t stop_timeout;
     std::string health_cmd;
+    HealthProbe health_probe;
 };
 struct DataPackage {
     std::vector<Package> packages;
     std::string reload_cmd;
 };
+struct TopologySpread {
+    TopologySpread() : max_per_domain(0) {}
+    std::string domain;
+    int32_t max_per_domain;
+};
+struct AntiAffinity {
+    std::string container_group_id;
+    std::string domain; // host only when empty
+};
 struct Deploy {
     Deploy() : replica(1),
     step(1),
     interval(1),
     max_per_host(1),
     update_break_count(1),
-    stop_timeout(30) {
+    stop_timeout(30),
+    max_surge(0),
+    max_unavailable(1),
+    gang(false),
+    gang_min(0),
+    gang_timeout(300) {
     }
 
     uint32_t replica;
@@ -209,6 +252,13 @@ struct Deploy {
     std::vector<std::string> pools;
     uint32_t update_break_count;
     uint32_t stop_timeout;
+    uint32_t max_surge;
+    uint32_t max_unavailable;
+    std::vector<TopologySpread> spreads;
+    std::vector<AntiAffinity> anti_affinities;
+    bool gang;
+    uint32_t gang_min;
+    int32_t gang_timeout;
 };
 struct Service {
     std::string service_name;
@@ -272,6 +322,8 @@ struct ContainerDescription {
     std::vector<std::string> pool_names;
     std::vector<std::string> volum_jobs; //dependent volum jobs' id 
     ContainerType container_type;
+    std::vector<TopologySpread> spreads;
+    std::vector<AntiAffinity> anti_affinities;
 };
 enum ContainerStatus {
     kContainerPending = 1,
@@ -304,6 +356,20 @@ struct ErrorCode {
     Status status;
     std::string reason;
 };
+struct RpcOptions {
+    RpcOptions() :
+        timeout(5),
+        retry_times(1),
+        retry_backoff_ms(1000),
+        max_retry_backoff_ms(1000),
+        max_inflight(8) {}
+
+    int32_t timeout;              // seconds, per attempt
+    int32_t retry_times;
+    int32_t retry_backoff_ms;     // doubled per retry, up to max_retry_backoff_ms
+    int32_t max_retry_backoff_ms;
+    int32_t max_inflight;         // async requests running at the same time
+};
 enum AgentStatus {
     kAgentUnknown = 0,
     kAgentAlive = 1,
@@ -519,11 +585,16 @@ struct RemoveContainerGroupResponse {
     ErrorCode error_code;
 };
 struct UpdateContainerGroupRequest {
+    UpdateContainerGroupRequest() : max_surge(0),
+    max_unavailable(1) {
+    }
     User user;
     uint32_t replica;
     std::string id;
     uint32_t interval;
     ContainerDescription desc;
+    uint32_t max_surge;
+    uint32_t max_unavailable;
 };
 struct UpdateContainerGroupResponse {
     ErrorCode error_code;
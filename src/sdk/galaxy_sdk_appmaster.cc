@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "galaxy_sdk_util.h"
+#include "galaxy_sdk_async.h"
 #include "rpc/rpc_client.h"
 #include "ins_sdk.h"
 #include <gflags/gflags.h>
@@ -19,14 +20,19 @@ AppMaster::~AppMaster() {
 
 class AppMasterImpl : public AppMaster {
 public:
-    AppMasterImpl(const std::string& nexus_addr, const std::string& path) : rpc_client_(NULL),
-                      appmaster_stub_(NULL) {
+    AppMasterImpl(const std::string& nexus_addr, const std::string& path,
+                  const RpcOptions& options) : rpc_client_(NULL),
+                      appmaster_stub_(NULL),
+                      options_(options),
+                      async_(options.max_inflight) {
         full_key_ = path;
         rpc_client_ = new RpcClient();
+        rpc_client_->SetRetryBackoff(options.retry_backoff_ms, options.max_retry_backoff_ms);
         nexus_ = new ::galaxy::ins::sdk::InsSDK(nexus_addr);
     }
 
     virtual ~AppMasterImpl() {
+        async_.Stop();
         delete rpc_client_;
         if (NULL != appmaster_stub_) {
             delete appmaster_stub_;
@@ -43,11 +49,17 @@ public:
     bool ShowJob(const ShowJobRequest& request, ShowJobResponse* response);
     bool RecoverInstance(const RecoverInstanceRequest& request, RecoverInstanceResponse* response);
     bool ExecuteCmd(const ExecuteCmdRequest& request, ExecuteCmdResponse* response);
+    void AsyncShowJob(const ShowJobRequest& request, const ShowJobCallback& callback);
+    void AsyncListJobs(const ListJobsRequest& request, const ListJobsCallback& callback);
+    int32_t BatchShowJob(const std::vector<ShowJobRequest>& requests,
+                         std::vector<ShowJobResponse>* responses);
 private:
     ::galaxy::ins::sdk::InsSDK* nexus_;
     ::baidu::galaxy::RpcClient* rpc_client_;
     ::baidu::galaxy::proto::AppMaster_Stub* appmaster_stub_;
     std::string full_key_;
+    RpcOptions options_;
+    AsyncCaller async_;
 
 };
 
@@ -88,7 +100,8 @@ bool AppMasterImpl::SubmitJob(const SubmitJobRequest& request, SubmitJobResponse
 
     bool ok = rpc_client_->SendRequest(appmaster_stub_,
                                         &::baidu::galaxy::proto::AppMaster_Stub::SubmitJob,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "AppMaster Rpc SendRequest failed";
         return false;
@@ -158,7 +171,8 @@ bool AppMasterImpl::UpdateJob(const UpdateJobRequest& request, UpdateJobResponse
 
     bool ok = rpc_client_->SendRequest(appmaster_stub_,
                                         &::baidu::galaxy::proto::AppMaster_Stub::UpdateJob,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "AppMaster Rpc SendRequest failed";
         return false;
@@ -197,7 +211,8 @@ bool AppMasterImpl::StopJob(const StopJobRequest& request, StopJobResponse* resp
 
     bool ok = rpc_client_->SendRequest(appmaster_stub_,
                                         &::baidu::galaxy::proto::AppMaster_Stub::StopJob,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "AppMaster Rpc SendRequest failed";
         return false;
@@ -234,7 +249,8 @@ bool AppMasterImpl::RemoveJob(const RemoveJobRequest& request, RemoveJobResponse
 
     bool ok = rpc_client_->SendRequest(appmaster_stub_,
                                         &::baidu::galaxy::proto::AppMaster_Stub::RemoveJob,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "AppMaster Rpc SendRequest failed";
         return false;
@@ -258,7 +274,8 @@ bool AppMasterImpl::ListJobs(const ListJobsRequest& request, ListJobsResponse* r
 
     bool ok = rpc_client_->SendRequest(appmaster_stub_,
                                         &::baidu::galaxy::proto::AppMaster_Stub::ListJobs,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "Appmaster Rpc SendRequest failed";
         return false;
@@ -306,7 +323,8 @@ bool AppMasterImpl::ShowJob(const ShowJobRequest& request, ShowJobResponse* resp
 
     bool ok = rpc_client_->SendRequest(appmaster_stub_,
                                         &::baidu::galaxy::proto::AppMaster_Stub::ShowJob,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "AppMaster Rpc SendRequest failed";
         return false;
@@ -372,7 +390,8 @@ bool AppMasterImpl::RecoverInstance(const RecoverInstanceRequest& request, Recov
 
     bool ok = rpc_client_->SendRequest(appmaster_stub_,
                                         &::baidu::galaxy::proto::AppMaster_Stub::RecoverInstance,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "AppMaster Rpc SendRequest failed";
         return false;
@@ -412,7 +431,8 @@ bool AppMasterImpl::ExecuteCmd(const ExecuteCmdRequest& request, ExecuteCmdRespo
 
     bool ok = rpc_client_->SendRequest(appmaster_stub_,
                                         &::baidu::galaxy::proto::AppMaster_Stub::ExecuteCmd,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "AppMaster Rpc SendRequest failed";
         return false;
@@ -427,8 +447,29 @@ bool AppMasterImpl::ExecuteCmd(const ExecuteCmdRequest& request, ExecuteCmdRespo
     return true;
 }
 
+void AppMasterImpl::AsyncShowJob(const ShowJobRequest& request, const ShowJobCallback& callback) {
+    async_.Call<ShowJobRequest, ShowJobResponse>(
+            boost::bind(&AppMasterImpl::ShowJob, this, _1, _2), request, callback);
+}
+
+void AppMasterImpl::AsyncListJobs(const ListJobsRequest& request, const ListJobsCallback& callback) {
+    async_.Call<ListJobsRequest, ListJobsResponse>(
+            boost::bind(&AppMasterImpl::ListJobs, this, _1, _2), request, callback);
+}
+
+int32_t AppMasterImpl::BatchShowJob(const std::vector<ShowJobRequest>& requests,
+                                    std::vector<ShowJobResponse>* responses) {
+    return async_.Gather<ShowJobRequest, ShowJobResponse>(
+            boost::bind(&AppMasterImpl::ShowJob, this, _1, _2), requests, responses);
+}
+
 AppMaster* AppMaster::ConnectAppMaster(const std::string& nexus_addr, const std::string& path) {
-    AppMasterImpl* appmaster = new AppMasterImpl(nexus_addr, path);
+    return ConnectAppMaster(nexus_addr, path, RpcOptions());
+}
+
+AppMaster* AppMaster::ConnectAppMaster(const std::string& nexus_addr, const std::string& path,
+                                       const RpcOptions& options) {
+    AppMasterImpl* appmaster = new AppMasterImpl(nexus_addr, path, options);
     if (!appmaster->GetStub()) {
         delete appmaster;
         return NULL;
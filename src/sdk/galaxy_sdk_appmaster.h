@@ -5,15 +5,21 @@
 #ifndef BAIDU_GALAXY_SDK_APPMASTER_H
 #define BAIDU_GALAXY_SDK_APPMASTER_H
 
+#include <boost/function.hpp>
 #include "galaxy_sdk.h"
 
 namespace baidu {
 namespace galaxy {
 namespace sdk {
 
+typedef boost::function<void (bool ok, const ShowJobResponse& response)> ShowJobCallback;
+typedef boost::function<void (bool ok, const ListJobsResponse& response)> ListJobsCallback;
+
 class AppMaster {
 public:
     static AppMaster* ConnectAppMaster(const std::string& nexus_addr, const std::string& path);
+    static AppMaster* ConnectAppMaster(const std::string& nexus_addr, const std::string& path,
+                                       const RpcOptions& options);
     virtual ~AppMaster() = 0;
     virtual bool SubmitJob(const SubmitJobRequest& request, SubmitJobResponse* response) = 0;
     virtual bool UpdateJob(const UpdateJobRequest& request, UpdateJobResponse* response) = 0;
@@ -23,6 +29,13 @@ public:
     virtual bool ShowJob(const ShowJobRequest& request, ShowJobResponse* response) = 0;
     virtual bool RecoverInstance(const RecoverInstanceRequest& request, RecoverInstanceResponse* response) = 0;
     virtual bool ExecuteCmd(const ExecuteCmdRequest& request, ExecuteCmdResponse* response) = 0;
+
+    //Async, callbacks run on an internal pool of RpcOptions.max_inflight threads
+    virtual void AsyncShowJob(const ShowJobRequest& request, const ShowJobCallback& callback) = 0;
+    virtual void AsyncListJobs(const ListJobsRequest& request, const ListJobsCallback& callback) = 0;
+    //Bulk, blocks until every request is answered, returns the number of successful calls
+    virtual int32_t BatchShowJob(const std::vector<ShowJobRequest>& requests,
+                                 std::vector<ShowJobResponse>* responses) = 0;
 };
 
 } //end namespace sdk
@@ -0,0 +1,140 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BAIDU_GALAXY_SDK_ASYNC_H
+#define BAIDU_GALAXY_SDK_ASYNC_H
+
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <mutex.h>
+#include <thread_pool.h>
+#include "galaxy_sdk.h"
+
+namespace baidu {
+namespace galaxy {
+namespace sdk {
+
+// Runs blocking sdk calls on a small pool so that up to max_inflight requests
+// share the rpc channel at the same time. The pool is created on first use,
+// so clients which only issue synchronous calls pay nothing for it.
+class AsyncCaller {
+public:
+    explicit AsyncCaller(int32_t max_inflight) :
+        max_inflight_(max_inflight > 0 ? max_inflight : 1) {
+    }
+
+    ~AsyncCaller() {
+        Stop();
+    }
+
+    // waits for the calls still queued so that no callback is dropped,
+    // owners call it before tearing down what the calls depend on. the pool
+    // is joined out of mutex_, a callback issuing another call gets a new one
+    void Stop() {
+        boost::scoped_ptr<ThreadPool> pool;
+        {
+            MutexLock lock(&mutex_);
+            pool_.swap(pool);
+        }
+        if (pool.get() != NULL) {
+            pool->Stop(true);
+        }
+    }
+
+    template <class Request, class Response>
+    void Call(const boost::function<bool (const Request&, Response*)>& func,
+              const Request& request,
+              const boost::function<void (bool, const Response&)>& callback) {
+        Pool()->AddTask(boost::bind(&AsyncCaller::Run<Request, Response>,
+                                    func, request, callback));
+    }
+
+    // fans out one call per request and blocks until all of them are back,
+    // responses[i] answers requests[i] and error_code.status is kOk only for
+    // calls that succeeded. returns the number of successful calls
+    template <class Request, class Response>
+    int32_t Gather(const boost::function<bool (const Request&, Response*)>& func,
+                   const std::vector<Request>& requests,
+                   std::vector<Response>* responses) {
+        responses->clear();
+        responses->resize(requests.size());
+        if (requests.empty()) {
+            return 0;
+        }
+
+        GatherState state(requests.size());
+        for (size_t i = 0; i < requests.size(); i++) {
+            (*responses)[i].error_code.status = kError;
+            Pool()->AddTask(boost::bind(&AsyncCaller::RunGathered<Request, Response>,
+                                        func, &requests[i], &(*responses)[i], &state));
+        }
+
+        MutexLock lock(&state.mutex);
+        while (state.pending > 0) {
+            state.cond.Wait();
+        }
+        return state.succeeded;
+    }
+
+private:
+    struct GatherState {
+        explicit GatherState(size_t n) :
+            cond(&mutex),
+            pending(n),
+            succeeded(0) {}
+        Mutex mutex;
+        CondVar cond;
+        size_t pending;
+        int32_t succeeded;
+    };
+
+    ThreadPool* Pool() {
+        MutexLock lock(&mutex_);
+        if (pool_.get() == NULL) {
+            pool_.reset(new ThreadPool(max_inflight_));
+        }
+        return pool_.get();
+    }
+
+    template <class Request, class Response>
+    static void Run(boost::function<bool (const Request&, Response*)> func,
+                    const Request request,
+                    boost::function<void (bool, const Response&)> callback) {
+        Response response;
+        response.error_code.status = kError;
+        bool ok = func(request, &response);
+        if (callback) {
+            callback(ok, response);
+        }
+    }
+
+    template <class Request, class Response>
+    static void RunGathered(boost::function<bool (const Request&, Response*)> func,
+                            const Request* request,
+                            Response* response,
+                            GatherState* state) {
+        bool ok = func(*request, response);
+        MutexLock lock(&state->mutex);
+        if (ok) {
+            state->succeeded++;
+        }
+        if (--state->pending == 0) {
+            state->cond.Signal();
+        }
+    }
+
+    int32_t max_inflight_;
+    Mutex mutex_;
+    boost::scoped_ptr<ThreadPool> pool_;
+};
+
+} // end namespace sdk
+} // end namespace galaxy
+} // end namespace baidu
+
+#endif  // BAIDU_GALAXY_SDK_ASYNC_H
+
+/* vim: set ts=4 sw=4 sts=4 tw=100 */
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "galaxy_sdk_util.h"
+#include "galaxy_sdk_async.h"
 #include "rpc/rpc_client.h"
 #include "ins_sdk.h"
 #include <gflags/gflags.h>
@@ -19,14 +20,19 @@ ResourceManager::~ResourceManager() {
 
 class ResourceManagerImpl : public ResourceManager {
 public:
-    ResourceManagerImpl(const std::string& nexus_addr, const std::string& path) : rpc_client_(NULL),
- 							res_stub_(NULL) {
+    ResourceManagerImpl(const std::string& nexus_addr, const std::string& path,
+                        const RpcOptions& options) : rpc_client_(NULL),
+ 							res_stub_(NULL),
+                            options_(options),
+                            async_(options.max_inflight) {
 	    rpc_client_ = new ::baidu::galaxy::RpcClient();
+        rpc_client_->SetRetryBackoff(options.retry_backoff_ms, options.max_retry_backoff_ms);
         full_key_ = path;
         nexus_ = new ::galaxy::ins::sdk::InsSDK(nexus_addr);
     }
 
     virtual ~ResourceManagerImpl() {
+        async_.Stop();
         delete rpc_client_;
         if (NULL != res_stub_) {
             delete res_stub_;
@@ -75,6 +81,12 @@ public:
     bool GrantUser(const GrantUserRequest& request, GrantUserResponse* response);
     bool AssignQuota(const AssignQuotaRequest& request, AssignQuotaResponse* response);
     bool Preempt(const PreemptRequest& request, PreemptResponse* response);
+    void AsyncShowContainerGroup(const ShowContainerGroupRequest& request, 
+                                 const ShowContainerGroupCallback& callback);
+    void AsyncListContainerGroups(const ListContainerGroupsRequest& request, 
+                                  const ListContainerGroupsCallback& callback);
+    int32_t BatchShowContainerGroup(const std::vector<ShowContainerGroupRequest>& requests,
+                                    std::vector<ShowContainerGroupResponse>* responses);
 
 private:
     ::galaxy::ins::sdk::InsSDK* nexus_;
@@ -82,6 +94,8 @@ private:
     ::baidu::galaxy::proto::ResMan_Stub* res_stub_;
     std::string full_key_;
     std::string endpoint_;
+    RpcOptions options_;
+    AsyncCaller async_;
 };
 
 bool ResourceManagerImpl::MasterEndpoint(const std::string& appmaster_path, 
@@ -128,7 +142,8 @@ bool ResourceManagerImpl::EnterSafeMode(const EnterSafeModeRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::EnterSafeMode, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -154,7 +169,8 @@ bool ResourceManagerImpl::LeaveSafeMode(const LeaveSafeModeRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::LeaveSafeMode, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -178,7 +194,8 @@ bool ResourceManagerImpl::Status(const StatusRequest& request, StatusResponse* r
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::Status, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -254,7 +271,8 @@ bool ResourceManagerImpl::CreateContainerGroup(const CreateContainerGroupRequest
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                             &::baidu::galaxy::proto::ResMan_Stub::CreateContainerGroup, 
-                                            &pb_request, &pb_response, 5, 1);
+                                            &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -289,7 +307,8 @@ bool ResourceManagerImpl::RemoveContainerGroup(const RemoveContainerGroupRequest
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::RemoveContainerGroup, 
-                                        &pb_request, &pb_response, 5,1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -332,13 +351,21 @@ bool ResourceManagerImpl::UpdateContainerGroup(const UpdateContainerGroupRequest
     }
     pb_request.set_interval(request.interval);
 
+    if (request.max_surge == 0U && request.max_unavailable == 0U) {
+        fprintf(stderr, "max_surge and max_unavailable can not be both 0\n");
+        return false;
+    }
+    pb_request.set_max_surge(request.max_surge);
+    pb_request.set_max_unavailable(request.max_unavailable);
+
     if (!FillContainerDescription(request.desc, pb_request.mutable_desc())) {
         return false;
     }
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::UpdateContainerGroup, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -362,7 +389,8 @@ bool ResourceManagerImpl::ListContainerGroups(const ListContainerGroupsRequest&
     }
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ListContainerGroups, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -428,7 +456,8 @@ bool ResourceManagerImpl::ShowContainerGroup(const ShowContainerGroupRequest& re
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ShowContainerGroup, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -445,6 +474,18 @@ bool ResourceManagerImpl::ShowContainerGroup(const ShowContainerGroupRequest& re
     response->desc.version = pb_response.desc().version();
     response->desc.cmd_line = pb_response.desc().cmd_line();
     response->desc.max_per_host = pb_response.desc().max_per_host();
+    for (int i = 0; i < pb_response.desc().spreads().size(); ++i) {
+        TopologySpread spread;
+        spread.domain = pb_response.desc().spreads(i).domain();
+        spread.max_per_domain = pb_response.desc().spreads(i).max_per_domain();
+        response->desc.spreads.push_back(spread);
+    }
+    for (int i = 0; i < pb_response.desc().anti_affinities().size(); ++i) {
+        AntiAffinity anti;
+        anti.container_group_id = pb_response.desc().anti_affinities(i).container_group_id();
+        anti.domain = pb_response.desc().anti_affinities(i).domain();
+        response->desc.anti_affinities.push_back(anti);
+    }
     response->desc.tag = pb_response.desc().tag();
     response->desc.container_type = (::baidu::galaxy::sdk::ContainerType)pb_response.desc().container_type();
     for (int i = 0; i < pb_response.desc().pool_names().size(); ++i) {
@@ -480,6 +521,7 @@ bool ResourceManagerImpl::ShowContainerGroup(const ShowContainerGroupRequest& re
         cgroup.id = pb_cgroup.id();
         cgroup.cpu.milli_core = pb_cgroup.cpu().milli_core();
         cgroup.cpu.excess = pb_cgroup.cpu().excess();
+        cgroup.cpu.exclusive = pb_cgroup.cpu().exclusive();
         cgroup.memory.size = pb_cgroup.memory().size();
         cgroup.memory.excess = pb_cgroup.memory().excess();
         cgroup.blkio.weight = pb_cgroup.blkio().weight();
@@ -556,7 +598,8 @@ bool ResourceManagerImpl::AddAgent(const AddAgentRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::AddAgent, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) { 
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -588,7 +631,8 @@ bool ResourceManagerImpl::ShowAgent(const ShowAgentRequest& request, ShowAgentRe
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ShowAgent,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
  
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -649,7 +693,8 @@ bool ResourceManagerImpl::RemoveAgent(const RemoveAgentRequest& request,
     pb_request.set_endpoint(endpoint);
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::RemoveAgent, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -682,7 +727,8 @@ bool ResourceManagerImpl::OnlineAgent(const OnlineAgentRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::OnlineAgent, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -714,7 +760,8 @@ bool ResourceManagerImpl::OfflineAgent(const OfflineAgentRequest& request,
     pb_request.set_endpoint(endpoint);
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::OfflineAgent, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -738,7 +785,8 @@ bool ResourceManagerImpl::ListAgents(const ListAgentsRequest& request,
     }
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ListAgents, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -817,7 +865,8 @@ bool ResourceManagerImpl::CreateTag(const CreateTagRequest& request, CreateTagRe
     
     ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::CreateTag, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -841,7 +890,8 @@ bool ResourceManagerImpl::ListTags(const ListTagsRequest& request, ListTagsRespo
     }
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ListTags, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -878,7 +928,8 @@ bool ResourceManagerImpl::ListAgentsByTag(const ListAgentsByTagRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ListAgentsByTag, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -941,7 +992,8 @@ bool ResourceManagerImpl::GetTagsByAgent(const GetTagsByAgentRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::GetTagsByAgent, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -986,7 +1038,8 @@ bool ResourceManagerImpl::AddAgentToPool(const AddAgentToPoolRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::AddAgentToPool, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -1018,7 +1071,8 @@ bool ResourceManagerImpl::RemoveAgentFromPool(const RemoveAgentFromPoolRequest&
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::RemoveAgentFromPool, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -1051,7 +1105,8 @@ bool ResourceManagerImpl::ListAgentsByPool(const ListAgentsByPoolRequest& reques
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ListAgentsByPool, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -1113,7 +1168,8 @@ bool ResourceManagerImpl::GetPoolByAgent(const GetPoolByAgentRequest& request,
     pb_request.set_endpoint(endpoint);
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::GetPoolByAgent, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -1146,7 +1202,8 @@ bool ResourceManagerImpl::AddUser(const AddUserRequest& request, AddUserResponse
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::AddUser, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -1181,7 +1238,8 @@ bool ResourceManagerImpl::RemoveUser(const RemoveUserRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::RemoveUser, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -1207,7 +1265,8 @@ bool ResourceManagerImpl::ListUsers(const ListUsersRequest& request, ListUsersRe
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ListUsers, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -1244,7 +1303,8 @@ bool ResourceManagerImpl::ShowUser(const ShowUserRequest& request, ShowUserRespo
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::ShowUser, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -1304,7 +1364,8 @@ bool ResourceManagerImpl::GrantUser(const GrantUserRequest& request, GrantUserRe
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::GrantUser, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -1370,7 +1431,8 @@ bool ResourceManagerImpl::AssignQuota(const AssignQuotaRequest& request,
 
     bool ok = rpc_client_->SendRequest(res_stub_, 
                                         &::baidu::galaxy::proto::ResMan_Stub::AssignQuota, 
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
 
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
@@ -1410,7 +1472,8 @@ bool ResourceManagerImpl::Preempt(const PreemptRequest& request, PreemptResponse
 
     bool ok = rpc_client_->SendRequest(res_stub_,
                                         &::baidu::galaxy::proto::ResMan_Stub::Preempt,
-                                        &pb_request, &pb_response, 5, 1);
+                                        &pb_request, &pb_response,
+                                        options_.timeout, options_.retry_times);
     if (!ok) {
         response->error_code.reason = "ResourceManager Rpc SendRequest failed";
         return false;
@@ -1423,9 +1486,34 @@ bool ResourceManagerImpl::Preempt(const PreemptRequest& request, PreemptResponse
     return true;
 }
 
+void ResourceManagerImpl::AsyncShowContainerGroup(const ShowContainerGroupRequest& request, 
+                                                  const ShowContainerGroupCallback& callback) {
+    async_.Call<ShowContainerGroupRequest, ShowContainerGroupResponse>(
+            boost::bind(&ResourceManagerImpl::ShowContainerGroup, this, _1, _2), request, callback);
+}
+
+void ResourceManagerImpl::AsyncListContainerGroups(const ListContainerGroupsRequest& request, 
+                                                   const ListContainerGroupsCallback& callback) {
+    async_.Call<ListContainerGroupsRequest, ListContainerGroupsResponse>(
+            boost::bind(&ResourceManagerImpl::ListContainerGroups, this, _1, _2), request, callback);
+}
+
+int32_t ResourceManagerImpl::BatchShowContainerGroup(
+            const std::vector<ShowContainerGroupRequest>& requests,
+            std::vector<ShowContainerGroupResponse>* responses) {
+    return async_.Gather<ShowContainerGroupRequest, ShowContainerGroupResponse>(
+            boost::bind(&ResourceManagerImpl::ShowContainerGroup, this, _1, _2), requests, responses);
+}
+
 ResourceManager* ResourceManager::ConnectResourceManager(const std::string& nexus_addr, 
                                                          const std::string& path) {
-    ResourceManagerImpl* resman = new ResourceManagerImpl(nexus_addr, path);
+    return ConnectResourceManager(nexus_addr, path, RpcOptions());
+}
+
+ResourceManager* ResourceManager::ConnectResourceManager(const std::string& nexus_addr, 
+                                                         const std::string& path,
+                                                         const RpcOptions& options) {
+    ResourceManagerImpl* resman = new ResourceManagerImpl(nexus_addr, path, options);
     if (!resman->GetStub()) {
         delete resman;
         return NULL;
@@ -5,17 +5,26 @@
 #ifndef BAIDU_GALAXY_SDK_RESMAN_H
 #define BAIDU_GALAXY_SDK_RESMAN_H
 
+#include <boost/function.hpp>
 #include "galaxy_sdk.h"
 
 namespace baidu {
 namespace galaxy {
 namespace sdk {
 
+typedef boost::function<void (bool ok, const ShowContainerGroupResponse& response)>
+        ShowContainerGroupCallback;
+typedef boost::function<void (bool ok, const ListContainerGroupsResponse& response)>
+        ListContainerGroupsCallback;
+
 class ResourceManager {
 public:
 
     static ResourceManager* ConnectResourceManager(const std::string& nexus_addr, 
                                                    const std::string& path);
+    static ResourceManager* ConnectResourceManager(const std::string& nexus_addr, 
+                                                   const std::string& path,
+                                                   const RpcOptions& options);
     virtual ~ResourceManager() = 0; 
 
     //SafeMode
@@ -78,6 +87,15 @@ public:
     //Preempt
     virtual bool Preempt(const PreemptRequest& request, PreemptResponse* response) = 0;
 
+    //Async, callbacks run on an internal pool of RpcOptions.max_inflight threads
+    virtual void AsyncShowContainerGroup(const ShowContainerGroupRequest& request, 
+                                         const ShowContainerGroupCallback& callback) = 0;
+    virtual void AsyncListContainerGroups(const ListContainerGroupsRequest& request, 
+                                          const ListContainerGroupsCallback& callback) = 0;
+    //Bulk, blocks until every request is answered, returns the number of successful calls
+    virtual int32_t BatchShowContainerGroup(const std::vector<ShowContainerGroupRequest>& requests,
+                                            std::vector<ShowContainerGroupResponse>* responses) = 0;
+
 }; //end class ResourceManager
 
 } // end namespace sdk 
@@ -122,8 +122,13 @@ bool FillCpuRequired(const CpuRequired& sdk_cpu,
         fprintf(stderr, "cpu millicores must be greater than 0\n");
         return false;
     }
+    if (sdk_cpu.exclusive && (sdk_cpu.excess || sdk_cpu.milli_core % 1000 != 0)) {
+        fprintf(stderr, "exclusive cpu must be whole cores and cannot be excess\n");
+        return false;
+    }
     cpu->set_milli_core(sdk_cpu.milli_core);
     cpu->set_excess(sdk_cpu.excess);
+    cpu->set_exclusive(sdk_cpu.exclusive);
     return true;
 }
 
@@ -171,6 +176,16 @@ bool FillBlkioRequired(const BlkioRequired& sdk_blk,
         return false;
     }
     blk->set_weight(sdk_blk.weight);
+    if (sdk_blk.read_bps_limit < 0 || sdk_blk.write_bps_limit < 0) {
+        fprintf(stderr, "blkio bps limit must not be negative\n");
+        return false;
+    }
+    if (sdk_blk.read_bps_limit > 0) {
+        blk->set_read_bps_limit(sdk_blk.read_bps_limit);
+    }
+    if (sdk_blk.write_bps_limit > 0) {
+        blk->set_write_bps_limit(sdk_blk.write_bps_limit);
+    }
     return true;
 }
 
@@ -222,6 +237,33 @@ bool FillPortRequired(const PortRequired& sdk_port, ::baidu::galaxy::proto::Port
     return true;
 }
 
+bool FillTopologySpread(const TopologySpread& sdk_spread, ::baidu::galaxy::proto::TopologySpread* spread) {
+    std::string domain = Strim(sdk_spread.domain);
+    if (domain.empty()) {
+        fprintf(stderr, "domain must not be empty in spread\n");
+        return false;
+    }
+    spread->set_domain(domain);
+
+    if (sdk_spread.max_per_domain <= 0) {
+        fprintf(stderr, "max_per_domain must be greater than 0 in spread\n");
+        return false;
+    }
+    spread->set_max_per_domain(sdk_spread.max_per_domain);
+    return true;
+}
+
+bool FillAntiAffinity(const AntiAffinity& sdk_anti, ::baidu::galaxy::proto::AntiAffinity* anti) {
+    std::string container_group_id = Strim(sdk_anti.container_group_id);
+    if (container_group_id.empty()) {
+        fprintf(stderr, "container_group_id must not be empty in anti affinity\n");
+        return false;
+    }
+    anti->set_container_group_id(container_group_id);
+    anti->set_domain(Strim(sdk_anti.domain));
+    return true;
+}
+
 bool FillCgroup(const Cgroup& sdk_cgroup, 
                 ::baidu::galaxy::proto::Cgroup* cgroup,  
                 std::vector<std::string>& vec_cgroups_ports) {
@@ -328,6 +370,18 @@ bool FillContainerDescription(const ContainerDescription& sdk_container,
     }
     container->set_max_per_host(sdk_container.max_per_host);
 
+    for (size_t i = 0; i < sdk_container.spreads.size(); ++i) {
+        if (!FillTopologySpread(sdk_container.spreads[i], container->add_spreads())) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < sdk_container.anti_affinities.size(); ++i) {
+        if (!FillAntiAffinity(sdk_container.anti_affinities[i], container->add_anti_affinities())) {
+            return false;
+        }
+    }
+
     if (sdk_container.pool_names.size() == 0) {
         fprintf(stderr, "pools size is 0\n");
         return false;
@@ -441,6 +495,30 @@ bool FillImagePackage(const ImagePackage& sdk_image,
     image->set_start_cmd(start_cmd);
     image->set_stop_cmd(Strim(sdk_image.stop_cmd));
     image->set_health_cmd(Strim(sdk_image.health_cmd));
+    if (sdk_image.health_probe.type != kProbeNone) {
+        const HealthProbe& sdk_probe = sdk_image.health_probe;
+        ::baidu::galaxy::proto::HealthProbe* probe = image->mutable_health_probe();
+        if (sdk_probe.type == kProbeTcp) {
+            probe->set_type(::baidu::galaxy::proto::kProbeTcp);
+        } else if (sdk_probe.type == kProbeHttp) {
+            probe->set_type(::baidu::galaxy::proto::kProbeHttp);
+        } else {
+            fprintf(stderr, "health_probe type must be kProbeTcp or kProbeHttp\n");
+            return false;
+        }
+        std::string port = Strim(sdk_probe.port);
+        if (port.empty()) {
+            fprintf(stderr, "health_probe port must not be empty\n");
+            return false;
+        }
+        probe->set_port(port);
+        probe->set_path(Strim(sdk_probe.path));
+        if (sdk_probe.timeout < 0) {
+            fprintf(stderr, "health_probe timeout must not be negative\n");
+            return false;
+        }
+        probe->set_timeout(sdk_probe.timeout);
+    }
     if (!FillPackage(sdk_image.package, image->mutable_package())) {
         return false;
     }
@@ -697,6 +775,28 @@ bool FillDeploy(const Deploy& sdk_deploy, ::baidu::galaxy::proto::Deploy* deploy
         return false;
     }
     deploy->set_stop_timeout(sdk_deploy.stop_timeout);
+    deploy->set_max_surge(sdk_deploy.max_surge);
+    deploy->set_max_unavailable(sdk_deploy.max_unavailable);
+
+    for (size_t i = 0; i < sdk_deploy.spreads.size(); ++i) {
+        if (!FillTopologySpread(sdk_deploy.spreads[i], deploy->add_spreads())) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < sdk_deploy.anti_affinities.size(); ++i) {
+        if (!FillAntiAffinity(sdk_deploy.anti_affinities[i], deploy->add_anti_affinities())) {
+            return false;
+        }
+    }
+
+    if (sdk_deploy.gang && (sdk_deploy.gang_min > sdk_deploy.replica || sdk_deploy.gang_timeout <= 0)) {
+        fprintf(stderr, "deploy gang_min must not be greater than replica and gang_timeout must be greater than 0\n");
+        return false;
+    }
+    deploy->set_gang(sdk_deploy.gang);
+    deploy->set_gang_min(sdk_deploy.gang_min);
+    deploy->set_gang_timeout(sdk_deploy.gang_timeout);
     
     deploy->set_tag(Strim(sdk_deploy.tag));
 
@@ -865,6 +965,26 @@ void PbJobDescription2SdkJobDescription(const ::baidu::galaxy::proto::JobDescrip
     if (pb_job.deploy().has_stop_timeout()) {
         job->deploy.stop_timeout = pb_job.deploy().stop_timeout();
     }
+    job->deploy.max_surge = pb_job.deploy().max_surge();
+    job->deploy.max_unavailable = pb_job.deploy().max_unavailable();
+
+    for (int i = 0; i < pb_job.deploy().spreads().size(); ++i) {
+        TopologySpread spread;
+        spread.domain = pb_job.deploy().spreads(i).domain();
+        spread.max_per_domain = pb_job.deploy().spreads(i).max_per_domain();
+        job->deploy.spreads.push_back(spread);
+    }
+
+    for (int i = 0; i < pb_job.deploy().anti_affinities().size(); ++i) {
+        AntiAffinity anti;
+        anti.container_group_id = pb_job.deploy().anti_affinities(i).container_group_id();
+        anti.domain = pb_job.deploy().anti_affinities(i).domain();
+        job->deploy.anti_affinities.push_back(anti);
+    }
+
+    job->deploy.gang = pb_job.deploy().gang();
+    job->deploy.gang_min = pb_job.deploy().gang_min();
+    job->deploy.gang_timeout = pb_job.deploy().gang_timeout();
 
     for (int i = 0; i < pb_job.deploy().pools().size(); ++i) {
         job->deploy.pools.push_back(pb_job.deploy().pools(i));
@@ -897,6 +1017,7 @@ void PbJobDescription2SdkJobDescription(const ::baidu::galaxy::proto::JobDescrip
         task.id = pb_job.pod().tasks(i).id();
         task.cpu.milli_core = pb_job.pod().tasks(i).cpu().milli_core();
         task.cpu.excess = pb_job.pod().tasks(i).cpu().excess();
+        task.cpu.exclusive = pb_job.pod().tasks(i).cpu().exclusive();
         task.memory.size = pb_job.pod().tasks(i).memory().size();
         task.memory.excess = pb_job.pod().tasks(i).memory().excess();
         if (pb_job.pod().tasks(i).memory().has_use_galaxy_killer()) {
@@ -907,6 +1028,8 @@ void PbJobDescription2SdkJobDescription(const ::baidu::galaxy::proto::JobDescrip
         task.tcp_throt.send_bps_quota = pb_job.pod().tasks(i).tcp_throt().send_bps_quota();
         task.tcp_throt.send_bps_excess = pb_job.pod().tasks(i).tcp_throt().send_bps_excess();
         task.blkio.weight = pb_job.pod().tasks(i).blkio().weight();
+        task.blkio.read_bps_limit = pb_job.pod().tasks(i).blkio().read_bps_limit();
+        task.blkio.write_bps_limit = pb_job.pod().tasks(i).blkio().write_bps_limit();
         for (int j = 0; j < pb_job.pod().tasks(i).ports().size(); ++j) {
             PortRequired port;
             port.port_name = pb_job.pod().tasks(i).ports(j).port_name();
@@ -916,6 +1039,14 @@ void PbJobDescription2SdkJobDescription(const ::baidu::galaxy::proto::JobDescrip
         }
         task.exe_package.start_cmd = pb_job.pod().tasks(i).exe_package().start_cmd();
         task.exe_package.stop_cmd = pb_job.pod().tasks(i).exe_package().stop_cmd();
+        task.exe_package.health_cmd = pb_job.pod().tasks(i).exe_package().health_cmd();
+        if (pb_job.pod().tasks(i).exe_package().has_health_probe()) {
+            const ::baidu::galaxy::proto::HealthProbe& probe = pb_job.pod().tasks(i).exe_package().health_probe();
+            task.exe_package.health_probe.type = (ProbeType)probe.type();
+            task.exe_package.health_probe.port = probe.port();
+            task.exe_package.health_probe.path = probe.path();
+            task.exe_package.health_probe.timeout = probe.timeout();
+        }
         task.exe_package.package.source_path = pb_job.pod().tasks(i).exe_package().package().source_path();
         task.exe_package.package.dest_path = pb_job.pod().tasks(i).exe_package().package().dest_path();
         task.exe_package.package.version = pb_job.pod().tasks(i).exe_package().package().version();
@@ -20,6 +20,8 @@ bool FillMemRequired(const MemoryRequired& sdk_mem, ::baidu::galaxy::proto::Memo
 bool FillTcpthrotRequired(const TcpthrotRequired& sdk_tcp, ::baidu::galaxy::proto::TcpthrotRequired* tcp);
 bool FillBlkioRequired(const BlkioRequired& sdk_blk, ::baidu::galaxy::proto::BlkioRequired* blk);
 bool FillPortRequired(const PortRequired& sdk_port, ::baidu::galaxy::proto::PortRequired* port);
+bool FillTopologySpread(const TopologySpread& sdk_spread, ::baidu::galaxy::proto::TopologySpread* spread);
+bool FillAntiAffinity(const AntiAffinity& sdk_anti, ::baidu::galaxy::proto::AntiAffinity* anti);
 bool FillCgroup(const Cgroup& sdk_cgroup, 
                 ::baidu::galaxy::proto::Cgroup* cgroup,
                 std::vector<std::string>& vec_port_names,
@@ -0,0 +1,34 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "unit_test.h"
+
+#ifdef TEST_CONTAINER_STAGE_ON
+#include "agent/container/container_stage.h"
+
+TEST(TestContainerStage, Hold) {
+    baidu::galaxy::container::ContainerStage stage;
+    EXPECT_TRUE(stage.Empty());
+
+    baidu::galaxy::util::ErrorCode ec = stage.EnterCreatingStage("c1");
+    EXPECT_EQ(baidu::galaxy::util::kErrorOk, ec.Code()) << ec.Message();
+    EXPECT_FALSE(stage.Empty());
+
+    stage.Hold(true);
+    ec = stage.EnterCreatingStage("c2");
+    EXPECT_EQ(baidu::galaxy::util::kErrorNotAllowed, ec.Code()) << ec.Message();
+    ec = stage.EnterDestroyingStage("c3");
+    EXPECT_EQ(baidu::galaxy::util::kErrorNotAllowed, ec.Code()) << ec.Message();
+
+    // the one in a stage goes on
+    ec = stage.LeaveCreatingStage("c1");
+    EXPECT_EQ(baidu::galaxy::util::kErrorOk, ec.Code()) << ec.Message();
+    EXPECT_TRUE(stage.Empty());
+
+    stage.Hold(false);
+    ec = stage.EnterDestroyingStage("c3");
+    EXPECT_EQ(baidu::galaxy::util::kErrorOk, ec.Code()) << ec.Message();
+}
+
+#endif
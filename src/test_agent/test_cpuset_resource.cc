@@ -0,0 +1,51 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "unit_test.h"
+#ifdef TEST_CPUSET_RESOURCE_ON
+#include "agent/resource/cpuset_resource.h"
+
+namespace baidu {
+namespace galaxy {
+namespace test {
+
+TEST(TestCpusetResource, ParseCpuList) {
+    std::set<int32_t> cpus;
+    EXPECT_TRUE(baidu::galaxy::resource::CpusetResource::ParseCpuList("0-3,8,10-11", cpus));
+    EXPECT_EQ(7u, cpus.size());
+    EXPECT_TRUE(cpus.find(2) != cpus.end());
+    EXPECT_TRUE(cpus.find(9) == cpus.end());
+
+    cpus.clear();
+    EXPECT_FALSE(baidu::galaxy::resource::CpusetResource::ParseCpuList("3-1", cpus));
+    EXPECT_FALSE(baidu::galaxy::resource::CpusetResource::ParseCpuList("a", cpus));
+}
+
+TEST(TestCpusetResource, FormatCpuList) {
+    std::set<int32_t> cpus;
+    EXPECT_STREQ("", baidu::galaxy::resource::CpusetResource::FormatCpuList(cpus).c_str());
+    cpus.insert(0);
+    cpus.insert(1);
+    cpus.insert(2);
+    cpus.insert(5);
+    cpus.insert(7);
+    cpus.insert(8);
+    EXPECT_STREQ("0-2,5,7-8", baidu::galaxy::resource::CpusetResource::FormatCpuList(cpus).c_str());
+}
+
+TEST(TestCpusetResource, Disabled) {
+    baidu::galaxy::resource::CpusetResource cpuset;
+    EXPECT_EQ(0, cpuset.Load());
+    EXPECT_FALSE(cpuset.Enabled());
+    EXPECT_EQ(0, cpuset.ExclusiveCores());
+    int32_t node = -1;
+    std::string cpu_set;
+    EXPECT_NE(0, cpuset.Allocate(1, node, cpu_set).Code());
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,94 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "unit_test.h"
+#ifdef TEST_METRICS_STORE_ON
+#include "agent/container/metrics_store.h"
+#include "protocol/agent.pb.h"
+
+namespace baidu {
+namespace galaxy {
+namespace test {
+
+static baidu::galaxy::container::MetricPoint Point(int64_t second, int64_t cpu, int64_t io_read) {
+    baidu::galaxy::container::MetricPoint point;
+    point.time_ = second * 1000000L;
+    point.cpu_used_in_millicore_ = cpu;
+    point.io_read_bytes_ = io_read;
+    return point;
+}
+
+TEST(TestMetricsStore, Ring) {
+    baidu::galaxy::container::MetricsStore store(3, 8);
+    for (int64_t i = 1; i <= 5; i++) {
+        store.Append("c1", "g1", Point(i, i * 100, i * 1000));
+    }
+
+    baidu::galaxy::proto::QueryMetricsRequest request;
+    request.set_end_time(100 * 1000000L);
+    baidu::galaxy::proto::QueryMetricsResponse response;
+    store.Query(request, &response);
+
+    ASSERT_EQ(1, response.series_size());
+    const baidu::galaxy::proto::MetricSeries& ms = response.series(0);
+    EXPECT_EQ("g1", ms.group_id());
+    // the oldest two are overwritten
+    ASSERT_EQ(3, ms.samples_size());
+    EXPECT_EQ(3 * 1000000L, ms.samples(0).time());
+    EXPECT_EQ(500, ms.samples(2).cpu_used_in_millicore());
+    EXPECT_EQ(1000, ms.samples(2).io_read_bps());
+}
+
+TEST(TestMetricsStore, RangeAndStep) {
+    baidu::galaxy::container::MetricsStore store(16, 8);
+    for (int64_t i = 10; i < 20; i++) {
+        store.Append("c1", "g1", Point(i, i, 0));
+    }
+    store.Append("c2", "g2", Point(10, 1, 0));
+
+    baidu::galaxy::proto::QueryMetricsRequest request;
+    request.set_id("c1");
+    request.set_start_time(12 * 1000000L);
+    request.set_end_time(17 * 1000000L);
+    request.set_step(5);
+    baidu::galaxy::proto::QueryMetricsResponse response;
+    store.Query(request, &response);
+
+    ASSERT_EQ(1, response.series_size());
+    const baidu::galaxy::proto::MetricSeries& ms = response.series(0);
+    // 12..14 and 15..17
+    ASSERT_EQ(2, ms.samples_size());
+    EXPECT_EQ(10 * 1000000L, ms.samples(0).time());
+    EXPECT_EQ(13, ms.samples(0).cpu_used_in_millicore());
+    EXPECT_EQ(15 * 1000000L, ms.samples(1).time());
+    EXPECT_EQ(16, ms.samples(1).cpu_used_in_millicore());
+
+    request.set_text(true);
+    response.Clear();
+    store.Query(request, &response);
+    EXPECT_EQ(0, response.series_size());
+    EXPECT_NE(std::string::npos,
+            response.text().find("galaxy_cpu_used_millicore{id=\"c1\",group=\"g1\"} 13 10000"));
+}
+
+TEST(TestMetricsStore, MaxSeries) {
+    baidu::galaxy::container::MetricsStore store(4, 2);
+    store.Append("c1", "g", Point(1, 1, 0));
+    store.Append("c2", "g", Point(2, 1, 0));
+    store.Append("c3", "g", Point(3, 1, 0));
+
+    baidu::galaxy::proto::QueryMetricsRequest request;
+    request.set_end_time(100 * 1000000L);
+    baidu::galaxy::proto::QueryMetricsResponse response;
+    store.Query(request, &response);
+
+    ASSERT_EQ(2, response.series_size());
+    EXPECT_EQ("c2", response.series(0).id());
+    EXPECT_EQ("c3", response.series(1).id());
+}
+
+}
+}
+}
+#endif
@@ -0,0 +1,64 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "unit_test.h"
+#ifdef TEST_PRESSURE_COLLECTOR_ON
+#include "agent/collector/pressure_collector.h"
+#include "protocol/galaxy.pb.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+namespace baidu {
+namespace galaxy {
+namespace test {
+
+TEST(TestPressureCollector, ReadPressureFile) {
+    const std::string path = "./memory.pressure";
+    FILE* file = fopen(path.c_str(), "w");
+    ASSERT_TRUE(NULL != file);
+    fprintf(file, "some avg10=1.50 avg60=0.75 avg300=0.20 total=123456\n");
+    fprintf(file, "full avg10=0.50 avg60=0.00 avg300=0.00 total=2345\n");
+    fclose(file);
+
+    baidu::galaxy::proto::PressureAvg some;
+    baidu::galaxy::proto::PressureAvg full;
+    EXPECT_EQ(0, baidu::galaxy::collector::ReadPressureFile(path, &some, &full).Code());
+    EXPECT_DOUBLE_EQ(1.5, some.avg10());
+    EXPECT_DOUBLE_EQ(0.75, some.avg60());
+    EXPECT_DOUBLE_EQ(0.2, some.avg300());
+    EXPECT_DOUBLE_EQ(0.5, full.avg10());
+
+    // the full line is skipped when not asked for
+    baidu::galaxy::proto::PressureAvg cpu;
+    EXPECT_EQ(0, baidu::galaxy::collector::ReadPressureFile(path, &cpu, NULL).Code());
+    EXPECT_DOUBLE_EQ(1.5, cpu.avg10());
+
+    unlink(path.c_str());
+    EXPECT_NE(0, baidu::galaxy::collector::ReadPressureFile(path, &some, &full).Code());
+}
+
+TEST(TestPressureCollector, MergePressure) {
+    baidu::galaxy::proto::Pressure p1;
+    p1.mutable_cpu_some()->set_avg10(3.0);
+    p1.mutable_cpu_some()->set_avg60(1.0);
+
+    baidu::galaxy::proto::Pressure p2;
+    p2.mutable_cpu_some()->set_avg10(2.0);
+    p2.mutable_cpu_some()->set_avg60(4.0);
+    p2.mutable_memory_full()->set_avg10(5.0);
+
+    baidu::galaxy::proto::Pressure merged;
+    baidu::galaxy::collector::MergePressure(p1, &merged);
+    baidu::galaxy::collector::MergePressure(p2, &merged);
+    EXPECT_DOUBLE_EQ(3.0, merged.cpu_some().avg10());
+    EXPECT_DOUBLE_EQ(4.0, merged.cpu_some().avg60());
+    EXPECT_DOUBLE_EQ(5.0, merged.memory_full().avg10());
+    EXPECT_FALSE(merged.has_io_some());
+}
+
+}
+}
+}
+#endif
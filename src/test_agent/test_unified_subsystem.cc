@@ -0,0 +1,31 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "unit_test.h"
+#ifdef TEST_CGROUP_UNIFIED_ON
+#include "agent/cgroup/unified_subsystem.h"
+
+namespace baidu {
+namespace galaxy {
+namespace test {
+
+TEST(TestUnifiedSubsystem, ShareToWeight) {
+    EXPECT_EQ(1, baidu::galaxy::cgroup::ShareToWeight(2));
+    EXPECT_EQ(1, baidu::galaxy::cgroup::ShareToWeight(0));
+    EXPECT_EQ(39, baidu::galaxy::cgroup::ShareToWeight(1024));
+    EXPECT_EQ(10000, baidu::galaxy::cgroup::ShareToWeight(262144));
+    EXPECT_EQ(10000, baidu::galaxy::cgroup::ShareToWeight(1000000));
+}
+
+TEST(TestUnifiedSubsystem, BlkioWeightToIoWeight) {
+    EXPECT_EQ(1, baidu::galaxy::cgroup::BlkioWeightToIoWeight(10));
+    EXPECT_EQ(1, baidu::galaxy::cgroup::BlkioWeightToIoWeight(1));
+    EXPECT_EQ(5000, baidu::galaxy::cgroup::BlkioWeightToIoWeight(505));
+    EXPECT_EQ(10000, baidu::galaxy::cgroup::BlkioWeightToIoWeight(1000));
+}
+
+}
+}
+}
+#endif
@@ -8,6 +8,10 @@
 #include <iostream>
 
 //#define TEST_CGROUP_CPU_ON
+#define TEST_CPUSET_RESOURCE_ON
+#define TEST_CGROUP_UNIFIED_ON
+#define TEST_PRESSURE_COLLECTOR_ON
+#define TEST_METRICS_STORE_ON
 //#define TEST_CGROUP_MEMORY_ON
 //#define TEST_CGROUP_FREEZER_ON
 //#define TEST_CGROUP_NETCLS_ON
@@ -21,6 +25,7 @@
 
 //#define TEST_CONTAINER_ON
 #define TEST_CONTAINER_STATUS_ON
+#define TEST_CONTAINER_STAGE_ON
 //#define TEST_COLLECTOR_ENGINE_ON
 //#define TEST_FILE_INPUT_STREAM
 //#define TEST_OUTPUT_STREAM_FILE_ON
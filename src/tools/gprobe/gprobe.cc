@@ -28,6 +28,9 @@ DEFINE_string(a, "", "dir to append");
 DEFINE_string(h, "", "to print help");
 DEFINE_string(e, "", "endpoint");
 DEFINE_int32(t, -1, "");
+DEFINE_bool(m, false, "print the metric history kept by agent in text format");
+DEFINE_int32(r, 600, "seconds of the metric history to print, used with -m");
+DEFINE_int32(d, 0, "seconds of a downsampled point of the metric history, used with -m");
 
 baidu::galaxy::util::ErrorCode CheckParameter();
 void PrintHelp(const char* argv0);
@@ -39,6 +42,7 @@ void WriteMetrixesToFiles(std::map<std::string, boost::shared_ptr<baidu::galaxy:
         const std::string& dir_path,
         bool append);
 void PrintMetrixes(std::map<std::string, boost::shared_ptr<baidu::galaxy::tools::PodMetrix> >& metrix);
+int PrintHistory(baidu::galaxy::RpcClient* rpc, baidu::galaxy::proto::Agent_Stub* agent_stub);
  
 int main(int argc, char** argv) {
     if (argc <= 1) {
@@ -79,6 +83,10 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    if (FLAGS_m) {
+        return PrintHistory(rpc.get(), agent_stub);
+    }
+
     baidu::galaxy::proto::QueryRequest qr;
     qr.set_full_report(true);
     int64_t last_output_time = baidu::common::timer::get_micros();
@@ -133,7 +141,7 @@ baidu::galaxy::util::ErrorCode CheckParameter() {
 }
 
 void PrintHelp(const char* argv0) {
-    std::cout << "usage: " << argv0 << " -p port [ -i ] [ -w ] [ -a ] [ -e ]" << std::endl;
+    std::cout << "usage: " << argv0 << " -p port [ -i ] [ -w ] [ -a ] [ -e ] [ -m [ -r ] [ -d ] ]" << std::endl;
 }
 
 void ParseInfo(const baidu::galaxy::proto::QueryResponse& qres, std::map<std::string, boost::shared_ptr<baidu::galaxy::tools::PodMetrix> >& metrix) {
@@ -278,3 +286,26 @@ void PrintMetrixes(std::map<std::string, boost::shared_ptr<baidu::galaxy::tools:
         iter++;
     }
 }
+
+int PrintHistory(baidu::galaxy::RpcClient* rpc, baidu::galaxy::proto::Agent_Stub* agent_stub) {
+    baidu::galaxy::proto::QueryMetricsRequest request;
+    baidu::galaxy::proto::QueryMetricsResponse response;
+    request.set_id(FLAGS_i);
+    request.set_start_time(baidu::common::timer::get_micros() - FLAGS_r * 1000000L);
+    request.set_step(FLAGS_d);
+    request.set_text(true);
+
+    if (!rpc->SendRequest(agent_stub,
+                    &baidu::galaxy::proto::Agent_Stub::QueryMetrics,
+                    &request,
+                    &response,
+                    5,
+                    1)) {
+        std::cerr << "query metrics failed" << std::endl;
+        return -1;
+    }
+
+    fprintf(stdout, "%s", response.text().c_str());
+    fflush(stdout);
+    return 0;
+}
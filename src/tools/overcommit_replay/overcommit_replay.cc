@@ -0,0 +1,205 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Replays the usage of the service containers of one host against the
+// reservation model of the scheduler. At every report best effort work
+// takes all the room the reservations leave, and it is squeezed when the
+// services grow past the room by the next report. For each model the
+// utilization of the host and the rate of such evictions are printed, the
+// model 1:1:100 plans for the latest report only.
+//
+// trace lines: <time> <container id> <need> <used>, ordered by time
+
+#include "resman/usage_model.h"
+
+#include <gflags/gflags.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+DECLARE_double(reserved_percent);
+DECLARE_double(usage_ewma_alpha);
+DECLARE_int32(usage_window);
+DECLARE_int32(usage_percentile);
+
+DEFINE_string(trace, "", "usage trace to replay, a synthetic one is made when empty");
+DEFINE_int64(capacity, 0, "capacity of the host, the sum of the needs when 0");
+DEFINE_string(models, "1:1:100,0.3:30:95,0.3:30:99,0.1:60:99",
+              "models to compare, each as ewma_alpha:window:percentile");
+DEFINE_string(reserved_percents, "1.0,1.2,1.5,2.0", "reserved_percent to try with each model");
+DEFINE_int32(synthetic_containers, 20, "service containers of the synthetic trace");
+DEFINE_int32(synthetic_reports, 2000, "reports of the synthetic trace");
+DEFINE_int32(seed, 1, "seed of the synthetic trace");
+
+using baidu::galaxy::sched::UsageModel;
+
+struct Sample {
+    std::string id;
+    int64_t need;
+    int64_t used;
+};
+
+typedef std::map<int64_t, std::vector<Sample> > Trace;
+
+struct Result {
+    double utilization;
+    double eviction_rate;
+    double best_effort;
+};
+
+static bool LoadTrace(const std::string& path, Trace& trace) {
+    std::ifstream in(path.c_str());
+    if (!in) {
+        std::cerr << "open trace failed: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream ss(line);
+        int64_t time = 0;
+        Sample sample;
+        if (!(ss >> time >> sample.id >> sample.need >> sample.used)) {
+            std::cerr << "bad trace line: " << line << std::endl;
+            return false;
+        }
+        trace[time].push_back(sample);
+    }
+    return true;
+}
+
+// services idle around a base with some noise, and now and then burst
+// close to all they need for a few reports
+static void MakeTrace(Trace& trace) {
+    srand(FLAGS_seed);
+    for (int i = 0; i < FLAGS_synthetic_containers; i++) {
+        std::stringstream id;
+        id << "service." << i;
+        int64_t need = 1000 * (1 + rand() % 4);
+        int64_t base = need * (20 + rand() % 30) / 100;
+        int burst = 0;
+        for (int t = 0; t < FLAGS_synthetic_reports; t++) {
+            if (burst == 0 && rand() % 100 == 0) {
+                burst = 1 + rand() % 6;
+            }
+            int64_t used = base + base * (rand() % 21 - 10) / 100;
+            if (burst > 0) {
+                used = need * (70 + rand() % 31) / 100;
+                burst--;
+            }
+            Sample sample;
+            sample.id = id.str();
+            sample.need = need;
+            sample.used = used;
+            trace[t].push_back(sample);
+        }
+    }
+}
+
+static Result Replay(const Trace& trace, int64_t capacity) {
+    std::map<std::string, UsageModel> models;
+    std::map<std::string, int64_t> needs;
+    std::map<std::string, int64_t> useds;
+    int64_t best_effort = -1; //room taken at the last report
+    int64_t reports = 0;
+    int64_t evictions = 0;
+    double utilization = 0.0;
+    double best_effort_sum = 0.0;
+    Trace::const_iterator it;
+    for (it = trace.begin(); it != trace.end(); it++) {
+        for (size_t i = 0; i < it->second.size(); i++) {
+            const Sample& sample = it->second[i];
+            models[sample.id].Add(sample.used);
+            needs[sample.id] = sample.need;
+            useds[sample.id] = sample.used;
+        }
+        int64_t used = 0;
+        int64_t reserved = 0;
+        std::map<std::string, UsageModel>::const_iterator jt;
+        for (jt = models.begin(); jt != models.end(); jt++) {
+            used += useds[jt->first];
+            reserved += jt->second.Reserve(needs[jt->first]);
+        }
+        if (best_effort >= 0) {
+            reports++;
+            if (used + best_effort > capacity) {
+                evictions++;
+            }
+            utilization += std::min(used + best_effort, capacity) / (double)capacity;
+            best_effort_sum += best_effort;
+        }
+        best_effort = std::max(capacity - reserved, (int64_t)0);
+    }
+    Result result;
+    result.utilization = reports > 0 ? utilization / reports : 0.0;
+    result.eviction_rate = reports > 0 ? evictions / (double)reports : 0.0;
+    result.best_effort = reports > 0 ? best_effort_sum / reports : 0.0;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    google::ParseCommandLineFlags(&argc, &argv, true);
+    Trace trace;
+    if (FLAGS_trace.empty()) {
+        MakeTrace(trace);
+    } else if (!LoadTrace(FLAGS_trace, trace)) {
+        return -1;
+    }
+    if (trace.empty()) {
+        std::cerr << "empty trace" << std::endl;
+        return -1;
+    }
+
+    int64_t capacity = FLAGS_capacity;
+    if (capacity <= 0) {
+        std::map<std::string, int64_t> needs;
+        Trace::const_iterator it;
+        for (it = trace.begin(); it != trace.end(); it++) {
+            for (size_t i = 0; i < it->second.size(); i++) {
+                needs[it->second[i].id] = it->second[i].need;
+            }
+        }
+        std::map<std::string, int64_t>::const_iterator jt;
+        for (jt = needs.begin(); jt != needs.end(); jt++) {
+            capacity += jt->second;
+        }
+    }
+
+    std::vector<std::string> models;
+    boost::split(models, FLAGS_models, boost::is_any_of(","));
+    std::vector<std::string> percents;
+    boost::split(percents, FLAGS_reserved_percents, boost::is_any_of(","));
+    printf("capacity: %ld, reports: %zu\n", capacity, trace.size());
+    printf("%-16s %8s %12s %14s %12s\n", "model", "percent", "utilization", "eviction_rate", "best_effort");
+    for (size_t i = 0; i < models.size(); i++) {
+        double alpha = 0.0;
+        int window = 0;
+        int percentile = 0;
+        if (sscanf(models[i].c_str(), "%lf:%d:%d", &alpha, &window, &percentile) != 3) {
+            std::cerr << "bad model: " << models[i] << std::endl;
+            return -1;
+        }
+        FLAGS_usage_ewma_alpha = alpha;
+        FLAGS_usage_window = window;
+        FLAGS_usage_percentile = percentile;
+        for (size_t j = 0; j < percents.size(); j++) {
+            FLAGS_reserved_percent = atof(percents[j].c_str());
+            Result result = Replay(trace, capacity);
+            printf("%-16s %8.2f %11.1f%% %13.2f%% %12.0f\n", models[i].c_str(), FLAGS_reserved_percent,
+                   result.utilization * 100, result.eviction_rate * 100, result.best_effort);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "latency_histogram.h"
+
+#include <sstream>
+
+namespace baidu {
+namespace galaxy {
+
+// upper bounds of the latency buckets in ms, the last one takes the rest
+static const int64_t kLatencyBounds[] = {1, 5, 10, 50, 100, 500, 1000, 5000};
+static const size_t kLatencyBuckets = sizeof(kLatencyBounds) / sizeof(kLatencyBounds[0]) + 1;
+
+LatencyHistogram::LatencyHistogram() :
+    counts_(kLatencyBuckets, 0),
+    total_(0),
+    sum_us_(0) {
+}
+
+void LatencyHistogram::Add(int64_t latency_us) {
+    size_t i = 0;
+    while (i < kLatencyBuckets - 1 && latency_us > kLatencyBounds[i] * 1000) {
+        i++;
+    }
+    counts_[i]++;
+    total_++;
+    sum_us_ += latency_us;
+}
+
+int64_t LatencyHistogram::Count() const {
+    return total_;
+}
+
+std::string LatencyHistogram::ToString() const {
+    std::stringstream ss;
+    ss << "count:" << total_
+       << " avg_ms:" << (total_ > 0 ? sum_us_ / total_ / 1000 : 0);
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        if (i < kLatencyBuckets - 1) {
+            ss << " <=" << kLatencyBounds[i] << "ms:" << counts_[i];
+        } else {
+            ss << " >" << kLatencyBounds[i - 1] << "ms:" << counts_[i];
+        }
+    }
+    return ss.str();
+}
+
+} //namespace galaxy
+} //namespace baidu
@@ -0,0 +1,29 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace baidu {
+namespace galaxy {
+
+// Counts latencies in fixed buckets from 1ms to 5s, not thread safe.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+    void Add(int64_t latency_us);
+    int64_t Count() const;
+    std::string ToString() const;
+
+private:
+    std::vector<int64_t> counts_;
+    int64_t total_;
+    int64_t sum_us_;
+};
+
+} //namespace galaxy
+} //namespace baidu
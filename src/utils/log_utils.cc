@@ -0,0 +1,171 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "log_utils.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <gflags/gflags.h>
+#include <timer.h>
+
+DEFINE_bool(log_async, true, "write log files from a background thread");
+DEFINE_int32(log_flush_interval, 200, "interval of writing buffered log lines to files, in ms");
+DEFINE_int32(log_buffer_size, 8 * 1024 * 1024, "bytes of log lines buffered per log file, lines beyond are dropped");
+
+namespace baidu {
+namespace galaxy {
+
+static std::vector<AsyncLogger*> async_loggers;
+
+AsyncLogger::AsyncLogger(google::base::Logger* base) :
+    base_(base),
+    timestamp_(0),
+    dropped_(0),
+    flush_pool_(1) {
+    flush_pool_.DelayTask(FLAGS_log_flush_interval, boost::bind(&AsyncLogger::FlushRoutine, this));
+}
+
+AsyncLogger::~AsyncLogger() {
+    flush_pool_.Stop(true);
+    Drain();
+}
+
+void AsyncLogger::Write(bool force_flush, time_t timestamp, const char* message, int message_len) {
+    {
+        MutexLock lock(&mutex_);
+        if (buffer_.size() + message_len > (size_t)FLAGS_log_buffer_size) {
+            dropped_++;
+        } else {
+            buffer_.append(message, message_len);
+        }
+        timestamp_ = timestamp;
+    }
+
+    if (force_flush) {
+        Drain();
+        MutexLock lock(&write_mutex_);
+        base_->Flush();
+    }
+}
+
+void AsyncLogger::Flush() {
+    Drain();
+    MutexLock lock(&write_mutex_);
+    base_->Flush();
+}
+
+google::uint32 AsyncLogger::LogSize() {
+    MutexLock lock(&write_mutex_);
+    return base_->LogSize();
+}
+
+void AsyncLogger::Drain() {
+    // lines go out in the order they came in, whoever drains
+    MutexLock write_lock(&write_mutex_);
+    std::string lines;
+    time_t timestamp = 0;
+    int64_t dropped = 0;
+    {
+        MutexLock lock(&mutex_);
+        lines.swap(buffer_);
+        timestamp = timestamp_;
+        dropped = dropped_;
+        dropped_ = 0;
+    }
+
+    if (dropped > 0) {
+        std::stringstream ss;
+        ss << "W async logger dropped " << dropped << " lines, buffer is full\n";
+        lines.append(ss.str());
+    }
+
+    if (!lines.empty()) {
+        base_->Write(false, timestamp, lines.data(), lines.size());
+    }
+}
+
+void AsyncLogger::DrainUnsafe() {
+    if (!buffer_.empty()) {
+        base_->Write(false, timestamp_, buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+    base_->Flush();
+}
+
+void AsyncLogger::FlushRoutine() {
+    Drain();
+    flush_pool_.DelayTask(FLAGS_log_flush_interval, boost::bind(&AsyncLogger::FlushRoutine, this));
+}
+
+static void FlushAsyncLog() {
+    // flushes INFO and every severity above it
+    google::FlushLogFiles(google::INFO);
+}
+
+// glog writes the dump of a failure signal through here, the lines
+// buffered before the signal go to the log files first
+static void WriteFailure(const char* data, int size) {
+    static bool drained = false;
+    if (!drained) {
+        drained = true;
+        for (size_t i = 0; i < async_loggers.size(); i++) {
+            async_loggers[i]->DrainUnsafe();
+        }
+    }
+    if (write(STDERR_FILENO, data, size) < 0) {
+        return;
+    }
+}
+
+void SetupAsyncLog() {
+    if (!FLAGS_log_async) {
+        return;
+    }
+    // ERROR and FATAL have no file of their own, see SetupLog
+    google::LogSeverity severities[] = {google::INFO, google::WARNING};
+    for (size_t i = 0; i < sizeof(severities) / sizeof(severities[0]); i++) {
+        google::base::Logger* base = google::base::GetLogger(severities[i]);
+        AsyncLogger* logger = new AsyncLogger(base);
+        async_loggers.push_back(logger);
+        google::base::SetLogger(severities[i], logger);
+    }
+    atexit(FlushAsyncLog);
+    google::InstallFailureWriter(WriteFailure);
+}
+
+LogRateLimiter::LogRateLimiter(int64_t interval_ms) :
+    interval_us_(interval_ms * 1000),
+    next_time_(0),
+    suppressed_(0) {
+}
+
+bool LogRateLimiter::Allow() {
+    int64_t now = baidu::common::timer::get_micros();
+    int64_t next_time = next_time_;
+    if (now >= next_time
+            && __sync_bool_compare_and_swap(&next_time_, next_time, now + interval_us_)) {
+        return true;
+    }
+    __sync_fetch_and_add(&suppressed_, 1);
+    return false;
+}
+
+int64_t LogRateLimiter::TakeSuppressed() {
+    return __sync_lock_test_and_set(&suppressed_, 0);
+}
+
+std::ostream& operator<<(std::ostream& os, LogRateLimiter& limiter) {
+    int64_t suppressed = limiter.TakeSuppressed();
+    if (suppressed > 0) {
+        os << "[" << suppressed << " suppressed] ";
+    }
+    return os;
+}
+
+} //namespace galaxy
+} //namespace baidu
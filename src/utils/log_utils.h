@@ -0,0 +1,92 @@
+// Copyright (c) 2016, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#include <ostream>
+#include <string>
+
+#include <glog/logging.h>
+#include <google/protobuf/message.h>
+#include <mutex.h>
+#include <thread_pool.h>
+
+namespace baidu {
+namespace galaxy {
+
+// Takes the disk writes of a glog log file off the logging threads. Lines
+// are appended to a buffer and written by a flusher thread, lines glog asks
+// to flush (WARNING and above by default) drain the buffer at once.
+class AsyncLogger : public google::base::Logger {
+public:
+    explicit AsyncLogger(google::base::Logger* base);
+    virtual ~AsyncLogger();
+
+    virtual void Write(bool force_flush, time_t timestamp, const char* message, int message_len);
+    virtual void Flush();
+    virtual google::uint32 LogSize();
+    // for the failure writer, the crashed thread may hold the locks
+    void DrainUnsafe();
+
+private:
+    void FlushRoutine();
+    void Drain();
+
+    google::base::Logger* base_;
+    Mutex mutex_;
+    std::string buffer_;
+    time_t timestamp_;
+    int64_t dropped_;
+    // serializes writes to base_
+    Mutex write_mutex_;
+    ThreadPool flush_pool_;
+};
+
+// wraps the glog file loggers of INFO and WARNING with AsyncLogger, the
+// buffered lines are written out on exit() and on a failure signal
+void SetupAsyncLog();
+
+// Lets one line of a call site through per interval, and counts the rest.
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(int64_t interval_ms);
+    bool Allow();
+    // suppressed since the last line let through, and resets the count
+    int64_t TakeSuppressed();
+
+private:
+    int64_t interval_us_;
+    volatile int64_t next_time_;
+    volatile int64_t suppressed_;
+};
+
+std::ostream& operator<<(std::ostream& os, LogRateLimiter& limiter);
+
+// One line dump of a message, built only when the line is really logged,
+// eg: VLOG(10) << ProtoDump(*request);
+class ProtoDump {
+public:
+    explicit ProtoDump(const google::protobuf::Message& message) : message_(message) {}
+    const google::protobuf::Message& message_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const ProtoDump& dump) {
+    return os << dump.message_.ShortDebugString();
+}
+
+} //namespace galaxy
+} //namespace baidu
+
+#define GALAXY_LOG_CONCAT_INNER(a, b) a##b
+#define GALAXY_LOG_CONCAT(a, b) GALAXY_LOG_CONCAT_INNER(a, b)
+
+// At most one line per ms of a call site, prefixed with the lines dropped
+// since the last one. It expands to more than one statement, so keep it out
+// of an unbraced if/else, the same as LOG_EVERY_N.
+#define LOG_EVERY_MS(severity, ms) \
+    static ::baidu::galaxy::LogRateLimiter GALAXY_LOG_CONCAT(galaxy_log_limiter_, __LINE__)(ms); \
+    if (GALAXY_LOG_CONCAT(galaxy_log_limiter_, __LINE__).Allow()) \
+        LOG(severity) << GALAXY_LOG_CONCAT(galaxy_log_limiter_, __LINE__)
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 #include "setting_utils.h"
+#include "log_utils.h"
 
 #include <glog/logging.h>
 
@@ -30,6 +31,7 @@ void SetupLog(const std::string& name) {
     google::SetLogSymlink(google::ERROR, "");
     google::SetLogSymlink(google::FATAL, "");
     google::InstallFailureSignalHandler();
+    SetupAsyncLog();
 }
 
 } //namespace galaxy